@@ -0,0 +1,554 @@
+#include "async_client.h"
+#include "logging.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const int MAX_EVENTS = 64;
+const int SWEEP_INTERVAL_MS = 50;   // точность сроков ожидания
+const size_t READ_CHUNK = 64 * 1024;
+
+} // namespace
+
+AsyncClient::AsyncClient() : AsyncClient(Options()) {}
+
+AsyncClient::AsyncClient(const Options& options) : options_(options) {
+    options_.connections_per_host = std::max<size_t>(1, options_.connections_per_host);
+    options_.max_in_flight = std::max<size_t>(1, options_.max_in_flight);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || event_fd_ < 0) {
+        LOG_ERROR("Failed to create client event loop: " + std::string(strerror(errno)));
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+        if (event_fd_ >= 0) close(event_fd_);
+        throw std::runtime_error("Failed to create client event loop");
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0;   // 0 — eventfd, иначе номер соединения
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev);
+
+    thread_ = std::thread(&AsyncClient::run, this);
+}
+
+AsyncClient::~AsyncClient() {
+    stopping_.store(true);
+    uint64_t one = 1;
+    if (write(event_fd_, &one, sizeof(one)) < 0) {
+        LOG_ERROR("Failed to wake up client thread");
+    }
+    thread_.join();
+    close(event_fd_);
+    close(epoll_fd_);
+}
+
+void AsyncClient::send(const std::string& host, int port, FrameType type,
+                       const std::string& payload, uint32_t flags, Callback callback) {
+    if (type != FRAME_TEXT && type != FRAME_GEO && type != FRAME_STATS) {
+        throw std::invalid_argument("Unsupported request type for AsyncClient");
+    }
+    Request request{host, port, type, flags, payload, std::move(callback),
+                    nowMs() + static_cast<uint64_t>(options_.request_timeout_ms)};
+    bool accepted = false;
+    {
+        // Проверка под тем же мьютексом, что и сбор в failAll: запрос либо
+        // попадает в последний сбор, либо видит остановку и не ставится.
+        // Сигнал тоже под мьютексом — деструктор не закроет eventfd раньше
+        std::lock_guard<std::mutex> lock(submissions_mutex_);
+        if (!stopping_.load()) {
+            submissions_.push_back(std::move(request));
+            accepted = true;
+            uint64_t one = 1;
+            if (write(event_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+                LOG_ERROR("Failed to signal client thread: " + std::string(strerror(errno)));
+            }
+        }
+    }
+    if (!accepted) {
+        fail(request.callback, "client stopped");
+    }
+}
+
+std::future<AsyncClient::Response> AsyncClient::send(const std::string& host, int port,
+                                                     FrameType type, const std::string& payload,
+                                                     uint32_t flags) {
+    auto promise = std::make_shared<std::promise<Response>>();
+    std::future<Response> result = promise->get_future();
+    send(host, port, type, payload, flags, [promise](Response response) {
+        promise->set_value(std::move(response));
+    });
+    return result;
+}
+
+void AsyncClient::run() {
+    epoll_event events[MAX_EVENTS];
+    uint64_t next_sweep = nowMs() + SWEEP_INTERVAL_MS;
+
+    while (!stopping_.load()) {
+        int n = epoll_wait(epoll_fd_, events, MAX_EVENTS, SWEEP_INTERVAL_MS);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("epoll_wait failed: " + std::string(strerror(errno)));
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u64 == 0) {
+                uint64_t counter;
+                while (read(event_fd_, &counter, sizeof(counter)) > 0) {}
+                drainSubmissions();
+                continue;
+            }
+            // Соединение могло закрыться при обработке предыдущих событий,
+            // а его дескриптор — достаться новому; номера не повторяются
+            auto it = connections_.find(events[i].data.u64);
+            if (it == connections_.end()) continue;
+            handleEvent(*it->second, events[i].events);
+        }
+
+        const uint64_t now = nowMs();
+        if (now >= next_sweep) {
+            expire(now);
+            next_sweep = now + SWEEP_INTERVAL_MS;
+        }
+    }
+    // Цикл мог выйти и по ошибке epoll — новые запросы больше не принимаются
+    stopping_.store(true);
+    failAll("client stopped");
+}
+
+void AsyncClient::drainSubmissions() {
+    std::vector<Request> ready;
+    {
+        std::lock_guard<std::mutex> lock(submissions_mutex_);
+        ready.swap(submissions_);
+    }
+    for (Request& request : ready) {
+        dispatch(std::move(request));
+    }
+}
+
+void AsyncClient::dispatch(Request request) {
+    const std::string key = request.host + ":" + std::to_string(request.port);
+    std::unique_ptr<Pool>& pool = pools_[key];
+    if (!pool) {
+        pool.reset(new Pool);
+        pool->host = request.host;
+        pool->port = request.port;
+    }
+
+    // Очередь пула не обгоняется: новые запросы встают за ожидающими
+    if (!pool->waiting.empty()) {
+        pool->waiting.push_back(std::move(request));
+        return;
+    }
+    Connection* conn = nullptr;
+    try {
+        conn = pickConnection(*pool);
+    } catch (const std::exception& e) {
+        fail(request.callback, e.what());
+        return;
+    }
+    if (!conn) {
+        pool->waiting.push_back(std::move(request));
+        return;
+    }
+    enqueue(*conn, std::move(request));
+}
+
+AsyncClient::Connection* AsyncClient::pickConnection(Pool& pool) {
+    Connection* best = nullptr;
+    for (auto& conn : pool.connections) {
+        if (!best || conn->pending.size() < best->pending.size()) {
+            best = conn.get();
+        }
+    }
+    // Простаивающих нет, а пул не полон — ещё одно соединение
+    if ((!best || !best->pending.empty()) &&
+        pool.connections.size() < options_.connections_per_host) {
+        try {
+            return openConnection(pool);
+        } catch (const std::exception&) {
+            if (!best) throw;
+        }
+    }
+    if (best && best->pending.size() >= options_.max_in_flight) {
+        return nullptr;
+    }
+    return best;
+}
+
+AsyncClient::Connection* AsyncClient::openConnection(Pool& pool) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    // Имя разрешается синхронно, в потоке клиента: только при открытии соединения
+    int rc = getaddrinfo(pool.host.c_str(), std::to_string(pool.port).c_str(), &hints, &result);
+    if (rc != 0) {
+        LOG_ERROR("Cannot resolve " + pool.host + ": " + gai_strerror(rc));
+        throw std::runtime_error("Cannot resolve " + pool.host + ": " + gai_strerror(rc));
+    }
+
+    std::deque<Address> addresses;
+    for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+        Address address{};
+        address.family = ai->ai_family;
+        address.socktype = ai->ai_socktype;
+        address.protocol = ai->ai_protocol;
+        std::memcpy(&address.addr, ai->ai_addr, ai->ai_addrlen);
+        address.length = ai->ai_addrlen;
+        addresses.push_back(address);
+    }
+    freeaddrinfo(result);
+
+    bool connected = false;
+    const int fd = connectNext(addresses, connected);
+    if (fd < 0) {
+        const std::string error = "Connection to " + pool.host + ":" + std::to_string(pool.port) +
+                                  " failed: " + strerror(errno);
+        LOG_ERROR(error);
+        throw std::runtime_error(error);
+    }
+
+    std::unique_ptr<Connection> conn(new Connection);
+    conn->id = next_connection_id_++;
+    conn->fd = fd;
+    conn->pool = &pool;
+    conn->connected = connected;
+    conn->connect_deadline = nowMs() + static_cast<uint64_t>(options_.connect_timeout_ms);
+    conn->want_write = !connected;
+    if (!connected) {
+        conn->fallback = std::move(addresses);
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (connected ? 0u : static_cast<uint32_t>(EPOLLOUT));
+    ev.data.u64 = conn->id;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        close(fd);
+        LOG_ERROR("epoll_ctl(ADD) failed: " + std::string(strerror(errno)));
+        throw std::runtime_error("epoll_ctl(ADD) failed");
+    }
+
+    LOG_DEBUG("Opened connection to " + pool.host + ":" + std::to_string(pool.port));
+    Connection* raw = conn.get();
+    connections_[raw->id] = raw;
+    pool.connections.push_back(std::move(conn));
+    return raw;
+}
+
+int AsyncClient::connectNext(std::deque<Address>& addresses, bool& connected) {
+    while (!addresses.empty()) {
+        const Address address = addresses.front();
+        addresses.pop_front();
+
+        int fd = socket(address.family, address.socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        address.protocol);
+        if (fd < 0) continue;
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&address.addr), address.length) == 0) {
+            connected = true;
+        } else if (errno == EINPROGRESS) {
+            connected = false;
+        } else {
+            const int error = errno;
+            close(fd);
+            errno = error;
+            continue;
+        }
+
+        // Запросы маленькие и идут конвейером: Nagle задерживал бы их до ACK
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+    }
+    return -1;
+}
+
+bool AsyncClient::reconnect(Connection& conn) {
+    bool connected = false;
+    const int fd = connectNext(conn.fallback, connected);
+    if (fd < 0) {
+        return false;
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+    close(conn.fd);
+    conn.fd = fd;
+    conn.connect_deadline = nowMs() + static_cast<uint64_t>(options_.connect_timeout_ms);
+
+    // Готовность подключения, даже мгновенного, подтверждает EPOLLOUT в handleEvent
+    conn.want_write = true;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLOUT;
+    ev.data.u64 = conn.id;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG_ERROR("epoll_ctl(ADD) failed: " + std::string(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+void AsyncClient::enqueue(Connection& conn, Request request) {
+    FrameHeader header;
+    header.type = request.type;
+    header.request_id = conn.next_id++;
+    header.flags = request.flags;
+
+    const size_t offset = beginFrame(conn.output);
+    conn.output.append(request.payload);
+    finishFrame(conn.output, offset, header);
+    conn.pending[header.request_id] = Pending{std::move(request.callback), request.deadline};
+
+    if (conn.connected && !conn.want_write && !flush(conn)) {
+        closeConnection(conn, "Failed to send request");
+    }
+}
+
+void AsyncClient::handleEvent(Connection& conn, uint32_t events) {
+    if (!conn.connected) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+            const std::string reason = "Connection to " + conn.pool->host + ":" +
+                                       std::to_string(conn.pool->port) + " failed: " + strerror(error);
+            if (!conn.fallback.empty()) {
+                LOG_DEBUG(reason + ", trying next address");
+                if (reconnect(conn)) return;
+            }
+            closeConnection(conn, reason);
+            return;
+        }
+        if (!(events & EPOLLOUT)) return;
+        conn.connected = true;
+        conn.fallback.clear();
+    }
+
+    // Ответы освобождают место ожидающим запросам, и отправка им может
+    // закрыть любое соединение пула, включая это
+    const uint64_t id = conn.id;
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        if (!receive(conn) || connections_.find(id) == connections_.end()) return;
+    }
+    if ((events & EPOLLOUT) || conn.want_write) {
+        if (!flush(conn)) {
+            closeConnection(conn, "Failed to send request");
+        }
+    }
+}
+
+bool AsyncClient::flush(Connection& conn) {
+    while (conn.output_offset < conn.output.size()) {
+        ssize_t n = ::send(conn.fd, conn.output.data() + conn.output_offset,
+                           conn.output.size() - conn.output_offset, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.output_offset += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            updateEvents(conn);
+            return true;
+        }
+        return false;
+    }
+    conn.output.clear();
+    conn.output_offset = 0;
+    updateEvents(conn);
+    return true;
+}
+
+bool AsyncClient::receive(Connection& conn) {
+    char buffer[READ_CHUNK];
+    bool closed = false;
+    while (true) {
+        ssize_t n = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            conn.decoder.feed(buffer, static_cast<size_t>(n));
+            if (static_cast<size_t>(n) < sizeof(buffer)) break;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closed = true;
+        break;
+    }
+
+    // Ответы, пришедшие до закрытия, отдаются до ошибки соединения
+    Pool& pool = *conn.pool;
+    FrameHeader header;
+    std::string payload;
+    try {
+        while (conn.decoder.next(header, payload)) {
+            auto it = conn.pending.find(header.request_id);
+            if (it == conn.pending.end()) {
+                continue;   // срок ожидания истёк раньше ответа
+            }
+            Callback callback = std::move(it->second.callback);
+            conn.pending.erase(it);
+
+            Response response;
+            response.status = header.status;
+            response.flags = header.flags;
+            response.data.swap(payload);
+            try {
+                callback(std::move(response));
+            } catch (const std::exception& e) {
+                LOG_ERROR("Response handler failed: " + std::string(e.what()));
+            }
+        }
+    } catch (const ProtocolException& e) {
+        closeConnection(conn, e.what());
+        return false;
+    }
+    if (closed) {
+        closeConnection(conn, "Connection closed by server");
+        return false;
+    }
+    dispatchWaiting(pool);
+    return true;
+}
+
+void AsyncClient::updateEvents(Connection& conn) {
+    const bool want_write = conn.output_offset < conn.output.size();
+    if (want_write == conn.want_write) return;
+    conn.want_write = want_write;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (want_write ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.u64 = conn.id;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+void AsyncClient::closeConnection(Connection& conn, const std::string& reason) {
+    LOG_WARNING("Closing client connection: " + reason);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+    close(conn.fd);
+    connections_.erase(conn.id);
+
+    // Соединение убирается из пула до вызова обработчиков: из них
+    // могут прийти новые запросы к тому же адресу
+    Pool& pool = *conn.pool;
+    std::unordered_map<uint32_t, Pending> pending;
+    pending.swap(conn.pending);
+    auto it = std::find_if(pool.connections.begin(), pool.connections.end(),
+                           [&conn](const std::unique_ptr<Connection>& c) { return c.get() == &conn; });
+    std::unique_ptr<Connection> owned = std::move(*it);
+    pool.connections.erase(it);
+
+    for (auto& entry : pending) {
+        fail(entry.second.callback, reason);
+    }
+    dispatchWaiting(pool);
+}
+
+void AsyncClient::dispatchWaiting(Pool& pool) {
+    while (!pool.waiting.empty()) {
+        Connection* conn = nullptr;
+        try {
+            conn = pickConnection(pool);
+        } catch (const std::exception& e) {
+            // Адрес недоступен: ожидающим больше некуда уйти
+            std::deque<Request> waiting;
+            waiting.swap(pool.waiting);
+            for (Request& request : waiting) {
+                fail(request.callback, e.what());
+            }
+            return;
+        }
+        if (!conn) return;
+        Request request = std::move(pool.waiting.front());
+        pool.waiting.pop_front();
+        enqueue(*conn, std::move(request));
+    }
+}
+
+void AsyncClient::expire(uint64_t now) {
+    std::vector<Connection*> stalled;
+    for (auto& entry : pools_) {
+        Pool& pool = *entry.second;
+        while (!pool.waiting.empty() && pool.waiting.front().deadline <= now) {
+            fail(pool.waiting.front().callback, "Request timed out");
+            pool.waiting.pop_front();
+        }
+        for (auto& conn : pool.connections) {
+            if (!conn->connected && conn->connect_deadline <= now) {
+                stalled.push_back(conn.get());
+                continue;
+            }
+            for (auto it = conn->pending.begin(); it != conn->pending.end();) {
+                if (it->second.deadline <= now) {
+                    Callback callback = std::move(it->second.callback);
+                    it = conn->pending.erase(it);
+                    fail(callback, "Request timed out");
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+    for (Connection* conn : stalled) {
+        if (!conn->fallback.empty() && reconnect(*conn)) continue;
+        closeConnection(*conn, "Connection to " + conn->pool->host + ":" +
+                               std::to_string(conn->pool->port) + " timed out");
+    }
+}
+
+void AsyncClient::failAll(const std::string& reason) {
+    // Обработчики могут отправлять новые запросы — собираем, пока не опустеет
+    while (true) {
+        std::vector<Request> submitted;
+        {
+            std::lock_guard<std::mutex> lock(submissions_mutex_);
+            submitted.swap(submissions_);
+        }
+        if (submitted.empty()) break;
+        for (Request& request : submitted) {
+            fail(request.callback, reason);
+        }
+    }
+    for (auto& entry : pools_) {
+        Pool& pool = *entry.second;
+        for (Request& request : pool.waiting) {
+            fail(request.callback, reason);
+        }
+        pool.waiting.clear();
+        for (auto& conn : pool.connections) {
+            for (auto& pending : conn->pending) {
+                fail(pending.second.callback, reason);
+            }
+            conn->pending.clear();
+            close(conn->fd);
+        }
+        pool.connections.clear();
+    }
+    connections_.clear();
+    pools_.clear();
+}
+
+void AsyncClient::fail(Callback& callback, const std::string& reason) {
+    Response response;
+    response.status = STATUS_ERROR;
+    response.data = reason;
+    try {
+        callback(std::move(response));
+    } catch (const std::exception& e) {
+        LOG_ERROR("Response handler failed: " + std::string(e.what()));
+    }
+}
+
+uint64_t AsyncClient::nowMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
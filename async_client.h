@@ -0,0 +1,174 @@
+#ifndef ASYNC_CLIENT_H
+#define ASYNC_CLIENT_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include "protocol.h"
+
+/**
+ * Асинхронный клиент бинарного протокола без Qt и без блокирующих вызовов
+ * в потоке вызывающего.
+ *
+ * Собственный поток ввода-вывода на epoll держит пул постоянных соединений
+ * на каждый адрес host:port. Запрос уходит в соединение с наименьшим числом
+ * ответов в ожидании; новое соединение открывается, пока пул не достиг
+ * connections_per_host, а на каждом соединении в полёте может быть до
+ * max_in_flight запросов (конвейер). Сверх этого запросы ждут в очереди
+ * пула. Имя может разрешаться в несколько адресов (например, ::1 и
+ * 127.0.0.1 для localhost): если подключение к одному не удалось или не
+ * успело за connect_timeout_ms, пробуется следующий. Ответы собираются из любого числа порций чтения (FrameDecoder)
+ * и сопоставляются с запросами по request_id.
+ *
+ * Обработчики вызываются в потоке клиента: они не должны блокироваться,
+ * а долгую работу или обращение к GUI передают в свой поток. Из
+ * обработчика можно отправлять новые запросы.
+ *
+ * Ошибки транспорта (нет соединения, обрыв, истёк срок) приходят тем же
+ * путём, что и ошибки сервера: ответом со статусом STATUS_ERROR и текстом
+ * в data. Повтор оставлен вызывающему — ответ STATUS_BUSY тоже.
+ * Пакетные запросы (FRAME_BATCH) с несколькими ответами не поддерживаются.
+ */
+class AsyncClient {
+public:
+    struct Options {
+        size_t connections_per_host = 4;
+        size_t max_in_flight = 128;       // запросов в полёте на соединение
+        int connect_timeout_ms = 5000;
+        int request_timeout_ms = 5000;    // от вызова send до ответа
+    };
+
+    struct Response {
+        uint8_t status = STATUS_ERROR;
+        uint32_t flags = 0;
+        std::string data;                 // изображение или текст ошибки
+
+        bool ok() const { return status == STATUS_OK; }
+    };
+
+    using Callback = std::function<void(Response)>;
+
+    AsyncClient();
+    explicit AsyncClient(const Options& options);
+
+    /**
+     * Останавливает поток; запросы без ответа завершаются ошибкой
+     * "client stopped" до возврата из деструктора
+     */
+    ~AsyncClient();
+
+    AsyncClient(const AsyncClient&) = delete;
+    AsyncClient& operator=(const AsyncClient&) = delete;
+
+    /**
+     * Ставит запрос в очередь и сразу возвращает управление
+     * @param type FRAME_TEXT, FRAME_GEO или FRAME_STATS
+     * @param flags Параметры изображения (encodeImageFlags)
+     * @param callback Вызывается ровно один раз в потоке клиента; после начала
+     *        остановки — сразу, в вызывающем потоке, с ошибкой "client stopped"
+     * @throws std::invalid_argument Для FRAME_BATCH и ответных типов
+     */
+    void send(const std::string& host, int port, FrameType type, const std::string& payload,
+              uint32_t flags, Callback callback);
+
+    /**
+     * То же с результатом через std::future
+     */
+    std::future<Response> send(const std::string& host, int port, FrameType type,
+                               const std::string& payload, uint32_t flags = 0);
+
+private:
+    struct Request {
+        std::string host;
+        int port;
+        uint8_t type;
+        uint32_t flags;
+        std::string payload;
+        Callback callback;
+        uint64_t deadline;   // мс монотонных часов
+    };
+
+    struct Pending {
+        Callback callback;
+        uint64_t deadline;
+    };
+
+    // Адрес из getaddrinfo, сохранённый для следующих попыток подключения
+    struct Address {
+        int family;
+        int socktype;
+        int protocol;
+        sockaddr_storage addr;
+        socklen_t length;
+    };
+
+    struct Pool;
+
+    struct Connection {
+        uint64_t id = 0;
+        int fd = -1;
+        Pool* pool = nullptr;
+        bool connected = false;
+        bool want_write = false;
+        uint64_t connect_deadline = 0;
+        std::deque<Address> fallback;   // ещё не испробованные адреса, пока нет подключения
+        FrameDecoder decoder;
+        std::string output;
+        size_t output_offset = 0;
+        uint32_t next_id = 1;
+        std::unordered_map<uint32_t, Pending> pending;
+    };
+
+    struct Pool {
+        std::string host;
+        int port;
+        std::vector<std::unique_ptr<Connection>> connections;
+        std::deque<Request> waiting;
+    };
+
+    void run();
+    void drainSubmissions();
+    void dispatch(Request request);
+    Connection* pickConnection(Pool& pool);
+    Connection* openConnection(Pool& pool);
+    bool reconnect(Connection& conn);
+    void enqueue(Connection& conn, Request request);
+    void handleEvent(Connection& conn, uint32_t events);
+    bool flush(Connection& conn);
+    bool receive(Connection& conn);
+    void updateEvents(Connection& conn);
+    void closeConnection(Connection& conn, const std::string& reason);
+    void dispatchWaiting(Pool& pool);
+    void expire(uint64_t now);
+    void failAll(const std::string& reason);
+
+    static int connectNext(std::deque<Address>& addresses, bool& connected);
+    static void fail(Callback& callback, const std::string& reason);
+    static uint64_t nowMs();
+
+    Options options_;
+    int epoll_fd_ = -1;
+    int event_fd_ = -1;
+    std::atomic<bool> stopping_{false};
+
+    std::mutex submissions_mutex_;
+    std::vector<Request> submissions_;
+
+    // Только поток клиента
+    std::unordered_map<std::string, std::unique_ptr<Pool>> pools_;
+    std::unordered_map<uint64_t, Connection*> connections_;
+    uint64_t next_connection_id_ = 1;
+
+    std::thread thread_;
+};
+
+#endif // ASYNC_CLIENT_H
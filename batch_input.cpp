@@ -0,0 +1,328 @@
+#include "batch_input.h"
+#include "logging.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/**
+ * Разбор одной строки NDJSON: плоский объект, из значений нужны
+ * только строки и скаляры верхнего уровня
+ */
+class JsonCursor {
+public:
+    JsonCursor(const char* begin, const char* end, uint64_t line)
+        : p_(begin), end_(end), line_(line) {}
+
+    void skipSpace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r')) p_++;
+    }
+
+    bool atEnd() const { return p_ >= end_; }
+    char peek() const { return p_ < end_ ? *p_ : '\0'; }
+
+    void expect(char c) {
+        skipSpace();
+        if (peek() != c) fail(std::string("expected '") + c + "'");
+        p_++;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (peek() != c) return false;
+        p_++;
+        return true;
+    }
+
+    void parseString(std::string& out) {
+        out.clear();
+        expect('"');
+        while (true) {
+            const char* start = p_;
+            while (p_ < end_ && *p_ != '"' && *p_ != '\\') p_++;
+            out.append(start, p_);
+            if (p_ >= end_) fail("unterminated string");
+            if (*p_++ == '"') return;
+            if (p_ >= end_) fail("unterminated escape");
+            switch (*p_++) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': appendCodePoint(out); break;
+                default: fail("bad escape");
+            }
+        }
+    }
+
+    // Число, true, false или null — как текст
+    void parseScalar(std::string& out) {
+        skipSpace();
+        const char* start = p_;
+        while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && *p_ != ' ' && *p_ != '\t' &&
+               *p_ != '\r') {
+            p_++;
+        }
+        if (p_ == start) fail("expected value");
+        out.assign(start, p_);
+        if (out == "null") out.clear();
+    }
+
+    void skipValue() {
+        skipSpace();
+        std::string scratch;
+        if (peek() == '"') {
+            parseString(scratch);
+        } else if (peek() == '{' || peek() == '[') {
+            int depth = 0;
+            do {
+                if (p_ >= end_) fail("unterminated value");
+                if (*p_ == '"') {
+                    parseString(scratch);
+                    continue;
+                }
+                if (*p_ == '{' || *p_ == '[') depth++;
+                if (*p_ == '}' || *p_ == ']') depth--;
+                p_++;
+            } while (depth > 0);
+        } else {
+            parseScalar(scratch);
+        }
+    }
+
+    [[noreturn]] void fail(const std::string& msg) const {
+        throw BatchInputException(line_, msg);
+    }
+
+private:
+    uint32_t parseHex4() {
+        if (end_ - p_ < 4) fail("short \\u escape");
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) {
+            const char c = *p_++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else fail("bad \\u escape");
+        }
+        return value;
+    }
+
+    void appendCodePoint(std::string& out) {
+        uint32_t cp = parseHex4();
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+            if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u') fail("unpaired surrogate");
+            p_ += 2;
+            const uint32_t low = parseHex4();
+            if (low < 0xDC00 || low > 0xDFFF) fail("unpaired surrogate");
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        }
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    const char* p_;
+    const char* end_;
+    uint64_t line_;
+};
+
+} // namespace
+
+BatchInput::BatchInput(const std::string& path, Format format, bool skip_header)
+    : format_(format) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open batch input " + path + ": " + strerror(errno));
+        throw std::runtime_error("Failed to open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to stat " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            LOG_ERROR("Failed to map batch input " + path + ": " + strerror(errno));
+            throw std::runtime_error("Failed to map " + path);
+        }
+        // Файл читается один раз от начала до конца
+        madvise(mapped, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(mapped);
+    }
+    close(fd);
+
+    if (skip_header && size_ > 0) {
+        const void* newline = memchr(data_, '\n', size_);
+        position_ = newline ? static_cast<const char*>(newline) - data_ + 1 : size_;
+        line_ = 1;
+    }
+}
+
+BatchInput::~BatchInput() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+bool BatchInput::next(BatchRecord& record) {
+    while (position_ < size_) {
+        const char* begin = data_ + position_;
+        const void* newline = memchr(begin, '\n', size_ - position_);
+        const char* line_end = newline ? static_cast<const char*>(newline) : data_ + size_;
+        line_++;
+
+        // Пустые строки (в том числе из одного \r) не считаются записями
+        if (line_end == begin || (line_end == begin + 1 && *begin == '\r')) {
+            position_ = line_end - data_ + (newline ? 1 : 0);
+            continue;
+        }
+
+        record.number = records_++;
+        record.name.clear();
+        record.content.clear();
+        if (format_ == FORMAT_NDJSON) {
+            position_ = line_end - data_ + (newline ? 1 : 0);
+            parseNdjson(begin, line_end, record);
+        } else {
+            parseCsv(record);
+        }
+        return true;
+    }
+    return false;
+}
+
+void BatchInput::parseCsv(BatchRecord& record) {
+    const uint64_t start_line = line_;
+    std::string fields[2];
+    std::string extra;
+    size_t field = 0;
+
+    // При ошибке разбор продолжается со следующей строки
+    auto fail = [&](const std::string& msg) {
+        const void* newline = memchr(data_ + position_, '\n', size_ - position_);
+        position_ = newline ? static_cast<const char*>(newline) - data_ + 1 : size_;
+        throw BatchInputException(start_line, msg);
+    };
+
+    while (true) {
+        std::string& out = field < 2 ? fields[field] : extra;
+        if (position_ < size_ && data_[position_] == '"') {
+            position_++;
+            while (true) {
+                if (position_ >= size_) fail("unterminated quoted field");
+                const char c = data_[position_];
+                if (c == '"') {
+                    if (position_ + 1 < size_ && data_[position_ + 1] == '"') {
+                        out.push_back('"');
+                        position_ += 2;
+                        continue;
+                    }
+                    position_++;
+                    break;
+                }
+                if (c == '\n') line_++;
+                out.push_back(c);
+                position_++;
+            }
+            if (position_ < size_ && data_[position_] == '\r') position_++;
+            if (position_ < size_ && data_[position_] != ',' && data_[position_] != '\n') {
+                fail("unexpected character after closing quote");
+            }
+        } else {
+            const size_t start = position_;
+            while (position_ < size_ && data_[position_] != ',' && data_[position_] != '\n') {
+                position_++;
+            }
+            size_t stop = position_;
+            if (stop > start && data_[stop - 1] == '\r' &&
+                (position_ >= size_ || data_[position_] == '\n')) {
+                stop--;
+            }
+            out.assign(data_ + start, stop - start);
+        }
+
+        if (position_ < size_ && data_[position_] == ',') {
+            position_++;
+            field++;
+            continue;
+        }
+        if (position_ < size_) position_++;   // '\n'
+        break;
+    }
+
+    if (field == 0) {
+        record.content.swap(fields[0]);
+    } else {
+        record.name.swap(fields[0]);
+        record.content.swap(fields[1]);
+    }
+}
+
+void BatchInput::parseNdjson(const char* begin, const char* end, BatchRecord& record) {
+    JsonCursor json(begin, end, line_);
+    std::string key;
+    bool has_data = false;
+
+    json.expect('{');
+    if (!json.consume('}')) {
+        do {
+            json.skipSpace();
+            json.parseString(key);
+            json.expect(':');
+            json.skipSpace();
+            if (key == "id") {
+                if (json.peek() == '"') json.parseString(record.name);
+                else json.parseScalar(record.name);
+            } else if (key == "data") {
+                if (json.peek() != '"') json.fail("\"data\" must be a string");
+                json.parseString(record.content);
+                has_data = true;
+            } else {
+                json.skipValue();
+            }
+        } while (json.consume(','));
+        json.expect('}');
+    }
+    json.skipSpace();
+    if (!json.atEnd()) json.fail("trailing characters after object");
+    if (!has_data) json.fail("missing \"data\"");
+}
+
+BatchInput::Format BatchInput::parseFormat(const std::string& name) {
+    if (name == "csv") return FORMAT_CSV;
+    if (name == "ndjson" || name == "jsonl") return FORMAT_NDJSON;
+    throw std::runtime_error("Unknown input format: " + name);
+}
+
+BatchInput::Format BatchInput::formatForPath(const std::string& path) {
+    auto endsWith = [&path](const std::string& suffix) {
+        return path.size() >= suffix.size() &&
+               path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return endsWith(".ndjson") || endsWith(".jsonl") ? FORMAT_NDJSON : FORMAT_CSV;
+}
@@ -0,0 +1,87 @@
+#ifndef BATCH_INPUT_H
+#define BATCH_INPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Запись входных данных пакетной генерации
+ */
+struct BatchRecord {
+    uint64_t number = 0;   // порядковый номер во входе, с 0
+    std::string name;      // идентификатор записи; пустой — используется номер
+    std::string content;   // данные для кодирования
+};
+
+class BatchInputException : public std::runtime_error {
+public:
+    BatchInputException(uint64_t line, const std::string& msg)
+        : std::runtime_error("line " + std::to_string(line) + ": " + msg) {}
+};
+
+/**
+ * Входной файл qr_batch, отображённый в память целиком (mmap), и его
+ * разбор по записям без чтения в промежуточные буферы.
+ *
+ * CSV: поля "имя,данные", кавычки и "" внутри них — по RFC 4180
+ * (данные в кавычках могут содержать запятые и переводы строк).
+ * Запись из одного поля — только данные.
+ *
+ * NDJSON: по объекту на строку, {"id": "...", "data": "..."};
+ * id может быть числом или отсутствовать, прочие поля пропускаются.
+ */
+class BatchInput {
+public:
+    enum Format {
+        FORMAT_CSV,
+        FORMAT_NDJSON
+    };
+
+    /**
+     * @param path Входной файл
+     * @param format Формат записей
+     * @param skip_header Пропустить первую строку (заголовок CSV)
+     * @throws std::runtime_error Если файл не открывается
+     */
+    BatchInput(const std::string& path, Format format, bool skip_header = false);
+    ~BatchInput();
+
+    BatchInput(const BatchInput&) = delete;
+    BatchInput& operator=(const BatchInput&) = delete;
+
+    /**
+     * Читает следующую запись. Пустые строки пропускаются.
+     * @return false, если записи кончились
+     * @throws BatchInputException При повреждённой записи; разбор
+     *         продолжается со следующей строки
+     */
+    bool next(BatchRecord& record);
+
+    size_t size() const { return size_; }
+    size_t position() const { return position_; }
+
+    /**
+     * Разбирает имя формата ("csv", "ndjson")
+     */
+    static Format parseFormat(const std::string& name);
+
+    /**
+     * Формат по расширению: .ndjson и .jsonl — NDJSON, остальное — CSV
+     */
+    static Format formatForPath(const std::string& path);
+
+private:
+    void parseCsv(BatchRecord& record);
+    void parseNdjson(const char* begin, const char* end, BatchRecord& record);
+
+    Format format_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t position_ = 0;
+    uint64_t line_ = 0;
+    uint64_t records_ = 0;
+};
+
+#endif // BATCH_INPUT_H
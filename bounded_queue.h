@@ -0,0 +1,113 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+
+/**
+ * Ограниченная MPMC-очередь: любое число производителей и потребителей.
+ * При переполнении производитель либо получает отказ (tryPush),
+ * либо ждёт освобождения места (push) — это и есть обратное давление.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity ? capacity : 1) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * Кладёт элемент, только если есть свободное место.
+     * Элемент перемещается лишь при успехе — при отказе он остаётся у вызывающего
+     * @return false, если очередь заполнена или закрыта
+     */
+    bool tryPush(T&& item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_ || items_.size() >= capacity_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * Кладёт элемент, ожидая свободного места не дольше timeout
+     * @return false, если место так и не освободилось или очередь закрыта
+     */
+    template <typename Rep, typename Period>
+    bool push(T item, std::chrono::duration<Rep, Period> timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!not_full_.wait_for(lock, timeout, [this] {
+                return closed_ || items_.size() < capacity_;
+            }) || closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * Кладёт элемент, ожидая свободного места сколько потребуется
+     * @return false, если очередь закрыта
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * Забирает элемент, блокируясь, пока очередь пуста
+     * @return false, если очередь закрыта и опустела
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+     * Закрывает очередь: новые элементы не принимаются,
+     * потребители дочитывают остаток и завершаются
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    const size_t capacity_;
+    bool closed_ = false;
+    std::deque<T> items_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+#endif // BOUNDED_QUEUE_H
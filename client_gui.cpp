@@ -1,4 +1,5 @@
 #include "client_gui.h"
+#include <QApplication>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFormLayout>
@@ -8,7 +9,7 @@
 #include <QDoubleValidator>
 #include <QDebug>
 
-ClientGUI::ClientGUI(QWidget *parent) : QMainWindow(parent) {
+ClientGUI::ClientGUI(QWidget *parent) : QMainWindow(parent), client(new AsyncClient) {
     Logger::getInstance().init("client.log");
     LOG_INFO("Starting QR Client GUI");
     setupUI();
@@ -16,6 +17,12 @@ ClientGUI::ClientGUI(QWidget *parent) : QMainWindow(parent) {
     resize(600, 400);
 }
 
+ClientGUI::~ClientGUI() {
+    // Незавершённые запросы получают "client stopped" здесь, до разрушения
+    // виджетов; их ответы уходят в очередь qApp и там находят окно удалённым
+    client.reset();
+}
+
 void ClientGUI::setupUI() {
     QWidget *centralWidget = new QWidget(this);
     QHBoxLayout *mainLayout = new QHBoxLayout(centralWidget);
@@ -80,11 +87,7 @@ void ClientGUI::generateTextQR() {
     }
     
     LOG_INFO("Generating text QR for: " + text.toStdString());
-    ClientThread *thread = new ClientThread("TEXT:" + text, this);
-    connect(thread, &ClientThread::resultReady, this, &ClientGUI::handleQRResponse);
-    connect(thread, &ClientThread::errorOccurred, this, &ClientGUI::handleError);
-    connect(thread, &ClientThread::finished, thread, &QObject::deleteLater);
-    thread->start();
+    requestQR(FRAME_TEXT, text);
 }
 
 void ClientGUI::generateGeoQR() {
@@ -114,30 +117,37 @@ void ClientGUI::generateGeoQR() {
     LOG_INFO("Generating geo QR for coordinates - lat: " + std::to_string(lat) + 
             ", lon: " + std::to_string(lon));
     
-    ClientThread *thread = new ClientThread(QString("GEO:%1,%2").arg(lat).arg(lon), this);
-    connect(thread, &ClientThread::resultReady, this, &ClientGUI::handleQRResponse);
-    connect(thread, &ClientThread::errorOccurred, this, &ClientGUI::handleError);
-    connect(thread, &ClientThread::finished, thread, &QObject::deleteLater);
-    thread->start();
+    requestQR(FRAME_GEO, QString("%1,%2").arg(lat).arg(lon));
+}
+
+void ClientGUI::requestQR(FrameType type, const QString& payload) {
+    // QPointer не потокобезопасен: поток клиента только переносит его
+    // в очередь qApp, а проверяется он уже в потоке окна
+    auto self = std::make_shared<QPointer<ClientGUI>>(this);
+    client->send("localhost", 8080, type, payload.toStdString(), 0,
+                 [self](AsyncClient::Response response) mutable {
+        const bool ok = response.ok();
+        QByteArray data = QByteArray::fromStdString(response.data);
+        QMetaObject::invokeMethod(qApp, [self = std::move(self), ok, data]() {
+            ClientGUI* window = self->data();
+            if (!window) return;
+            if (ok) {
+                window->handleQRResponse(data);
+            } else {
+                window->handleError(QString::fromUtf8(data));
+            }
+        }, Qt::QueuedConnection);
+    });
 }
 
 void ClientGUI::handleQRResponse(const QByteArray& response) {
-    if (response.startsWith("QRCODE:")) {
-        QByteArray imageData = response.mid(7);
-        QPixmap pixmap;
-        if (pixmap.loadFromData(imageData)) {
-            qrDisplay->setPixmap(pixmap.scaled(qrDisplay->size(), Qt::KeepAspectRatio));
-            LOG_DEBUG("QR code displayed successfully");
-        } else {
-            LOG_ERROR("Failed to load QR image from data");
-            showMessage("Failed to display QR code");
-        }
-    } else if (response.startsWith("ERROR:")) {
-        LOG_ERROR("Server error: " + response.mid(6).toStdString());
-        showMessage(response.mid(6));
+    QPixmap pixmap;
+    if (pixmap.loadFromData(response)) {
+        qrDisplay->setPixmap(pixmap.scaled(qrDisplay->size(), Qt::KeepAspectRatio));
+        LOG_DEBUG("QR code displayed successfully");
     } else {
-        LOG_ERROR("Invalid server response format");
-        showMessage("Invalid server response");
+        LOG_ERROR("Failed to load QR image from data");
+        showMessage("Failed to display QR code");
     }
 }
 
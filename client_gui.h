@@ -10,43 +10,18 @@
 #include <QDebug>
 #include <QTcpSocket>
 #include <QPixmap>
-#include <QThread>
+#include <QPointer>
+#include <memory>
 #include "/home/tanya/qr_project/common/include/logging.h"
 #include "/home/tanya/qr_project/common/include/network_utils.h"
-
-class ClientThread : public QThread {
-    Q_OBJECT
-public:
-    ClientThread(const QString& request, QObject* parent = nullptr)
-        : QThread(parent), request(request) {}
-    
-    void run() override {
-        try {
-            std::string response = NetworkUtils::sendRequest(
-                "localhost", 
-                8080, 
-                request.toStdString()
-            );
-            emit resultReady(QByteArray::fromStdString(response));
-        } catch (const NetworkException& e) {
-            LOG_ERROR(e.what());
-            emit errorOccurred(QString::fromStdString(e.what()));
-        }
-    }
-    
-signals:
-    void resultReady(const QByteArray& result);
-    void errorOccurred(const QString& error);
-    
-private:
-    QString request;
-};
+#include "/home/tanya/qr_project/common/include/async_client.h"
 
 class ClientGUI : public QMainWindow {
     Q_OBJECT
     
 public:
     ClientGUI(QWidget *parent = nullptr);
+    ~ClientGUI() override;
     
 private slots:
     void generateTextQR();
@@ -62,8 +37,13 @@ private:
     QPushButton *textButton;
     QPushButton *geoButton;
     
+    // Запросы идут через постоянные соединения клиента, без потока на запрос.
+    // Останавливается первым в деструкторе, пока окно ещё целое
+    std::unique_ptr<AsyncClient> client;
+
     void setupUI();
     void showMessage(const QString& message);
+    void requestQR(FrameType type, const QString& payload);
 };
 
 #endif // CLIENT_GUI_H
@@ -0,0 +1,48 @@
+#include "command_line.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+
+[[noreturn]] void invalidValue(const std::string& name, const std::string& value) {
+    throw std::invalid_argument("Invalid value for " + name + ": " + value);
+}
+
+} // namespace
+
+long long parseNumber(const std::string& name, const std::string& value,
+                      long long min, long long max) {
+    if (value.empty()) {
+        invalidValue(name, value);
+    }
+    char* end = nullptr;
+    errno = 0;
+    long long number = std::strtoll(value.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || number < min || number > max) {
+        invalidValue(name, value);
+    }
+    return number;
+}
+
+double parseDecimal(const std::string& name, const std::string& value, double min, double max) {
+    if (value.empty()) {
+        invalidValue(name, value);
+    }
+    char* end = nullptr;
+    errno = 0;
+    double number = std::strtod(value.c_str(), &end);
+    if (errno != 0 || *end != '\0' || !std::isfinite(number) || number < min || number > max) {
+        invalidValue(name, value);
+    }
+    return number;
+}
+
+bool parseChoice(const std::string& name, const std::string& value,
+                 const char* first, const char* second) {
+    if (value != first && value != second) {
+        invalidValue(name, value);
+    }
+    return value == second;
+}
@@ -0,0 +1,32 @@
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+#include <climits>
+#include <string>
+
+/**
+ * Разбор значений параметров командной строки сервера и qr_batch.
+ * Значение принимается только целиком и в заданных пределах; иначе
+ * бросается std::invalid_argument с именем параметра — вызывающий
+ * печатает его вместе со строкой использования.
+ */
+
+/**
+ * Целое число без хвоста ("12x" и "-1" для min = 0 — ошибка)
+ */
+long long parseNumber(const std::string& name, const std::string& value,
+                      long long min, long long max = LLONG_MAX);
+
+/**
+ * Конечное десятичное число без хвоста
+ */
+double parseDecimal(const std::string& name, const std::string& value, double min, double max);
+
+/**
+ * Одно из двух имён режима
+ * @return true для second, false для first
+ */
+bool parseChoice(const std::string& name, const std::string& value,
+                 const char* first, const char* second);
+
+#endif // COMMAND_LINE_H
@@ -0,0 +1,65 @@
+#ifndef GF256_H
+#define GF256_H
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Арифметика поля Галуа GF(256) с порождающим многочленом
+ * x^8 + x^4 + x^3 + x^2 + 1 (0x11D), как в ISO/IEC 18004.
+ * Таблицы логарифмов и степеней строятся на этапе компиляции.
+ */
+struct GF256 {
+    std::array<uint8_t, 512> exp{};   // удвоена, чтобы не брать остаток от 255
+    std::array<uint8_t, 256> log{};
+
+    constexpr GF256() {
+        unsigned value = 1;
+        for (int i = 0; i < 255; i++) {
+            exp[i] = static_cast<uint8_t>(value);
+            log[value] = static_cast<uint8_t>(i);
+            value <<= 1;
+            if (value & 0x100) value ^= 0x11D;
+        }
+        for (int i = 255; i < 512; i++) {
+            exp[i] = exp[i - 255];
+        }
+    }
+
+    constexpr uint8_t mul(uint8_t a, uint8_t b) const {
+        return (a == 0 || b == 0) ? 0 : exp[log[a] + log[b]];
+    }
+};
+
+inline constexpr GF256 gf256{};
+
+/**
+ * Порождающие многочлены Рида-Соломона для всех степеней, которые
+ * встречаются в QR-кодах (7..30 проверочных байт на блок).
+ * poly[n] — коэффициенты многочлена степени n без старшего (равного 1),
+ * от x^(n-1) до x^0.
+ */
+struct RSGenerators {
+    static constexpr int MAX_DEGREE = 30;
+    std::array<std::array<uint8_t, MAX_DEGREE>, MAX_DEGREE + 1> poly{};
+
+    constexpr RSGenerators() {
+        for (int degree = 1; degree <= MAX_DEGREE; degree++) {
+            std::array<uint8_t, MAX_DEGREE> result{};
+            result[degree - 1] = 1;
+            uint8_t root = 1;
+            for (int i = 0; i < degree; i++) {
+                for (int j = 0; j < degree; j++) {
+                    result[j] = gf256.mul(result[j], root);
+                    if (j + 1 < degree) result[j] ^= result[j + 1];
+                }
+                root = gf256.mul(root, 0x02);
+            }
+            poly[degree] = result;
+        }
+    }
+};
+
+inline constexpr RSGenerators rs_generators{};
+
+#endif // GF256_H
@@ -0,0 +1,113 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "logging.h"
+
+/**
+ * Бенчмарк журналирования на пути обработки запроса сервером.
+ * Повторяет вызовы LOG_* из process_request/parse_geo/QRGenerator и
+ * сравнивает прежнее поведение (сообщение строится всегда, а уровень
+ * проверяется потом) с фильтрацией до построения сообщения.
+ * Выводит число выделений памяти и время на один запрос.
+ */
+
+static std::atomic<uint64_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// Прежние макросы: строка собирается до любой проверки уровня
+#define EAGER_LOG(level, msg) \
+    do { \
+        std::string message_ = msg; \
+        if (Logger::isEnabled(level)) Logger::getInstance().log(level, std::move(message_)); \
+    } while (0)
+
+namespace {
+
+const std::string text_request = "TEXT:https://shop.example.com/products/sku-0042817?utm_source=qr";
+const std::string geo_request = "GEO:55.755800,37.617300";
+
+template <bool Eager>
+void serverPath(const std::string& request) {
+    if (Eager) {
+        EAGER_LOG(Logger::INFO, "Received request: " + request);
+    } else {
+        LOG_INFO("Received request: " + request);
+    }
+
+    if (request[0] == 'G') {
+        std::string lat_str = request.substr(4, 9);
+        std::string lon_str = request.substr(14);
+        double lat = 55.7558;
+        double lon = 37.6173;
+        if (Eager) {
+            EAGER_LOG(Logger::DEBUG, "Parsing coordinates: lat_str=" + lat_str + " lon_str=" + lon_str);
+            EAGER_LOG(Logger::DEBUG, "Parsed coordinates: lat=" + std::to_string(lat) +
+                                     " lon=" + std::to_string(lon));
+            EAGER_LOG(Logger::DEBUG, std::string("QR code content: ") + "geo:55.75580,37.61730?z=15");
+        } else {
+            LOG_DEBUG("Parsing coordinates: lat_str=" + lat_str + " lon_str=" + lon_str);
+            LOG_DEBUG("Parsed coordinates: lat=" + std::to_string(lat) +
+                      " lon=" + std::to_string(lon));
+            LOG_DEBUG(std::string("QR code content: ") + "geo:55.75580,37.61730?z=15");
+        }
+    }
+
+    if (Eager) {
+        EAGER_LOG(Logger::INFO, "Generating QR code for: " + request.substr(5));
+    } else {
+        LOG_INFO("Generating QR code for: " + request.substr(5));
+    }
+}
+
+template <bool Eager>
+void run(const char* name, Logger::LogLevel level, int iterations) {
+    Logger::setLevel(level);
+
+    uint64_t before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        serverPath<Eager>(i % 2 ? geo_request : text_request);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    uint64_t allocs = allocations.load() - before;
+
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    std::printf("%-8s %-8s %10.2f allocs/req %10.1f ns/req\n",
+                name, Eager ? "eager" : "filtered",
+                static_cast<double>(allocs) / iterations, ns);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    Logger::getInstance().init("/dev/null");
+
+    const struct {
+        const char* name;
+        Logger::LogLevel level;
+    } levels[] = {
+        {"debug", Logger::DEBUG},
+        {"info", Logger::INFO},
+        {"warning", Logger::WARNING},
+        {"error", Logger::ERROR},
+    };
+
+    for (const auto& l : levels) {
+        run<true>(l.name, l.level, iterations);
+        run<false>(l.name, l.level, iterations);
+    }
+    return 0;
+}
@@ -1,10 +1,92 @@
 #include "logging.h"
+#include <chrono>
+#include <vector>
+
+/**
+ * Ограниченная очередь записей журнала без блокировок (схема Вьюкова):
+ * много производителей, один потребитель — фоновый поток записи
+ */
+class LogRing {
+public:
+    struct Record {
+        std::time_t time;
+        Logger::LogLevel level;
+        std::string message;
+    };
+
+    explicit LogRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask_ = size - 1;
+        slots_.reset(new Slot[size]);
+        for (size_t i = 0; i < size; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(Record&& record) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & mask_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.record = std::move(record);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // буфер заполнен
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Потребитель один: фоновый поток, а после его остановки — stopAsync
+    bool tryPop(Record& record) {
+        Slot& slot = slots_[tail_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1) {
+            return false;
+        }
+        record = std::move(slot.record);
+        slot.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+        tail_++;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) size_t tail_ = 0;
+};
+
+namespace {
+
+const size_t WRITE_BATCH = 256;
+
+} // namespace
 
 Logger& Logger::getInstance() {
     static Logger instance;
     return instance;
 }
 
+Logger::LogLevel Logger::parseLevel(const std::string& name) {
+    if (name == "debug") return DEBUG;
+    if (name == "info") return INFO;
+    if (name == "warning") return WARNING;
+    if (name == "error") return ERROR;
+    throw std::runtime_error("Unknown log level: " + name);
+}
+
 void Logger::init(const std::string& filename) {
     std::lock_guard<std::mutex> lock(mutex_);
     if (filename.empty()) {
@@ -19,22 +101,138 @@ void Logger::init(const std::string& filename) {
     }
 }
 
-void Logger::log(LogLevel level, const std::string& message) {
-    std::lock_guard<std::mutex> lock(mutex_);
+void Logger::log(LogLevel level, std::string message) {
     auto now = std::time(nullptr);
-    auto tm = *std::localtime(&now);
 
-    file_ << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << " [";
+    // Счётчик производителей ставится до проверки async_: stopAsync ждёт,
+    // пока все, кто увидел асинхронный режим, закончат запись в буфер
+    producers_.fetch_add(1);
+    if (async_.load()) {
+        LogRing::Record record{now, level, std::move(message)};
+        bool pushed = ring_->tryPush(std::move(record));
+        if (!pushed && policy_ == DROP) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            producers_.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+        // BLOCK: ждём места, пока асинхронный режим не выключен
+        while (!pushed && async_.load(std::memory_order_relaxed)) {
+            std::this_thread::yield();
+            pushed = ring_->tryPush(std::move(record));
+        }
+        if (pushed) {
+            if (writer_waiting_.load(std::memory_order_relaxed)) {
+                wake_.notify_one();
+            }
+            producers_.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+        message = std::move(record.message);
+    }
+    producers_.fetch_sub(1, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    write(now, level, message);
+    file_.flush();
+}
+
+void Logger::write(std::time_t time, LogLevel level, const std::string& message) {
+    if (time != cached_time_) {
+        std::tm tm{};
+        localtime_r(&time, &tm);
+        std::strftime(cached_stamp_, sizeof(cached_stamp_), "%Y-%m-%d %H:%M:%S", &tm);
+        cached_time_ = time;
+    }
+
+    file_ << cached_stamp_ << " [";
     switch(level) {
         case DEBUG: file_ << "DEBUG"; break;
         case INFO: file_ << "INFO"; break;
         case WARNING: file_ << "WARNING"; break;
         case ERROR: file_ << "ERROR"; break;
     }
-    file_ << "] " << message << std::endl;
+    file_ << "] " << message << '\n';
+}
+
+void Logger::startAsync(size_t capacity, OverflowPolicy policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (async_) {
+        return;
+    }
+    if (!ring_) {
+        ring_.reset(new LogRing(capacity));
+    }
+    policy_ = policy;
+    writer_running_ = true;
+    writer_ = std::thread(&Logger::writerLoop, this);
+    async_.store(true, std::memory_order_release);
+}
+
+void Logger::stopAsync() {
+    if (!async_.exchange(false)) {
+        return;
+    }
+    // Производители, увидевшие async_ до переключения, дописывают в буфер;
+    // фоновый поток ещё работает и освобождает место для BLOCK
+    while (producers_.load() != 0) {
+        std::this_thread::yield();
+    }
+    writer_running_ = false;
+    wake_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    // Записи, положенные после последнего прохода фонового потока
+    std::lock_guard<std::mutex> lock(mutex_);
+    LogRing::Record record;
+    bool written = false;
+    while (ring_->tryPop(record)) {
+        write(record.time, record.level, record.message);
+        written = true;
+    }
+    if (written) {
+        file_.flush();
+    }
+}
+
+void Logger::writerLoop() {
+    LogRing::Record record;
+    while (true) {
+        size_t written = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (written < WRITE_BATCH && ring_->tryPop(record)) {
+                write(record.time, record.level, record.message);
+                written++;
+            }
+            uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+            if (dropped != reported_dropped_) {
+                write(std::time(nullptr), WARNING, "Log buffer overflow: " +
+                      std::to_string(dropped - reported_dropped_) + " records dropped");
+                reported_dropped_ = dropped;
+                written++;
+            }
+            if (written > 0) {
+                file_.flush();
+            }
+        }
+
+        if (written == 0) {
+            if (!writer_running_) {
+                break;
+            }
+            // Производители будят поток, только когда он действительно спит
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            writer_waiting_ = true;
+            wake_.wait_for(lock, std::chrono::milliseconds(50));
+            writer_waiting_ = false;
+        }
+    }
 }
 
 Logger::~Logger() {
+    stopAsync();
     if (file_.is_open()) {
         file_.close();
     }
@@ -8,6 +8,21 @@
 #include <iomanip>
 #include <ctime>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+/**
+ * Минимальный уровень, который вообще попадает в сборку.
+ * Вызовы ниже него вырезаются компилятором вместе с построением
+ * сообщения: -DLOG_COMPILE_LEVEL=1 убирает все LOG_DEBUG.
+ * 0 — DEBUG, 1 — INFO, 2 — WARNING, 3 — ERROR.
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+class LogRing;
 
 class Logger {
 public:
@@ -18,22 +33,96 @@ public:
         ERROR
     };
 
+    /**
+     * Поведение асинхронного режима при заполненном буфере
+     */
+    enum OverflowPolicy {
+        DROP,    // отбросить запись (и учесть в droppedCount)
+        BLOCK    // ждать, пока фоновый поток освободит место
+    };
+
     static Logger& getInstance();
     
     void init(const std::string& filename = "");
-    void log(LogLevel level, const std::string& message);
+
+    /**
+     * Сообщение принимается по значению: временная строка из LOG_* в
+     * асинхронном режиме переносится в буфер без копирования
+     */
+    void log(LogLevel level, std::string message);
+
+    /**
+     * Задаёт минимальный уровень записей во время работы
+     */
+    static void setLevel(LogLevel level) { min_level_.store(level, std::memory_order_relaxed); }
+    static LogLevel level() { return static_cast<LogLevel>(min_level_.load(std::memory_order_relaxed)); }
+
+    /**
+     * Проверка уровня до построения сообщения: одна загрузка и сравнение
+     */
+    static bool isEnabled(LogLevel level) {
+        return level >= LOG_COMPILE_LEVEL && level >= min_level_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Разбирает имя уровня ("debug", "info", "warning", "error")
+     */
+    static LogLevel parseLevel(const std::string& name);
+
+    /**
+     * Включает асинхронный режим: log() только кладёт запись в кольцевой
+     * буфер без блокировок, а форматирование и запись на диск выполняет
+     * фоновый поток пачками
+     * @param capacity Ёмкость буфера в записях (округляется до степени двойки)
+     * @param policy Что делать при заполненном буфере
+     */
+    void startAsync(size_t capacity = 8192, OverflowPolicy policy = DROP);
+
+    /**
+     * Дописывает накопленные записи и возвращает синхронный режим
+     */
+    void stopAsync();
+
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
 
 private:
     Logger() = default;
     ~Logger();
+
+    void write(std::time_t time, LogLevel level, const std::string& message);
+    void writerLoop();
     
+    static inline std::atomic<int> min_level_{DEBUG};
+
     std::ofstream file_;
     std::mutex mutex_;
+
+    // Кэш отформатированной метки времени: меняется раз в секунду
+    std::time_t cached_time_ = -1;
+    char cached_stamp_[32] = {0};
+
+    std::unique_ptr<LogRing> ring_;
+    std::atomic<bool> async_{false};
+    std::atomic<int> producers_{0};      // log() внутри асинхронной ветки
+    std::atomic<bool> writer_running_{false};
+    std::atomic<bool> writer_waiting_{false};
+    std::atomic<uint64_t> dropped_{0};
+    uint64_t reported_dropped_ = 0;
+    OverflowPolicy policy_ = DROP;
+    std::thread writer_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
 };
 
-#define LOG_DEBUG(msg) Logger::getInstance().log(Logger::DEBUG, msg)
-#define LOG_INFO(msg) Logger::getInstance().log(Logger::INFO, msg)
-#define LOG_WARNING(msg) Logger::getInstance().log(Logger::WARNING, msg)
-#define LOG_ERROR(msg) Logger::getInstance().log(Logger::ERROR, msg)
+// Сообщение вычисляется только если уровень включён
+#define LOG_AT(level, msg) \
+    do { \
+        if (Logger::isEnabled(level)) Logger::getInstance().log(level, msg); \
+    } while (0)
+
+#define LOG_DEBUG(msg) LOG_AT(Logger::DEBUG, msg)
+#define LOG_INFO(msg) LOG_AT(Logger::INFO, msg)
+#define LOG_WARNING(msg) LOG_AT(Logger::WARNING, msg)
+#define LOG_ERROR(msg) LOG_AT(Logger::ERROR, msg)
 
 #endif // LOGGING_H
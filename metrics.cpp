@@ -0,0 +1,162 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+/**
+ * Гистограммы и счётчики одного потока. Пишет только поток-владелец,
+ * поэтому атомарность нужна лишь для чтения из snapshot()
+ */
+struct ThreadMetrics {
+    struct Stage {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+        std::atomic<uint64_t> buckets[Metrics::BUCKET_COUNT] = {};
+    };
+
+    Stage stages[Metrics::STAGE_COUNT];
+    std::atomic<uint64_t> counters[Metrics::COUNTER_COUNT] = {};
+};
+
+// Прибавление без lock-префикса: у значения единственный писатель
+inline void bump(std::atomic<uint64_t>& value, uint64_t delta) {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+// Реестр не разрушается при выходе: потоки могут писать до самого конца
+std::mutex& registryMutex() {
+    static std::mutex* mutex = new std::mutex;
+    return *mutex;
+}
+
+std::vector<ThreadMetrics*>& registry() {
+    static std::vector<ThreadMetrics*>* threads = new std::vector<ThreadMetrics*>;
+    return *threads;
+}
+
+thread_local ThreadMetrics* local_metrics = nullptr;
+
+ThreadMetrics& localMetrics() {
+    if (!local_metrics) {
+        local_metrics = new ThreadMetrics;
+        std::lock_guard<std::mutex> lock(registryMutex());
+        registry().push_back(local_metrics);
+    }
+    return *local_metrics;
+}
+
+const char* const STAGE_NAMES[Metrics::STAGE_COUNT] = {
+    "parse", "queue", "encode", "rasterize", "compress", "send", "request"
+};
+
+const char* const COUNTER_NAMES[Metrics::COUNTER_COUNT] = {
+    "requests", "errors", "archive_hits", "bytes_sent"
+};
+
+} // namespace
+
+size_t Metrics::bucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(SUB_BUCKETS)) {
+        return static_cast<size_t>(value);
+    }
+    const int exponent = 63 - __builtin_clzll(value);
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    const size_t sub = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return static_cast<size_t>(exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t Metrics::bucketUpperBound(size_t index) {
+    if (index < static_cast<size_t>(SUB_BUCKETS)) {
+        return index;
+    }
+    const int exponent = static_cast<int>(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+    const uint64_t sub = index % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (exponent - SUB_BUCKET_BITS)) - 1;
+}
+
+void Metrics::record(Stage stage, uint64_t nanos) {
+    ThreadMetrics::Stage& target = localMetrics().stages[stage];
+    bump(target.count, 1);
+    bump(target.sum, nanos);
+    bump(target.buckets[bucketIndex(nanos)], 1);
+    if (nanos > target.max.load(std::memory_order_relaxed)) {
+        target.max.store(nanos, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::add(Counter counter, uint64_t value) {
+    if (enabled()) {
+        bump(localMetrics().counters[counter], value);
+    }
+}
+
+uint64_t Metrics::Histogram::percentile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * count + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), max);
+        }
+    }
+    return max;
+}
+
+Metrics::Snapshot Metrics::snapshot() {
+    Snapshot result;
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const ThreadMetrics* thread : registry()) {
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            const ThreadMetrics::Stage& source = thread->stages[s];
+            Histogram& target = result.stages[s];
+            target.count += source.count.load(std::memory_order_relaxed);
+            target.sum += source.sum.load(std::memory_order_relaxed);
+            target.max = std::max(target.max, source.max.load(std::memory_order_relaxed));
+            for (size_t i = 0; i < BUCKET_COUNT; i++) {
+                target.buckets[i] += source.buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            result.counters[c] += thread->counters[c].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+std::string Metrics::format(const Snapshot& snapshot) {
+    std::string out;
+    char line[256];
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        snprintf(line, sizeof(line), "%s %llu\n", COUNTER_NAMES[c],
+                 static_cast<unsigned long long>(snapshot.counters[c]));
+        out += line;
+    }
+    out += "# stage count mean_us p50_us p90_us p99_us p999_us max_us\n";
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        const Histogram& h = snapshot.stages[s];
+        const double mean = h.count ? static_cast<double>(h.sum) / h.count : 0.0;
+        snprintf(line, sizeof(line), "stage %s %llu %.1f %.1f %.1f %.1f %.1f %.1f\n",
+                 STAGE_NAMES[s], static_cast<unsigned long long>(h.count), mean / 1e3,
+                 h.percentile(0.5) / 1e3, h.percentile(0.9) / 1e3, h.percentile(0.99) / 1e3,
+                 h.percentile(0.999) / 1e3, h.max / 1e3);
+        out += line;
+    }
+    return out;
+}
+
+const char* Metrics::stageName(Stage stage) {
+    return STAGE_NAMES[stage];
+}
+
+const char* Metrics::counterName(Counter counter) {
+    return COUNTER_NAMES[counter];
+}
@@ -0,0 +1,134 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Счётчики и гистограммы задержек по стадиям обработки запроса.
+ *
+ * Гистограммы в духе HDR: значение в наносекундах попадает в корзину
+ * с относительной точностью 1/16 (16 корзин на каждую степень двойки),
+ * поэтому перцентили верны до ~6% в любом диапазоне — от сотен
+ * наносекунд до минут.
+ *
+ * У каждого потока свой набор гистограмм и счётчиков. Пишет в него
+ * только владелец — запись сводится к загрузке и сохранению без
+ * блокировок и атомарных read-modify-write; читатель (snapshot)
+ * суммирует наборы всех потоков. Набор переживает свой поток, чтобы
+ * итоги не уменьшались.
+ */
+class Metrics {
+public:
+    enum Stage {
+        STAGE_PARSE,       // разбор кадра или строки запроса в реакторе
+        STAGE_QUEUE,       // ожидание в очереди пула
+        STAGE_ENCODE,      // построение матрицы модулей
+        STAGE_RASTERIZE,   // растеризация и формат изображения, кроме deflate
+        STAGE_COMPRESS,    // deflate при записи PNG
+        STAGE_SEND,        // вызов отправки ответов в сокет
+        STAGE_REQUEST,     // от разбора запроса до ответа в очереди отправки
+        STAGE_COUNT
+    };
+
+    enum Counter {
+        COUNTER_REQUESTS,        // запросы, включая элементы пакетов
+        COUNTER_ERRORS,          // ответы с ошибкой
+        COUNTER_ARCHIVE_HITS,    // изображения из архива
+        COUNTER_BYTES_SENT,
+        COUNTER_COUNT
+    };
+
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 47;   // значения от 2^48 нс (~3 суток) — в последнюю корзину
+    static const size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    /**
+     * Включает и выключает сбор; выключенный сбор не читает часы
+     */
+    static void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * Монотонное время в наносекундах; 0, если сбор выключен
+     */
+    static uint64_t now() { return enabled() ? clock() : 0; }
+
+    /**
+     * Учитывает длительность стадии, начатой в момент start (now()).
+     * Нулевой start — сбор был выключен, ничего не пишется.
+     */
+    static void recordSince(Stage stage, uint64_t start) {
+        if (start != 0) {
+            const uint64_t end = clock();
+            record(stage, end > start ? end - start : 0);
+        }
+    }
+
+    static void record(Stage stage, uint64_t nanos);
+    static void add(Counter counter, uint64_t value = 1);
+
+    /**
+     * Замер стадии на время жизни объекта
+     */
+    class Timer {
+    public:
+        explicit Timer(Stage stage) : stage_(stage), start_(now()) {}
+        ~Timer() { recordSince(stage_, start_); }
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        Stage stage_;
+        uint64_t start_;
+    };
+
+    struct Histogram {
+        uint64_t count = 0;
+        uint64_t sum = 0;   // нс
+        uint64_t max = 0;   // нс
+        uint64_t buckets[BUCKET_COUNT] = {};
+
+        /**
+         * Верхняя граница корзины, в которую попадает доля q значений (0..1)
+         */
+        uint64_t percentile(double q) const;
+    };
+
+    struct Snapshot {
+        Histogram stages[STAGE_COUNT];
+        uint64_t counters[COUNTER_COUNT] = {};
+    };
+
+    /**
+     * Сумма по всем потокам. Читается без остановки писателей, поэтому
+     * значения разных счётчиков могут расходиться на несколько событий.
+     */
+    static Snapshot snapshot();
+
+    /**
+     * Текст отчёта: строки "имя значение" для счётчиков и по строке
+     * на стадию с числом замеров, средним, перцентилями и максимумом (мкс)
+     */
+    static std::string format(const Snapshot& snapshot);
+
+    static const char* stageName(Stage stage);
+    static const char* counterName(Counter counter);
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    static uint64_t clock() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static inline std::atomic<bool> enabled_{true};
+};
+
+#endif // METRICS_H
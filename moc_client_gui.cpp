@@ -21,136 +21,6 @@
 QT_BEGIN_MOC_NAMESPACE
 QT_WARNING_PUSH
 QT_WARNING_DISABLE_DEPRECATED
-struct qt_meta_stringdata_ClientThread_t {
-    QByteArrayData data[6];
-    char stringdata0[53];
-};
-#define QT_MOC_LITERAL(idx, ofs, len) \
-    Q_STATIC_BYTE_ARRAY_DATA_HEADER_INITIALIZER_WITH_OFFSET(len, \
-    qptrdiff(offsetof(qt_meta_stringdata_ClientThread_t, stringdata0) + ofs \
-        - idx * sizeof(QByteArrayData)) \
-    )
-static const qt_meta_stringdata_ClientThread_t qt_meta_stringdata_ClientThread = {
-    {
-QT_MOC_LITERAL(0, 0, 12), // "ClientThread"
-QT_MOC_LITERAL(1, 13, 11), // "resultReady"
-QT_MOC_LITERAL(2, 25, 0), // ""
-QT_MOC_LITERAL(3, 26, 6), // "result"
-QT_MOC_LITERAL(4, 33, 13), // "errorOccurred"
-QT_MOC_LITERAL(5, 47, 5) // "error"
-
-    },
-    "ClientThread\0resultReady\0\0result\0"
-    "errorOccurred\0error"
-};
-#undef QT_MOC_LITERAL
-
-static const uint qt_meta_data_ClientThread[] = {
-
- // content:
-       8,       // revision
-       0,       // classname
-       0,    0, // classinfo
-       2,   14, // methods
-       0,    0, // properties
-       0,    0, // enums/sets
-       0,    0, // constructors
-       0,       // flags
-       2,       // signalCount
-
- // signals: name, argc, parameters, tag, flags
-       1,    1,   24,    2, 0x06 /* Public */,
-       4,    1,   27,    2, 0x06 /* Public */,
-
- // signals: parameters
-    QMetaType::Void, QMetaType::QByteArray,    3,
-    QMetaType::Void, QMetaType::QString,    5,
-
-       0        // eod
-};
-
-void ClientThread::qt_static_metacall(QObject *_o, QMetaObject::Call _c, int _id, void **_a)
-{
-    if (_c == QMetaObject::InvokeMetaMethod) {
-        auto *_t = static_cast<ClientThread *>(_o);
-        (void)_t;
-        switch (_id) {
-        case 0: _t->resultReady((*reinterpret_cast< const QByteArray(*)>(_a[1]))); break;
-        case 1: _t->errorOccurred((*reinterpret_cast< const QString(*)>(_a[1]))); break;
-        default: ;
-        }
-    } else if (_c == QMetaObject::IndexOfMethod) {
-        int *result = reinterpret_cast<int *>(_a[0]);
-        {
-            using _t = void (ClientThread::*)(const QByteArray & );
-            if (*reinterpret_cast<_t *>(_a[1]) == static_cast<_t>(&ClientThread::resultReady)) {
-                *result = 0;
-                return;
-            }
-        }
-        {
-            using _t = void (ClientThread::*)(const QString & );
-            if (*reinterpret_cast<_t *>(_a[1]) == static_cast<_t>(&ClientThread::errorOccurred)) {
-                *result = 1;
-                return;
-            }
-        }
-    }
-}
-
-QT_INIT_METAOBJECT const QMetaObject ClientThread::staticMetaObject = { {
-    QMetaObject::SuperData::link<QThread::staticMetaObject>(),
-    qt_meta_stringdata_ClientThread.data,
-    qt_meta_data_ClientThread,
-    qt_static_metacall,
-    nullptr,
-    nullptr
-} };
-
-
-const QMetaObject *ClientThread::metaObject() const
-{
-    return QObject::d_ptr->metaObject ? QObject::d_ptr->dynamicMetaObject() : &staticMetaObject;
-}
-
-void *ClientThread::qt_metacast(const char *_clname)
-{
-    if (!_clname) return nullptr;
-    if (!strcmp(_clname, qt_meta_stringdata_ClientThread.stringdata0))
-        return static_cast<void*>(this);
-    return QThread::qt_metacast(_clname);
-}
-
-int ClientThread::qt_metacall(QMetaObject::Call _c, int _id, void **_a)
-{
-    _id = QThread::qt_metacall(_c, _id, _a);
-    if (_id < 0)
-        return _id;
-    if (_c == QMetaObject::InvokeMetaMethod) {
-        if (_id < 2)
-            qt_static_metacall(this, _c, _id, _a);
-        _id -= 2;
-    } else if (_c == QMetaObject::RegisterMethodArgumentMetaType) {
-        if (_id < 2)
-            *reinterpret_cast<int*>(_a[0]) = -1;
-        _id -= 2;
-    }
-    return _id;
-}
-
-// SIGNAL 0
-void ClientThread::resultReady(const QByteArray & _t1)
-{
-    void *_a[] = { nullptr, const_cast<void*>(reinterpret_cast<const void*>(std::addressof(_t1))) };
-    QMetaObject::activate(this, &staticMetaObject, 0, _a);
-}
-
-// SIGNAL 1
-void ClientThread::errorOccurred(const QString & _t1)
-{
-    void *_a[] = { nullptr, const_cast<void*>(reinterpret_cast<const void*>(std::addressof(_t1))) };
-    QMetaObject::activate(this, &staticMetaObject, 1, _a);
-}
 struct qt_meta_stringdata_ClientGUI_t {
     QByteArrayData data[8];
     char stringdata0[84];
@@ -16,7 +16,10 @@ std::string NetworkUtils::sendRequest(const std::string& host,
     }
 
     LOG_DEBUG("Sending request: " + request);
-    socket.write(request.c_str(), request.size());
+    // Перевод строки завершает запрос: без него сервер ждёт продолжения
+    // до своего срока тишины
+    const std::string line = request + "\n";
+    socket.write(line.c_str(), line.size());
     if (!socket.waitForBytesWritten(timeout)) {
         const QString error = socket.errorString();
         LOG_ERROR("Failed to send data: " + error.toStdString());
@@ -29,7 +32,89 @@ std::string NetworkUtils::sendRequest(const std::string& host,
         throw NetworkException("No response from server: " + error.toStdString());
     }
 
+    // Ответ текстового протокола не имеет длины: сервер закрывает
+    // соединение после отправки, поэтому читаем до закрытия
     QByteArray response = socket.readAll();
-    LOG_DEBUG("Received response: " + response.toStdString());
+    while (socket.state() == QAbstractSocket::ConnectedState && socket.waitForReadyRead(timeout)) {
+        response.append(socket.readAll());
+    }
+    response.append(socket.readAll());
+
+    LOG_DEBUG("Received response: " + std::to_string(response.size()) + " bytes");
     return std::string(response.constData(), response.size());
 }
+
+BatchSummary NetworkUtils::sendBatch(const std::string& host,
+                                     int port,
+                                     const std::vector<BatchItem>& items,
+                                     const BatchResultHandler& on_result,
+                                     int timeout) {
+    FramedConnection connection(host, port, timeout);
+    uint32_t request_id = connection.sendBatch(items);
+    LOG_DEBUG("Sent batch of " + std::to_string(items.size()) + " items");
+
+    FrameHeader header;
+    std::string payload;
+    while (true) {
+        connection.receiveFrame(header, payload);
+        if (header.request_id != request_id) {
+            continue;
+        }
+        if (header.type == FRAME_BATCH_ITEM) {
+            on_result(header.flags, header.status == STATUS_OK, payload);
+        } else if (header.type == FRAME_BATCH_END) {
+            if (header.status != STATUS_OK) {
+                LOG_ERROR("Batch rejected: " + payload);
+                throw NetworkException("Batch rejected: " + payload);
+            }
+            return decodeBatchSummary(payload);
+        }
+    }
+}
+
+FramedConnection::FramedConnection(const std::string& host, int port, int timeout)
+    : timeout_(timeout) {
+    LOG_DEBUG("Connecting to " + host + ":" + std::to_string(port));
+    socket_.connectToHost(QString::fromStdString(host), port);
+
+    if (!socket_.waitForConnected(timeout_)) {
+        const QString error = socket_.errorString();
+        LOG_ERROR("Connection failed: " + error.toStdString());
+        throw NetworkException("Connection failed: " + error.toStdString());
+    }
+}
+
+uint32_t FramedConnection::sendFrame(FrameType type, const std::string& payload, uint32_t flags) {
+    FrameHeader header;
+    header.type = type;
+    header.request_id = next_id_++;
+    header.flags = flags;
+
+    std::string frame = encodeFrame(header, payload);
+    if (socket_.write(frame.data(), frame.size()) != static_cast<qint64>(frame.size())) {
+        const QString error = socket_.errorString();
+        LOG_ERROR("Failed to send data: " + error.toStdString());
+        throw NetworkException("Failed to send data: " + error.toStdString());
+    }
+    return header.request_id;
+}
+
+uint32_t FramedConnection::sendBatch(const std::vector<BatchItem>& items) {
+    return sendFrame(FRAME_BATCH, encodeBatch(items));
+}
+
+void FramedConnection::receiveFrame(FrameHeader& header, std::string& payload) {
+    while (!decoder_.next(header, payload)) {
+        // Досылаем буферизованные запросы, пока ждём ответ
+        if (socket_.bytesToWrite() > 0) {
+            socket_.waitForBytesWritten(timeout_);
+        }
+        if (socket_.bytesAvailable() == 0 && !socket_.waitForReadyRead(timeout_)) {
+            const QString error = socket_.errorString();
+            LOG_ERROR("No response from server: " + error.toStdString());
+            throw NetworkException("No response from server: " + error.toStdString());
+        }
+        QByteArray chunk = socket_.readAll();
+        decoder_.feed(chunk.constData(), chunk.size());
+    }
+}
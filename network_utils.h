@@ -3,8 +3,12 @@
 
 #include <string>
 #include <stdexcept>
+#include <cstdint>
+#include <functional>
+#include <vector>
 #include <QTcpSocket>
 #include "logging.h"
+#include "protocol.h"
 
 class NetworkException : public std::runtime_error {
 public:
@@ -14,10 +18,64 @@ public:
 
 class NetworkUtils {
 public:
+    /**
+     * Отправляет запрос текстового протокола (TEXT:/GEO:) и читает ответ
+     * целиком — до закрытия соединения сервером
+     */
     static std::string sendRequest(const std::string& host, 
                                  int port, 
                                  const std::string& request,
                                  int timeout = 5000);
+
+    using BatchResultHandler = std::function<void(uint32_t index, bool ok, const std::string& data)>;
+
+    /**
+     * Отправляет пакет запросов TEXT/GEO одним кадром и принимает
+     * изображения по мере готовности
+     * @param items Элементы пакета
+     * @param on_result Вызывается для каждого элемента (в порядке готовности);
+     *                  data — PNG либо текст ошибки
+     * @return Итог пакета: число элементов и число ошибок
+     */
+    static BatchSummary sendBatch(const std::string& host,
+                                  int port,
+                                  const std::vector<BatchItem>& items,
+                                  const BatchResultHandler& on_result,
+                                  int timeout = 5000);
+};
+
+/**
+ * Постоянное соединение по бинарному протоколу (protocol.h).
+ * Запросы можно отправлять подряд, не дожидаясь ответов; ответы
+ * приходят в порядке готовности и сопоставляются по request_id.
+ */
+class FramedConnection {
+public:
+    FramedConnection(const std::string& host, int port, int timeout = 5000);
+
+    /**
+     * Отправляет запрос
+     * @return request_id, с которым придёт ответ
+     */
+    uint32_t sendFrame(FrameType type, const std::string& payload, uint32_t flags = 0);
+
+    /**
+     * Отправляет пакетный запрос; ответы приходят кадрами FRAME_BATCH_ITEM
+     * и завершающим FRAME_BATCH_END с тем же request_id
+     */
+    uint32_t sendBatch(const std::vector<BatchItem>& items);
+
+    /**
+     * Дожидается следующего ответа целиком, даже если он пришёл
+     * несколькими порциями
+     */
+    void receiveFrame(FrameHeader& header, std::string& payload);
+
+private:
+    QTcpSocket socket_;
+    FrameDecoder decoder_;
+    uint32_t next_id_ = 1;
+    int timeout_;
 };
 
 #endif // NETWORK_UTILS_H
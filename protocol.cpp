@@ -0,0 +1,199 @@
+#include "protocol.h"
+#include <cstring>
+#include <arpa/inet.h>
+
+namespace {
+
+void putUint32(char* out, uint32_t value) {
+    value = htonl(value);
+    memcpy(out, &value, sizeof(value));
+}
+
+uint32_t getUint32(const char* in) {
+    uint32_t value;
+    memcpy(&value, in, sizeof(value));
+    return ntohl(value);
+}
+
+} // namespace
+
+void encodeFrameHeader(const FrameHeader& header, char* out) {
+    out[0] = static_cast<char>(FRAME_MAGIC);
+    out[1] = static_cast<char>(header.version);
+    out[2] = static_cast<char>(header.type);
+    out[3] = static_cast<char>(header.status);
+    putUint32(out + 4, header.request_id);
+    putUint32(out + 8, header.length);
+    putUint32(out + 12, header.flags);
+}
+
+FrameHeader decodeFrameHeader(const char* in) {
+    if (static_cast<uint8_t>(in[0]) != FRAME_MAGIC) {
+        throw ProtocolException("Bad frame magic");
+    }
+
+    FrameHeader header;
+    header.version = static_cast<uint8_t>(in[1]);
+    if (header.version != FRAME_VERSION) {
+        throw ProtocolException("Unsupported protocol version " + std::to_string(header.version));
+    }
+    header.type = static_cast<uint8_t>(in[2]);
+    header.status = static_cast<uint8_t>(in[3]);
+    header.request_id = getUint32(in + 4);
+    header.length = getUint32(in + 8);
+    header.flags = getUint32(in + 12);
+    return header;
+}
+
+std::string encodeFrame(FrameHeader header, const std::string& payload) {
+    std::string frame;
+    frame.reserve(FRAME_HEADER_SIZE + payload.size());
+    size_t offset = beginFrame(frame);
+    frame.append(payload);
+    finishFrame(frame, offset, header);
+    return frame;
+}
+
+size_t beginFrame(std::string& buffer) {
+    size_t offset = buffer.size();
+    buffer.append(FRAME_HEADER_SIZE, '\0');
+    return offset;
+}
+
+void finishFrame(std::string& buffer, size_t header_offset, FrameHeader header) {
+    header.length = static_cast<uint32_t>(buffer.size() - header_offset - FRAME_HEADER_SIZE);
+    encodeFrameHeader(header, &buffer[header_offset]);
+}
+
+uint32_t encodeImageFlags(const ImageFlags& flags) {
+    return (flags.format & 0x0Fu) |
+           (flags.ec_level & 0x03u) << 4 |
+           (flags.mask & 0x0Fu) << 6 |
+           (flags.byte_mode ? 1u : 0u) << 10 |
+           (flags.min_version & 0x3Fu) << 11 |
+           (flags.max_version & 0x3Fu) << 17;
+}
+
+ImageFlags decodeImageFlags(uint32_t flags) {
+    ImageFlags result;
+    result.format = static_cast<uint8_t>(flags & FRAME_FLAG_FORMAT_MASK);
+    result.ec_level = static_cast<uint8_t>((flags >> 4) & 0x03);
+    result.mask = static_cast<uint8_t>((flags >> 6) & 0x0F);
+    result.byte_mode = (flags >> 10) & 1;
+    result.min_version = static_cast<uint8_t>((flags >> 11) & 0x3F);
+    result.max_version = static_cast<uint8_t>((flags >> 17) & 0x3F);
+    return result;
+}
+
+void retagFrame(std::string& frame, uint8_t type, uint32_t flags) {
+    if (frame.size() < FRAME_HEADER_SIZE) {
+        throw ProtocolException("Frame is shorter than its header");
+    }
+    frame[2] = static_cast<char>(type);
+    putUint32(&frame[12], flags);
+}
+
+std::string encodeBatch(const std::vector<BatchItem>& items) {
+    size_t total = 4;
+    for (const auto& item : items) {
+        total += 5 + item.payload.size();
+    }
+
+    std::string payload(total, '\0');
+    char* out = &payload[0];
+    putUint32(out, static_cast<uint32_t>(items.size()));
+    out += 4;
+    for (const auto& item : items) {
+        *out++ = static_cast<char>(item.type);
+        putUint32(out, static_cast<uint32_t>(item.payload.size()));
+        out += 4;
+        memcpy(out, item.payload.data(), item.payload.size());
+        out += item.payload.size();
+    }
+    return payload;
+}
+
+std::vector<BatchItem> decodeBatch(const std::string& payload, size_t max_items) {
+    if (payload.size() < 4) {
+        throw ProtocolException("Batch payload is too short");
+    }
+
+    const char* in = payload.data();
+    const char* end = in + payload.size();
+    uint32_t count = getUint32(in);
+    in += 4;
+
+    // Каждый элемент занимает минимум 5 байт — не даём раздуть reserve
+    if (count > payload.size() / 5) {
+        throw ProtocolException("Batch item count exceeds payload size");
+    }
+    if (count > max_items) {
+        throw ProtocolException("Batch has " + std::to_string(count) + " items, limit is " +
+                                std::to_string(max_items));
+    }
+
+    std::vector<BatchItem> items(count);
+    for (auto& item : items) {
+        if (end - in < 5) {
+            throw ProtocolException("Truncated batch item header");
+        }
+        item.type = static_cast<uint8_t>(*in++);
+        uint32_t length = getUint32(in);
+        in += 4;
+        if (static_cast<size_t>(end - in) < length) {
+            throw ProtocolException("Truncated batch item payload");
+        }
+        item.payload.assign(in, length);
+        in += length;
+    }
+    return items;
+}
+
+std::string encodeBatchSummary(const BatchSummary& summary) {
+    std::string payload(8, '\0');
+    putUint32(&payload[0], summary.count);
+    putUint32(&payload[4], summary.failed);
+    return payload;
+}
+
+BatchSummary decodeBatchSummary(const std::string& payload) {
+    if (payload.size() < 8) {
+        throw ProtocolException("Batch summary is too short");
+    }
+    BatchSummary summary;
+    summary.count = getUint32(payload.data());
+    summary.failed = getUint32(payload.data() + 4);
+    return summary;
+}
+
+void FrameDecoder::feed(const char* data, size_t size) {
+    // Сдвигаем разобранную часть, чтобы буфер не рос бесконечно
+    if (offset_ > 0 && offset_ >= buffer_.size() / 2) {
+        buffer_.erase(0, offset_);
+        offset_ = 0;
+    }
+    buffer_.append(data, size);
+}
+
+bool FrameDecoder::next(FrameHeader& header, std::string& payload) {
+    if (buffered() < FRAME_HEADER_SIZE) {
+        return false;
+    }
+
+    FrameHeader candidate = decodeFrameHeader(buffer_.data() + offset_);
+    if (candidate.length > max_payload_) {
+        throw ProtocolException("Frame payload too large: " + std::to_string(candidate.length));
+    }
+    if (buffered() < FRAME_HEADER_SIZE + candidate.length) {
+        return false;
+    }
+
+    header = candidate;
+    payload.assign(buffer_, offset_ + FRAME_HEADER_SIZE, candidate.length);
+    offset_ += FRAME_HEADER_SIZE + candidate.length;
+    if (offset_ == buffer_.size()) {
+        buffer_.clear();
+        offset_ = 0;
+    }
+    return true;
+}
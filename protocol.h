@@ -0,0 +1,192 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Бинарный протокол с кадрами фиксированного заголовка.
+ *
+ * Заголовок (16 байт, сетевой порядок байт):
+ *   magic(1) version(1) type(1) status(1) request_id(4) length(4) flags(4)
+ * за ним следует length байт полезной нагрузки.
+ *
+ * Первый байт 0xA5 не встречается в текстовом протоколе (TEXT:/GEO:),
+ * поэтому сервер различает режимы по первому байту соединения.
+ * Соединение в бинарном режиме постоянное: клиент может отправлять
+ * запросы, не дожидаясь ответов, а ответы приходят в порядке готовности
+ * и сопоставляются с запросами по request_id.
+ *
+ * Пакетный запрос (FRAME_BATCH) несёт N элементов TEXT/GEO:
+ *   count(4) затем count раз: type(1) length(4) данные(length)
+ * Сервер отвечает N кадрами FRAME_BATCH_ITEM по мере готовности
+ * (индекс элемента — в поле flags) и завершающим FRAME_BATCH_END
+ * с нагрузкой count(4) failed(4). Все ответы несут request_id пакета.
+ *
+ * Поле flags запроса TEXT/GEO (у BATCH — общее для всех элементов)
+ * несёт параметры изображения, нулевое поле — значение по умолчанию:
+ *   биты 0-3   формат (ImageFormat)
+ *   биты 4-5   уровень коррекции: 0 L, 1 M, 2 Q, 3 H
+ *   биты 6-9   маска: 0 — выбор по штрафам, 1-8 — маска 0-7
+ *   бит  10    только байтовый режим, без разбиения на сегменты
+ *   биты 11-16 наименьшая версия, 0 — 1
+ *   биты 17-22 наибольшая версия, 0 — 40
+ * Ответ FRAME_IMAGE повторяет формат в flags. Текстовый протокол всегда
+ * отвечает PNG с параметрами по умолчанию.
+ *
+ * FRAME_STATS (нагрузка пустая) возвращает FRAME_STATS_REPLY с текстовым
+ * отчётом метрик сервера; в текстовом протоколе то же даёт запрос "STATS".
+ * Отчёт формирует поток реактора, минуя очередь пула, — он доступен
+ * и тогда, когда сервер перегружен.
+ */
+
+const uint8_t FRAME_MAGIC = 0xA5;
+const uint8_t FRAME_VERSION = 1;
+const size_t FRAME_HEADER_SIZE = 16;
+const uint32_t FRAME_MAX_PAYLOAD = 16 * 1024 * 1024;
+
+enum FrameType : uint8_t {
+    FRAME_TEXT = 0x01,      // запрос: текст для кодирования
+    FRAME_GEO = 0x02,       // запрос: "широта,долгота"
+    FRAME_BATCH = 0x03,     // запрос: пакет элементов TEXT/GEO
+    FRAME_STATS = 0x04,     // запрос: отчёт метрик
+    FRAME_IMAGE = 0x81,     // ответ: изображение QR-кода
+    FRAME_BATCH_ITEM = 0x82,// ответ: изображение элемента пакета
+    FRAME_BATCH_END = 0x83, // ответ: пакет обработан полностью
+    FRAME_STATS_REPLY = 0x84// ответ: отчёт метрик, текст
+};
+
+enum ImageFormat : uint8_t {
+    IMAGE_FORMAT_PNG = 0,   // по умолчанию
+    IMAGE_FORMAT_SVG = 1,
+    IMAGE_FORMAT_PBM = 2,   // Netpbm P4
+    IMAGE_FORMAT_RAW = 3    // байт версии, затем строки модулей по (size + 7) / 8 байт
+};
+
+const uint32_t FRAME_FLAG_FORMAT_MASK = 0x0F;
+
+/**
+ * Параметры изображения из поля flags запроса
+ */
+struct ImageFlags {
+    uint8_t format = IMAGE_FORMAT_PNG;
+    uint8_t ec_level = 0;
+    uint8_t mask = 0;          // 0 — выбор по штрафам, иначе номер маски + 1
+    bool byte_mode = false;
+    uint8_t min_version = 0;   // 0 — без ограничения
+    uint8_t max_version = 0;
+};
+
+enum FrameStatus : uint8_t {
+    STATUS_OK = 0,
+    STATUS_ERROR = 1,       // нагрузка содержит текст ошибки
+    STATUS_BUSY = 2         // сервер перегружен, запрос можно повторить
+};
+
+struct FrameHeader {
+    uint8_t version = FRAME_VERSION;
+    uint8_t type = 0;
+    uint8_t status = STATUS_OK;
+    uint32_t request_id = 0;
+    uint32_t length = 0;
+    uint32_t flags = 0;
+};
+
+struct BatchItem {
+    uint8_t type = FRAME_TEXT;
+    std::string payload;
+};
+
+struct BatchSummary {
+    uint32_t count = 0;
+    uint32_t failed = 0;
+};
+
+class ProtocolException : public std::runtime_error {
+public:
+    explicit ProtocolException(const std::string& msg)
+        : std::runtime_error("[PROTOCOL ERROR] " + msg) {}
+};
+
+/**
+ * Записывает заголовок кадра в out (FRAME_HEADER_SIZE байт)
+ */
+void encodeFrameHeader(const FrameHeader& header, char* out);
+
+/**
+ * Разбирает заголовок кадра
+ * @throws ProtocolException при неверной сигнатуре, версии или длине
+ */
+FrameHeader decodeFrameHeader(const char* in);
+
+/**
+ * Собирает кадр целиком: заголовок и нагрузку
+ */
+std::string encodeFrame(FrameHeader header, const std::string& payload);
+
+/**
+ * Начинает кадр в buffer: резервирует место под заголовок, после чего
+ * нагрузку можно дописывать прямо в buffer без промежуточных копий.
+ * @return Смещение заголовка, которое нужно передать в finishFrame
+ */
+size_t beginFrame(std::string& buffer);
+
+/**
+ * Завершает кадр, начатый beginFrame: проставляет длину нагрузки
+ * и записывает заголовок
+ */
+void finishFrame(std::string& buffer, size_t header_offset, FrameHeader header);
+
+uint32_t encodeImageFlags(const ImageFlags& flags);
+ImageFlags decodeImageFlags(uint32_t flags);
+
+/**
+ * Меняет тип и флаги готового кадра на месте, не трогая нагрузку
+ */
+void retagFrame(std::string& frame, uint8_t type, uint32_t flags);
+
+/**
+ * Кодирует элементы пакетного запроса в нагрузку кадра FRAME_BATCH
+ */
+std::string encodeBatch(const std::vector<BatchItem>& items);
+
+/**
+ * Разбирает нагрузку кадра FRAME_BATCH
+ * @param max_items Наибольшее допустимое число элементов
+ * @throws ProtocolException при повреждённой нагрузке или слишком большом пакете
+ */
+std::vector<BatchItem> decodeBatch(const std::string& payload, size_t max_items);
+
+std::string encodeBatchSummary(const BatchSummary& summary);
+BatchSummary decodeBatchSummary(const std::string& payload);
+
+/**
+ * Инкрементальный разборщик потока кадров: данные подаются кусками
+ * по мере чтения из сокета, готовые кадры извлекаются через next()
+ */
+class FrameDecoder {
+public:
+    explicit FrameDecoder(uint32_t max_payload = FRAME_MAX_PAYLOAD)
+        : max_payload_(max_payload) {}
+
+    void feed(const char* data, size_t size);
+
+    /**
+     * Извлекает очередной полностью полученный кадр
+     * @return false, если данных для целого кадра пока недостаточно
+     * @throws ProtocolException при повреждённом потоке
+     */
+    bool next(FrameHeader& header, std::string& payload);
+
+    size_t buffered() const { return buffer_.size() - offset_; }
+
+private:
+    uint32_t max_payload_;
+    std::string buffer_;
+    size_t offset_ = 0;
+};
+
+#endif // PROTOCOL_H
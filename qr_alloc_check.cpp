@@ -0,0 +1,120 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "logging.h"
+#include "qr_generator.h"
+
+/**
+ * Проверка, что установившийся запрос libqr не обращается к куче.
+ *
+ * Глобальные operator new/delete заменены счётчиком (учитываются и
+ * потоки-помощники масок). Каждый вариант запроса сначала прогревается:
+ * строятся разметки версий, блоки арены, потоки zlib и буфер output,
+ * после чего считаются выделения на серии одинаковых запросов.
+ * Ненулевое число — ошибка, код возврата 1.
+ */
+
+namespace {
+
+std::atomic<size_t> allocations{0};
+
+void* countedAllocate(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t size) { return countedAllocate(size); }
+void* operator new[](size_t size) { return countedAllocate(size); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+
+namespace {
+
+const int WARMUP = 3;
+const int REQUESTS = 50;
+
+struct Case {
+    const char* name;
+    std::string data;
+    EncodeOptions encoding;
+};
+
+EncodeOptions byteModeH() {
+    EncodeOptions options;
+    options.level = QREncoder::EC_H;
+    options.optimize_segments = false;
+    return options;
+}
+
+EncodeOptions forcedMask() {
+    EncodeOptions options;
+    options.mask = 3;
+    options.min_version = 10;
+    return options;
+}
+
+} // namespace
+
+int main() {
+    Logger::setLevel(Logger::WARNING);
+    QRGenerator::setBackend(QRGenerator::BACKEND_NATIVE);
+
+    const Case cases[] = {
+        {"sku", "SKU-004711-BLK-XL", EncodeOptions()},
+        {"url", "https://shop.example.com/products/red-shoes-123456?utm_source=qr", EncodeOptions()},
+        {"url H bytes", "https://shop.example.com/products/red-shoes-123456?utm_source=qr", byteModeH()},
+        {"mask 3 v10", "4006381333931", forcedMask()},
+        {"text v27", std::string(900, 'q'), EncodeOptions()},
+    };
+    const RasterOptions rasters[] = {{1, 0, 1}, {4, 4, 1}, {4, 4, 8}};
+    const PNGWriter::Compression compressions[] = {PNGWriter::COMPRESSION_STORE,
+                                                   PNGWriter::COMPRESSION_FAST,
+                                                   PNGWriter::COMPRESSION_BEST};
+
+    int failures = 0, checked = 0;
+    std::string output;
+    for (const Case& c : cases) {
+        for (const RasterOptions& raster : rasters) {
+            for (int f = 0; f < QROutput::FORMAT_COUNT; f++) {
+                const auto format = static_cast<QROutput::Format>(f);
+                for (PNGWriter::Compression compression : compressions) {
+                    if (format != QROutput::FORMAT_PNG && compression != PNGWriter::COMPRESSION_FAST) {
+                        continue;
+                    }
+                    QRGenerator::setPngCompression(compression);
+                    for (int i = 0; i < WARMUP; i++) {
+                        output.clear();
+                        QRGenerator::generateQRImage(c.data, output, raster, format, c.encoding);
+                    }
+
+                    const size_t before = allocations.load();
+                    for (int i = 0; i < REQUESTS; i++) {
+                        output.clear();
+                        QRGenerator::generateQRImage(c.data, output, raster, format, c.encoding);
+                    }
+                    const size_t count = allocations.load() - before;
+
+                    checked++;
+                    if (count != 0) {
+                        failures++;
+                        std::printf("ALLOCATES %-12s %-8s %s %-5s %.2f per request\n", c.name,
+                                    raster.key().c_str(), QROutput::formatName(format),
+                                    PNGWriter::compressionName(compression),
+                                    static_cast<double>(count) / REQUESTS);
+                    }
+                }
+            }
+        }
+    }
+    std::printf("allocation check: %d request kinds, %d allocate in steady state\n", checked, failures);
+    return failures == 0 ? 0 : 1;
+}
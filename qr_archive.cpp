@@ -0,0 +1,192 @@
+#include "qr_archive.h"
+#include "logging.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "archive layout is little-endian");
+
+uint64_t archiveHash(const char* data, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+ArchiveWriter::ArchiveWriter(const std::string& path, const std::string& options)
+    : path_(path), strings_(options), options_length_(static_cast<uint32_t>(options.size())) {
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOG_ERROR("Failed to create archive " + path + ": " + strerror(errno));
+        throw std::runtime_error("Failed to create archive " + path);
+    }
+    // Заголовок записывается в finish(), когда известны смещения
+    offset_ = sizeof(ArchiveHeader);
+}
+
+ArchiveWriter::~ArchiveWriter() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void ArchiveWriter::writeAt(const void* data, size_t length, uint64_t offset) {
+    const char* bytes = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t written = pwrite(fd_, bytes, length, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("Failed to write archive " + path_ + ": " + strerror(errno));
+            throw std::runtime_error("Failed to write archive " + path_);
+        }
+        bytes += written;
+        length -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+}
+
+void ArchiveWriter::append(const std::string& name, const std::string& content, uint8_t format,
+                           const std::string& image) {
+    if (strings_.size() + content.size() + name.size() > UINT32_MAX || image.size() > UINT32_MAX) {
+        LOG_ERROR("Archive limit exceeded: " + path_);
+        throw std::runtime_error("Archive limit exceeded");
+    }
+
+    ArchiveEntry entry = {};
+    entry.hash = archiveHash(content.data(), content.size());
+    entry.data_offset = (offset_ + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+    entry.data_length = static_cast<uint32_t>(image.size());
+    entry.content_offset = static_cast<uint32_t>(strings_.size());
+    entry.content_length = static_cast<uint32_t>(content.size());
+    strings_.append(content);
+    entry.name_offset = static_cast<uint32_t>(strings_.size());
+    entry.name_length = static_cast<uint32_t>(name.size());
+    strings_.append(name);
+    entry.format = format;
+
+    writeAt(image.data(), image.size(), entry.data_offset);
+    offset_ = entry.data_offset + image.size();
+    entries_.push_back(entry);
+}
+
+void ArchiveWriter::finish() {
+    const char* strings = strings_.data();
+    std::sort(entries_.begin(), entries_.end(), [strings](const ArchiveEntry& a, const ArchiveEntry& b) {
+        if (a.hash != b.hash) return a.hash < b.hash;
+        return std::lexicographical_compare(strings + a.content_offset,
+                                            strings + a.content_offset + a.content_length,
+                                            strings + b.content_offset,
+                                            strings + b.content_offset + b.content_length);
+    });
+
+    ArchiveHeader header = {};
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = ARCHIVE_VERSION;
+    header.entry_count = entryCount();
+    header.index_offset = (offset_ + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+    header.strings_offset = header.index_offset + entries_.size() * sizeof(ArchiveEntry);
+    header.strings_size = strings_.size();
+    header.options_length = options_length_;
+
+    writeAt(entries_.data(), entries_.size() * sizeof(ArchiveEntry), header.index_offset);
+    writeAt(strings_.data(), strings_.size(), header.strings_offset);
+    writeAt(&header, sizeof(header), 0);
+    offset_ = header.strings_offset + strings_.size();
+
+    if (close(fd_) != 0) {
+        fd_ = -1;
+        LOG_ERROR("Failed to close archive " + path_ + ": " + strerror(errno));
+        throw std::runtime_error("Failed to close archive " + path_);
+    }
+    fd_ = -1;
+}
+
+ArchiveReader::ArchiveReader(const std::string& path) : path_(path) {
+    fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        LOG_ERROR("Failed to open archive " + path + ": " + strerror(errno));
+        throw std::runtime_error("Failed to open archive " + path);
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ArchiveHeader)) {
+        close(fd_);
+        LOG_ERROR("Archive too short: " + path);
+        throw std::runtime_error("Invalid archive " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        close(fd_);
+        LOG_ERROR("Failed to map archive " + path + ": " + strerror(errno));
+        throw std::runtime_error("Failed to map archive " + path);
+    }
+    base_ = static_cast<const char*>(mapped);
+
+    auto invalid = [this](const std::string& reason) {
+        munmap(const_cast<char*>(base_), size_);
+        close(fd_);
+        LOG_ERROR("Invalid archive " + path_ + ": " + reason);
+        throw std::runtime_error("Invalid archive " + path_ + ": " + reason);
+    };
+
+    header_ = reinterpret_cast<const ArchiveHeader*>(base_);
+    if (memcmp(header_->magic, ARCHIVE_MAGIC, sizeof(header_->magic)) != 0) invalid("bad magic");
+    if (header_->version != ARCHIVE_VERSION) invalid("unsupported version");
+    const uint64_t count = header_->entry_count;
+    if (header_->index_offset % ARCHIVE_ALIGNMENT != 0 || header_->index_offset > size_ ||
+        count > (size_ - header_->index_offset) / sizeof(ArchiveEntry)) {
+        invalid("index out of bounds");
+    }
+    if (header_->strings_offset > size_ || header_->strings_size > size_ - header_->strings_offset ||
+        header_->options_length > header_->strings_size) {
+        invalid("string table out of bounds");
+    }
+    entries_ = reinterpret_cast<const ArchiveEntry*>(base_ + header_->index_offset);
+    strings_ = base_ + header_->strings_offset;
+
+    // Проверка границ и порядка записей вместе с построением каталога
+    while ((uint64_t(1) << bucket_bits_) < count) bucket_bits_++;
+    buckets_.assign((size_t(1) << bucket_bits_) + 1, 0);
+    size_t bucket = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        const ArchiveEntry& entry = entries_[i];
+        if (entry.data_offset > size_ || entry.data_length > size_ - entry.data_offset ||
+            uint64_t(entry.content_offset) + entry.content_length > header_->strings_size ||
+            uint64_t(entry.name_offset) + entry.name_length > header_->strings_size) {
+            invalid("entry " + std::to_string(i) + " out of bounds");
+        }
+        if (i > 0 && entries_[i - 1].hash > entry.hash) {
+            invalid("index is not sorted");
+        }
+        const size_t target = bucket_bits_ ? entry.hash >> (64 - bucket_bits_) : 0;
+        while (bucket <= target) buckets_[bucket++] = static_cast<uint32_t>(i);
+    }
+    while (bucket < buckets_.size()) buckets_[bucket++] = static_cast<uint32_t>(count);
+    LOG_INFO("Archive " + path + ": " + std::to_string(count) + " entries");
+}
+
+ArchiveReader::~ArchiveReader() {
+    munmap(const_cast<char*>(base_), size_);
+    close(fd_);
+}
+
+const ArchiveEntry* ArchiveReader::find(const char* content, size_t length) const {
+    const uint64_t hash = archiveHash(content, length);
+    const size_t bucket = bucket_bits_ ? hash >> (64 - bucket_bits_) : 0;
+    for (uint32_t i = buckets_[bucket]; i < buckets_[bucket + 1]; i++) {
+        const ArchiveEntry& entry = entries_[i];
+        if (entry.hash > hash) break;
+        if (entry.hash == hash && entry.content_length == length &&
+            memcmp(strings_ + entry.content_offset, content, length) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,165 @@
+#ifndef QR_ARCHIVE_H
+#define QR_ARCHIVE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Упакованный архив готовых изображений.
+ *
+ * Файл целиком рассчитан на чтение через mmap без разбора:
+ *   заголовок ArchiveHeader;
+ *   изображения подряд, каждое с границы ARCHIVE_ALIGNMENT;
+ *   индекс — entry_count записей ArchiveEntry, упорядоченных по
+ *   (hash, содержимое);
+ *   таблица строк: параметры генерации, затем содержимое и имена записей.
+ * Все числа — little-endian.
+ *
+ * Параметры генерации (формат, растр, кодирование — та же строка, что
+ * в ключе кэша сервера) хранятся в архиве, чтобы читатель мог отказаться
+ * от архива, собранного с другими параметрами.
+ */
+
+const char ARCHIVE_MAGIC[8] = {'Q', 'R', 'P', 'A', 'C', 'K', '\0', '\1'};
+const uint32_t ARCHIVE_VERSION = 1;
+const uint64_t ARCHIVE_ALIGNMENT = 8;
+
+struct ArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+    uint64_t index_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint32_t options_length;   // параметры генерации — в начале таблицы строк
+    uint32_t reserved;
+};
+
+struct ArchiveEntry {
+    uint64_t hash;             // archiveHash(содержимое)
+    uint64_t data_offset;      // от начала файла
+    uint32_t data_length;
+    uint32_t content_offset;   // в таблице строк
+    uint32_t content_length;
+    uint32_t name_offset;
+    uint32_t name_length;
+    uint8_t format;            // QROutput::Format
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(ArchiveHeader) == 48, "ArchiveHeader layout");
+static_assert(sizeof(ArchiveEntry) == 40, "ArchiveEntry layout");
+
+/**
+ * FNV-1a, 64 бита: стабилен между сборками и платформами
+ */
+uint64_t archiveHash(const char* data, size_t length);
+
+/**
+ * Последовательная запись архива. Изображения пишутся в файл сразу,
+ * индекс копится в памяти и записывается в finish().
+ */
+class ArchiveWriter {
+public:
+    /**
+     * @param path Путь к архиву (перезаписывается)
+     * @param options Параметры генерации всех записей
+     * @throws std::runtime_error Если файл не открывается
+     */
+    ArchiveWriter(const std::string& path, const std::string& options);
+    ~ArchiveWriter();
+
+    ArchiveWriter(const ArchiveWriter&) = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+    /**
+     * Дописывает изображение
+     * @param name Имя записи (идентификатор из входных данных)
+     * @param content Закодированное содержимое — ключ поиска
+     * @param format Формат изображения
+     * @param image Данные изображения
+     * @throws std::runtime_error При ошибке записи
+     */
+    void append(const std::string& name, const std::string& content, uint8_t format,
+                const std::string& image);
+
+    /**
+     * Сортирует и записывает индекс и таблицу строк, закрывает файл
+     */
+    void finish();
+
+    uint32_t entryCount() const { return static_cast<uint32_t>(entries_.size()); }
+    uint64_t bytesWritten() const { return offset_; }
+
+private:
+    void writeAt(const void* data, size_t length, uint64_t offset);
+
+    std::string path_;
+    int fd_ = -1;
+    uint64_t offset_ = 0;
+    std::string strings_;
+    std::vector<ArchiveEntry> entries_;
+    uint32_t options_length_ = 0;
+};
+
+/**
+ * Архив, отображённый в память только для чтения.
+ *
+ * Индекс и изображения не копируются и не разбираются: при открытии
+ * проверяются только границы записей и строится каталог по старшим
+ * битам хэша — 2^k корзин на entry_count записей, где k — наименьшее
+ * с 2^k >= entry_count. Поскольку индекс отсортирован по хэшу, записи
+ * корзины лежат подряд, и поиск — это одно обращение к каталогу и
+ * в среднем одна запись индекса.
+ *
+ * Дескриптор файла остаётся открытым: по нему ответы можно отправлять
+ * через sendfile, минуя пользовательскую память.
+ */
+class ArchiveReader {
+public:
+    /**
+     * @param path Путь к архиву
+     * @throws std::runtime_error Если файл не открывается или повреждён
+     */
+    explicit ArchiveReader(const std::string& path);
+    ~ArchiveReader();
+
+    ArchiveReader(const ArchiveReader&) = delete;
+    ArchiveReader& operator=(const ArchiveReader&) = delete;
+
+    /**
+     * Ищет запись по закодированному содержимому
+     * @return Запись или nullptr, если содержимого в архиве нет
+     */
+    const ArchiveEntry* find(const char* content, size_t length) const;
+    const ArchiveEntry* find(const std::string& content) const {
+        return find(content.data(), content.size());
+    }
+
+    /**
+     * Изображение записи (data_length байт в отображённой памяти)
+     */
+    const char* data(const ArchiveEntry& entry) const { return base_ + entry.data_offset; }
+
+    /**
+     * Параметры генерации, с которыми собран архив (QRGenerator::renderKey)
+     */
+    std::string options() const { return std::string(strings_, header_->options_length); }
+
+    uint32_t entryCount() const { return header_->entry_count; }
+    int fd() const { return fd_; }
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    const char* base_ = nullptr;
+    size_t size_ = 0;
+    const ArchiveHeader* header_ = nullptr;
+    const ArchiveEntry* entries_ = nullptr;
+    const char* strings_ = nullptr;
+    int bucket_bits_ = 0;
+    std::vector<uint32_t> buckets_;   // начало корзины в индексе, последний элемент — entry_count
+};
+
+#endif // QR_ARCHIVE_H
@@ -0,0 +1,100 @@
+#include "qr_arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace {
+
+thread_local QRArena thread_arena;
+thread_local QRArena* active_arena = nullptr;
+thread_local int scope_depth = 0;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+QRArena::~QRArena() {
+    for (const Block& block : blocks_) {
+        ::operator delete(block.data);
+    }
+}
+
+void* QRArena::allocate(size_t bytes, size_t alignment) {
+    // Блоки выровнены по max_align_t, поэтому хватает выравнивания смещения
+    alignment = std::max<size_t>(alignment, 1);
+    while (block_ < blocks_.size()) {
+        const size_t start = alignUp(offset_, alignment);
+        if (start + bytes <= blocks_[block_].size) {
+            offset_ = start + bytes;
+            return blocks_[block_].data + start;
+        }
+        block_++;
+        offset_ = 0;
+    }
+
+    const size_t size = std::max(BLOCK_SIZE, alignUp(bytes, alignof(std::max_align_t)));
+    blocks_.push_back(Block{static_cast<char*>(::operator new(size)), size});
+    block_ = blocks_.size() - 1;
+    offset_ = bytes;
+    return blocks_[block_].data;
+}
+
+void QRArena::reset() {
+    size_t kept = 0;
+    size_t retained = 0;
+    for (const Block& block : blocks_) {
+        if (retained + block.size <= RETAIN_BYTES) {
+            blocks_[kept++] = block;
+            retained += block.size;
+        } else {
+            ::operator delete(block.data);
+        }
+    }
+    blocks_.resize(kept);
+    block_ = 0;
+    offset_ = 0;
+}
+
+size_t QRArena::used() const {
+    size_t total = offset_;
+    for (size_t i = 0; i < block_ && i < blocks_.size(); i++) {
+        total += blocks_[i].size;
+    }
+    return total;
+}
+
+size_t QRArena::capacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks_) {
+        total += block.size;
+    }
+    return total;
+}
+
+QRArena* QRArena::current() {
+    return active_arena;
+}
+
+QRArena::Scope::Scope() : owner_(scope_depth++ == 0) {
+    if (owner_) {
+        active_arena = &thread_arena;
+    }
+}
+
+QRArena::Scope::~Scope() {
+    scope_depth--;
+    if (owner_) {
+        active_arena = nullptr;
+        thread_arena.reset();
+    }
+}
+
+QRArena::Suspend::Suspend() : saved_(active_arena) {
+    active_arena = nullptr;
+}
+
+QRArena::Suspend::~Suspend() {
+    active_arena = saved_;
+}
@@ -0,0 +1,139 @@
+#ifndef QR_ARENA_H
+#define QR_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * Монотонная арена рабочей памяти одного запроса.
+ *
+ * У каждого потока своя арена. QRArena::Scope открывает её на время
+ * запроса: промежуточные буферы кодирования и растеризации (ArenaVector,
+ * матрицы QRMatrix) берутся из неё сдвигом указателя, освобождение —
+ * пустая операция, а при закрытии области арена целиком сбрасывается.
+ * Блоки остаются у потока, поэтому начиная со второго запроса того же
+ * размера куча не трогается вовсе.
+ *
+ * Вне открытой области ArenaAllocator работает как std::allocator, так
+ * что те же типы можно использовать и для долгоживущих данных.
+ */
+class QRArena {
+public:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+    static const size_t RETAIN_BYTES = 4 * 1024 * 1024;   // больше этого после сброса не держим
+
+    QRArena() = default;
+    ~QRArena();
+    QRArena(const QRArena&) = delete;
+    QRArena& operator=(const QRArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+
+    /**
+     * Освобождает всё выделенное; блоки до RETAIN_BYTES остаются для следующего запроса
+     */
+    void reset();
+
+    size_t used() const;
+    size_t capacity() const;
+
+    /**
+     * Арена текущего потока, если открыта область Scope, иначе nullptr
+     */
+    static QRArena* current();
+
+    /**
+     * Область запроса. Вложенные области ничего не делают: память
+     * освобождается при закрытии внешней.
+     */
+    class Scope {
+    public:
+        Scope();
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        bool owner_;
+    };
+
+    /**
+     * Временно отключает арену: выделенное внутри переживёт область запроса
+     * (например, разметки версий, которые строятся один раз на процесс)
+     */
+    class Suspend {
+    public:
+        Suspend();
+        ~Suspend();
+        Suspend(const Suspend&) = delete;
+        Suspend& operator=(const Suspend&) = delete;
+
+    private:
+        QRArena* saved_;
+    };
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks_;
+    size_t block_ = 0;    // текущий блок
+    size_t offset_ = 0;   // занято в текущем блоке
+};
+
+/**
+ * Распределитель для контейнеров: запоминает арену, открытую при его
+ * создании, и без неё обращается к куче. Копия контейнера берёт арену,
+ * открытую в момент копирования, а не арену оригинала.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    ArenaAllocator() : arena_(QRArena::current()) {}
+    explicit ArenaAllocator(QRArena* arena) : arena_(arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+    T* allocate(size_t count) {
+        if (arena_) {
+            return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+        }
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* pointer, size_t count) {
+        if (!arena_) {
+            std::allocator<T>().deallocate(pointer, count);
+        }
+    }
+
+    ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+
+    QRArena* arena() const { return arena_; }
+
+private:
+    QRArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena() != b.arena();
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif // QR_ARENA_H
@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <climits>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "batch_input.h"
+#include "bounded_queue.h"
+#include "command_line.h"
+#include "qr_archive.h"
+#include "qr_generator.h"
+
+/**
+ * Пакетная генерация QR-кодов из CSV или NDJSON без сервера.
+ *
+ * Конвейер из четырёх стадий, между ними — ограниченные очереди пачек
+ * записей (обратное давление: быстрая стадия ждёт медленную, память
+ * не растёт):
+ *   разбор (1 поток, вход через mmap) -> кодирование (N потоков) ->
+ *   растеризация и сжатие (M потоков) -> запись (1 поток).
+ */
+
+struct BatchConfig {
+    std::string input;
+    BatchInput::Format input_format = BatchInput::FORMAT_CSV;
+    bool input_format_set = false;
+    bool csv_header = false;
+    std::string out_dir;                   // по файлу на запись
+    std::string archive;                   // или один упакованный архив
+    size_t encoders = 0;                   // 0 — по числу ядер
+    size_t renderers = 0;                  // 0 — по числу ядер
+    size_t queue_capacity = 16;            // пачек в каждой очереди
+    size_t chunk = 256;                    // записей в пачке
+    double report_interval = 1.0;          // секунд между строками прогресса, 0 — выключено
+    Logger::LogLevel log_level = Logger::WARNING;
+    QRGenerator::Backend backend = QRGenerator::BACKEND_LIBQRENCODE;
+    QROutput::Format format = QROutput::FORMAT_PNG;
+    RasterOptions raster = {4, 4, 1};
+    PNGWriter::Compression png_compression = PNGWriter::COMPRESSION_FAST;
+    EncodeOptions encoding;
+};
+
+/**
+ * Пачка записей, переходящая от стадии к стадии целиком
+ */
+struct BatchJob {
+    std::vector<BatchRecord> records;
+    std::vector<QRMatrix> matrices;
+    std::vector<std::string> images;
+    std::vector<std::string> errors;   // пустая строка — запись без ошибок
+};
+
+typedef BoundedQueue<std::unique_ptr<BatchJob>> JobQueue;
+
+struct BatchProgress {
+    std::atomic<uint64_t> parsed{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> input_bytes{0};    // позиция разбора во входном файле
+    std::atomic<uint64_t> output_bytes{0};
+};
+
+// Пределы параметров: больше потоков и пачек не даёт ничего, кроме памяти
+const long long MAX_THREADS = 1024;
+const long long MAX_QUEUE = 1 << 16;
+const long long MAX_CHUNK = 1 << 20;
+
+static void print_usage(const char* prog) {
+    std::cout << "Usage: " << prog << " --input FILE (--out-dir DIR | --archive FILE)"
+              << " [--input-format csv|ndjson] [--csv-header 0|1]"
+              << " [--encoders N] [--renderers N] [--queue N] [--chunk N]"
+              << " [--report-interval SEC] [--log-level debug|info|warning|error]"
+              << " [--backend libqrencode|native] [--format png|svg|pbm|raw]"
+              << " [--scale N] [--margin N] [--bit-depth 1|8]"
+              << " [--png-compression store|fast|best]"
+              << " [--ec-level L|M|Q|H] [--min-version N] [--max-version N]"
+              << " [--mask 0-7] [--byte-mode 0|1]" << std::endl;
+}
+
+static BatchConfig parse_args(int argc, char* argv[]) {
+    BatchConfig config;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                print_usage(argv[0]);
+                exit(EXIT_SUCCESS);
+            }
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg);
+            }
+            std::string value = argv[++i];
+            if (arg == "--input") {
+                config.input = value;
+            } else if (arg == "--input-format") {
+                config.input_format = BatchInput::parseFormat(value);
+                config.input_format_set = true;
+            } else if (arg == "--csv-header") {
+                config.csv_header = parseNumber(arg, value, 0, 1) != 0;
+            } else if (arg == "--out-dir") {
+                config.out_dir = value;
+            } else if (arg == "--archive") {
+                config.archive = value;
+            } else if (arg == "--encoders") {
+                config.encoders = parseNumber(arg, value, 0, MAX_THREADS);
+            } else if (arg == "--renderers") {
+                config.renderers = parseNumber(arg, value, 0, MAX_THREADS);
+            } else if (arg == "--queue") {
+                config.queue_capacity = parseNumber(arg, value, 1, MAX_QUEUE);
+            } else if (arg == "--chunk") {
+                config.chunk = parseNumber(arg, value, 1, MAX_CHUNK);
+            } else if (arg == "--report-interval") {
+                config.report_interval = parseDecimal(arg, value, 0, 86400);
+            } else if (arg == "--log-level") {
+                config.log_level = Logger::parseLevel(value);
+            } else if (arg == "--backend") {
+                config.backend = QRGenerator::parseBackend(value);
+            } else if (arg == "--format") {
+                config.format = QROutput::parseFormat(value);
+            } else if (arg == "--scale") {
+                config.raster.scale = parseNumber(arg, value, 1, INT_MAX);
+            } else if (arg == "--margin") {
+                config.raster.margin = parseNumber(arg, value, 0, INT_MAX);
+            } else if (arg == "--bit-depth") {
+                config.raster.bit_depth = parseNumber(arg, value, 1, INT_MAX);
+            } else if (arg == "--png-compression") {
+                config.png_compression = PNGWriter::parseCompression(value);
+            } else if (arg == "--ec-level") {
+                config.encoding.level = QREncoder::parseLevel(value);
+            } else if (arg == "--min-version") {
+                config.encoding.min_version = parseNumber(arg, value, QREncoder::MIN_VERSION,
+                                                          QREncoder::MAX_VERSION);
+            } else if (arg == "--max-version") {
+                config.encoding.max_version = parseNumber(arg, value, QREncoder::MIN_VERSION,
+                                                          QREncoder::MAX_VERSION);
+            } else if (arg == "--mask") {
+                config.encoding.mask = parseNumber(arg, value, 0, 7);
+            } else if (arg == "--byte-mode") {
+                config.encoding.optimize_segments = parseNumber(arg, value, 0, 1) == 0;
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+        QRRaster::validate(config.raster);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (config.input.empty() || config.out_dir.empty() == config.archive.empty()) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (!config.input_format_set) {
+        config.input_format = BatchInput::formatForPath(config.input);
+    }
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    if (config.encoders == 0) config.encoders = cores;
+    if (config.renderers == 0) config.renderers = cores;
+    return config;
+}
+
+// Имя файла записи: номер во входе и идентификатор без символов, опасных
+// в путях. Номер делает имя уникальным: повторяющиеся идентификаторы и
+// совпадающие после замены символов ("a/b" и "a_b") или обрезки не
+// перезаписывают друг друга, а повторный запуск пишет в те же файлы
+static std::string output_name(const BatchRecord& record) {
+    std::string name = std::to_string(record.number);
+    std::string id = record.name.substr(0, 200);
+    for (char& c : id) {
+        bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                    c == '-' || c == '_' || c == '.';
+        if (!safe) c = '_';
+    }
+    if (!id.empty()) {
+        name += '-';
+        name += id;
+    }
+    return name;
+}
+
+static void write_file(const std::string& path, const std::string& data) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create " + path + ": " + strerror(errno));
+        throw std::runtime_error("Failed to create " + path);
+    }
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t written = write(fd, data.data() + done, data.size() - done);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            close(fd);
+            LOG_ERROR("Failed to write " + path + ": " + strerror(errno));
+            throw std::runtime_error("Failed to write " + path);
+        }
+        done += static_cast<size_t>(written);
+    }
+    if (close(fd) != 0) {
+        LOG_ERROR("Failed to close " + path + ": " + strerror(errno));
+        throw std::runtime_error("Failed to close " + path);
+    }
+}
+
+/**
+ * Потоки одной стадии: последний завершившийся закрывает очередь
+ * следующей стадии, чтобы та дочитала остаток и тоже завершилась
+ */
+class Stage {
+public:
+    Stage(size_t threads, JobQueue* next) : remaining_(threads), next_(next) {}
+
+    void finished() {
+        if (remaining_.fetch_sub(1) == 1 && next_) {
+            next_->close();
+        }
+    }
+
+private:
+    std::atomic<size_t> remaining_;
+    JobQueue* next_;
+};
+
+static void parse_stage(BatchInput& input, const BatchConfig& config, JobQueue& out,
+                        BatchProgress& progress) {
+    std::unique_ptr<BatchJob> job(new BatchJob);
+    BatchRecord record;
+    while (true) {
+        bool more;
+        try {
+            more = input.next(record);
+        } catch (const BatchInputException& e) {
+            LOG_ERROR("Skipping malformed input record, " + std::string(e.what()));
+            progress.failed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (more) {
+            job->records.push_back(std::move(record));
+            record = BatchRecord();
+            progress.parsed.fetch_add(1, std::memory_order_relaxed);
+        }
+        progress.input_bytes.store(input.position(), std::memory_order_relaxed);
+
+        if (job->records.size() >= config.chunk || (!more && !job->records.empty())) {
+            if (!out.push(std::move(job))) {
+                return;   // конвейер остановлен ошибкой записи
+            }
+            job.reset(new BatchJob);
+        }
+        if (!more) {
+            return;
+        }
+    }
+}
+
+static void encode_stage(const BatchConfig& config, JobQueue& in, JobQueue& out) {
+    std::unique_ptr<BatchJob> job;
+    while (in.pop(job)) {
+        const size_t count = job->records.size();
+        job->matrices.resize(count);
+        job->errors.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            try {
+                // Рабочие буферы кодировщика — в арене потока; готовая матрица
+                // копируется в кучу, потому что уходит в другой поток
+                QRArena::Scope scope;
+                QRMatrix matrix = QRGenerator::encodeMatrix(job->records[i].content,
+                                                            config.backend, config.encoding);
+                QRArena::Suspend suspend;
+                job->matrices[i] = QRMatrix(matrix);
+            } catch (const std::exception& e) {
+                job->errors[i] = e.what();
+            }
+        }
+        if (!out.push(std::move(job))) {
+            return;
+        }
+    }
+}
+
+static void render_stage(const BatchConfig& config, JobQueue& in, JobQueue& out) {
+    std::unique_ptr<BatchJob> job;
+    while (in.pop(job)) {
+        const size_t count = job->records.size();
+        job->images.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            if (!job->errors[i].empty()) continue;
+            try {
+                QRArena::Scope scope;
+                QROutput::encode(job->matrices[i], config.format, config.raster,
+                                 config.png_compression, job->images[i]);
+            } catch (const std::exception& e) {
+                job->errors[i] = e.what();
+            }
+        }
+        // Матрицы больше не нужны — память освобождается здесь, а не в записи
+        std::vector<QRMatrix>().swap(job->matrices);
+        if (!out.push(std::move(job))) {
+            return;
+        }
+    }
+}
+
+static bool write_stage(const BatchConfig& config, ArchiveWriter* archive, JobQueue& in,
+                        BatchProgress& progress) {
+    const char* extension = QROutput::formatName(config.format);
+    std::unique_ptr<BatchJob> job;
+    try {
+        while (in.pop(job)) {
+            for (size_t i = 0; i < job->records.size(); i++) {
+                const BatchRecord& record = job->records[i];
+                if (!job->errors[i].empty()) {
+                    LOG_ERROR("Record " + std::to_string(record.number) + " (" + record.name +
+                              ") failed: " + job->errors[i]);
+                    progress.failed.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                const std::string& image = job->images[i];
+                if (archive) {
+                    archive->append(record.name, record.content,
+                                    static_cast<uint8_t>(config.format), image);
+                } else {
+                    write_file(config.out_dir + "/" + output_name(record) + "." + extension,
+                               image);
+                }
+                progress.written.fetch_add(1, std::memory_order_relaxed);
+                progress.output_bytes.fetch_add(image.size(), std::memory_order_relaxed);
+            }
+        }
+        if (archive) {
+            archive->finish();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Output error: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void report(const BatchProgress& progress, uint64_t input_size, double seconds,
+                   const JobQueue& encode_queue, const JobQueue& render_queue,
+                   const JobQueue& write_queue) {
+    const uint64_t written = progress.written.load(std::memory_order_relaxed);
+    const uint64_t input = progress.input_bytes.load(std::memory_order_relaxed);
+    const double elapsed = std::max(seconds, 1e-9);
+    char line[256];
+    snprintf(line, sizeof(line),
+             "%5.1f%%  %llu written  %llu failed  %.0f rec/s  in %.1f MB/s  out %.1f MB/s"
+             "  queues %zu/%zu/%zu",
+             input_size ? 100.0 * input / input_size : 100.0,
+             static_cast<unsigned long long>(written),
+             static_cast<unsigned long long>(progress.failed.load(std::memory_order_relaxed)),
+             written / elapsed, input / elapsed / 1e6,
+             progress.output_bytes.load(std::memory_order_relaxed) / elapsed / 1e6,
+             encode_queue.size(), render_queue.size(), write_queue.size());
+    std::cerr << line << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BatchConfig config = parse_args(argc, argv);
+
+    Logger::getInstance().init("qr_batch.log");
+    Logger::setLevel(config.log_level);
+
+    std::unique_ptr<BatchInput> input;
+    std::unique_ptr<ArchiveWriter> archive;
+    try {
+        input.reset(new BatchInput(config.input, config.input_format, config.csv_header));
+        if (!config.archive.empty()) {
+            archive.reset(new ArchiveWriter(
+                config.archive, QRGenerator::renderKey(config.raster, config.format,
+                                                       config.encoding)));
+        } else if (mkdir(config.out_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Failed to create " + config.out_dir + ": " +
+                                     strerror(errno));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    LOG_INFO("Batch generation from " + config.input + ", " + std::to_string(config.encoders) +
+             " encoders, " + std::to_string(config.renderers) + " renderers");
+
+    JobQueue encode_queue(config.queue_capacity);
+    JobQueue render_queue(config.queue_capacity);
+    JobQueue write_queue(config.queue_capacity);
+    Stage encoders(config.encoders, &render_queue);
+    Stage renderers(config.renderers, &write_queue);
+    BatchProgress progress;
+    const auto started = std::chrono::steady_clock::now();
+    auto elapsed = [&started] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    };
+
+    std::vector<std::thread> threads;
+    threads.emplace_back([&] {
+        parse_stage(*input, config, encode_queue, progress);
+        encode_queue.close();
+    });
+    for (size_t i = 0; i < config.encoders; i++) {
+        threads.emplace_back([&] {
+            encode_stage(config, encode_queue, render_queue);
+            encoders.finished();
+        });
+    }
+    for (size_t i = 0; i < config.renderers; i++) {
+        threads.emplace_back([&] {
+            render_stage(config, render_queue, write_queue);
+            renderers.finished();
+        });
+    }
+
+    std::mutex report_mutex;
+    std::condition_variable report_cv;
+    bool done = false;
+    std::thread reporter;
+    if (config.report_interval > 0) {
+        reporter = std::thread([&] {
+            std::unique_lock<std::mutex> lock(report_mutex);
+            const auto interval = std::chrono::duration<double>(config.report_interval);
+            while (!report_cv.wait_for(lock, interval, [&done] { return done; })) {
+                report(progress, input->size(), elapsed(), encode_queue, render_queue,
+                       write_queue);
+            }
+        });
+    }
+
+    // Запись — в главном потоке; при ошибке вывода останавливаем все стадии
+    bool ok = write_stage(config, archive.get(), write_queue, progress);
+    if (!ok) {
+        encode_queue.close();
+        render_queue.close();
+        write_queue.close();
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(report_mutex);
+        done = true;
+    }
+    report_cv.notify_all();
+    if (reporter.joinable()) {
+        reporter.join();
+    }
+
+    const double seconds = elapsed();
+    report(progress, input->size(), seconds, encode_queue, render_queue, write_queue);
+    const uint64_t failed = progress.failed.load();
+    std::cerr << progress.written.load() << " written, " << failed << " failed in " << seconds
+              << " s" << std::endl;
+    LOG_INFO("Batch finished: " + std::to_string(progress.written.load()) + " written, " +
+             std::to_string(failed) + " failed");
+    return ok && failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,674 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "metrics.h"
+#include "protocol.h"
+#include "qr_generator.h"
+
+/**
+ * Генератор нагрузки для qr_server по бинарному протоколу.
+ *
+ * Каждое соединение воспроизводит смесь запросов (ссылки, координаты,
+ * короткие и длинные строки, небольшой набор повторяющихся — попадания
+ * в кэш) в одном из режимов:
+ *   closed — на соединении всегда pipeline запросов в полёте, следующий
+ *            уходит сразу после ответа;
+ *   open   — запросы уходят по расписанию с общей частотой --rate
+ *            независимо от ответов. Задержка считается от момента по
+ *            расписанию, а не от фактической отправки, поэтому отставание
+ *            клиента от перегруженного сервера не прячет очередь
+ *            (coordinated omission).
+ *
+ * Каждый ответ сверяется байт в байт с изображением, построенным
+ * локально той же libqr с теми же параметрами, — расхождения с текущим
+ * сервером видны до выкатки. Параметры (--backend, --scale, ...) должны
+ * совпадать с параметрами сервера.
+ */
+
+namespace {
+
+enum PayloadClass {
+    CLASS_TEXT,     // ссылка средней длины
+    CLASS_GEO,      // координаты (FRAME_GEO)
+    CLASS_SHORT,    // 1-8 символов
+    CLASS_LONG,     // 1-2 КБ, старшие версии
+    CLASS_REPEAT,   // 16 строк по кругу — попадания в кэш сервера
+    CLASS_COUNT
+};
+
+const char* const CLASS_NAMES[CLASS_COUNT] = {"text", "geo", "short", "long", "repeat"};
+const size_t REPEAT_DISTINCT = 16;
+const size_t MAX_OUTSTANDING = 4096;   // предел запросов в полёте на соединение в режиме open
+const int MAX_REPORTED_ERRORS = 5;
+
+struct BenchConfig {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    size_t connections = 16;
+    size_t threads = 0;                // 0 — min(соединения, ядра)
+    double duration = 10.0;            // секунд измерения
+    double warmup = 1.0;               // секунд до начала измерения
+    bool open_loop = false;
+    double rate = 1000.0;              // запросов в секунду на все соединения (open)
+    size_t pipeline = 1;               // запросов в полёте на соединение (closed)
+    unsigned weights[CLASS_COUNT] = {40, 20, 15, 5, 20};
+    size_t distinct = 500;             // разных строк в каждом классе, кроме repeat
+    bool verify = true;
+    double report_interval = 1.0;
+    uint64_t seed = 1;
+    QRGenerator::Backend backend = QRGenerator::BACKEND_LIBQRENCODE;
+    QROutput::Format format = QROutput::FORMAT_PNG;
+    RasterOptions raster = {4, 4, 1};
+    PNGWriter::Compression png_compression = PNGWriter::COMPRESSION_FAST;
+};
+
+struct Payload {
+    uint8_t type;
+    std::string data;
+    std::string expected;   // ожидаемое изображение, если включена сверка
+};
+
+struct Corpus {
+    std::vector<Payload> classes[CLASS_COUNT];
+    unsigned cumulative[CLASS_COUNT];   // нарастающие веса для выбора класса
+    unsigned total_weight = 0;
+};
+
+// xorshift64*: быстрый и воспроизводимый по --seed
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state_(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+    uint64_t next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545F4914F6CDD1Dull;
+    }
+
+    size_t below(size_t bound) { return static_cast<size_t>(next() % bound); }
+
+private:
+    uint64_t state_;
+};
+
+struct Stats {
+    Metrics::Histogram latency;
+    Metrics::Histogram classes[CLASS_COUNT];
+    uint64_t ok = 0;
+    uint64_t errors = 0;
+    uint64_t busy = 0;
+    uint64_t mismatches = 0;
+    uint64_t protocol_errors = 0;
+    uint64_t bytes = 0;
+};
+
+void recordLatency(Metrics::Histogram& histogram, uint64_t nanos) {
+    histogram.count++;
+    histogram.sum += nanos;
+    histogram.max = std::max(histogram.max, nanos);
+    histogram.buckets[Metrics::bucketIndex(nanos)]++;
+}
+
+void mergeHistogram(Metrics::Histogram& target, const Metrics::Histogram& source) {
+    target.count += source.count;
+    target.sum += source.sum;
+    target.max = std::max(target.max, source.max);
+    for (size_t i = 0; i < Metrics::BUCKET_COUNT; i++) {
+        target.buckets[i] += source.buckets[i];
+    }
+}
+
+uint64_t clockNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [--host HOST] [--port N] [--connections N] [--threads N]"
+              << " [--duration SEC] [--warmup SEC] [--mode closed|open] [--rate REQ_PER_SEC]"
+              << " [--pipeline N] [--mix text,geo,short,long,repeat] [--distinct N]"
+              << " [--verify 0|1] [--report-interval SEC] [--seed N]"
+              << " [--backend libqrencode|native] [--format png|svg|pbm|raw]"
+              << " [--scale N] [--margin N] [--bit-depth 1|8]"
+              << " [--png-compression store|fast|best]" << std::endl;
+}
+
+// Веса классов через запятую в порядке text,geo,short,long,repeat
+void parseMix(const std::string& value, unsigned* weights) {
+    size_t start = 0;
+    for (int i = 0; i < CLASS_COUNT; i++) {
+        size_t comma = value.find(',', start);
+        if ((comma == std::string::npos) != (i == CLASS_COUNT - 1)) {
+            throw std::runtime_error("--mix needs " + std::to_string(CLASS_COUNT) + " weights");
+        }
+        weights[i] = static_cast<unsigned>(std::stoul(value.substr(start, comma - start)));
+        start = comma + 1;
+    }
+}
+
+BenchConfig parseArgs(int argc, char* argv[]) {
+    BenchConfig config;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                exit(EXIT_SUCCESS);
+            }
+            if (i + 1 >= argc) {
+                printUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            std::string value = argv[++i];
+            if (arg == "--host") {
+                config.host = value;
+            } else if (arg == "--port") {
+                config.port = std::stoi(value);
+            } else if (arg == "--connections") {
+                config.connections = std::max<size_t>(1, std::stoul(value));
+            } else if (arg == "--threads") {
+                config.threads = std::stoul(value);
+            } else if (arg == "--duration") {
+                config.duration = std::stod(value);
+            } else if (arg == "--warmup") {
+                config.warmup = std::stod(value);
+            } else if (arg == "--mode") {
+                if (value != "open" && value != "closed") throw std::runtime_error("Unknown mode: " + value);
+                config.open_loop = value == "open";
+            } else if (arg == "--rate") {
+                config.rate = std::stod(value);
+            } else if (arg == "--pipeline") {
+                config.pipeline = std::max<size_t>(1, std::stoul(value));
+            } else if (arg == "--mix") {
+                parseMix(value, config.weights);
+            } else if (arg == "--distinct") {
+                config.distinct = std::max<size_t>(1, std::stoul(value));
+            } else if (arg == "--verify") {
+                config.verify = std::stoi(value) != 0;
+            } else if (arg == "--report-interval") {
+                config.report_interval = std::stod(value);
+            } else if (arg == "--seed") {
+                config.seed = std::stoull(value);
+            } else if (arg == "--backend") {
+                config.backend = QRGenerator::parseBackend(value);
+            } else if (arg == "--format") {
+                config.format = QROutput::parseFormat(value);
+            } else if (arg == "--scale") {
+                config.raster.scale = std::stoi(value);
+            } else if (arg == "--margin") {
+                config.raster.margin = std::stoi(value);
+            } else if (arg == "--bit-depth") {
+                config.raster.bit_depth = std::stoi(value);
+            } else if (arg == "--png-compression") {
+                config.png_compression = PNGWriter::parseCompression(value);
+            } else {
+                printUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        QRRaster::validate(config.raster);
+        if (config.open_loop && config.rate <= 0) throw std::runtime_error("--rate must be positive");
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (config.threads == 0) {
+        config.threads = std::min<size_t>(config.connections,
+                                          std::max(1u, std::thread::hardware_concurrency()));
+    }
+    config.threads = std::min(config.threads, config.connections);
+    return config;
+}
+
+std::string randomString(Rng& rng, size_t length, const char* alphabet) {
+    const size_t size = strlen(alphabet);
+    std::string out(length, ' ');
+    for (char& c : out) c = alphabet[rng.below(size)];
+    return out;
+}
+
+Corpus buildCorpus(const BenchConfig& config) {
+    static const char* const ALNUM = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    static const char* const TEXT = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789 .,;:-/?=&%";
+    Rng rng(config.seed);
+    Corpus corpus;
+
+    for (size_t i = 0; i < config.distinct; i++) {
+        corpus.classes[CLASS_TEXT].push_back({FRAME_TEXT,
+            "https://shop.example.com/p/" + std::to_string(rng.below(100000000)) + "?ref=qr&s=" +
+            randomString(rng, 6, ALNUM), ""});
+
+        char geo[64];
+        snprintf(geo, sizeof(geo), "%.6f,%.6f",
+                 (static_cast<long>(rng.below(1799999)) - 899999) / 10000.0,
+                 (static_cast<long>(rng.below(3599999)) - 1799999) / 10000.0);
+        corpus.classes[CLASS_GEO].push_back({FRAME_GEO, geo, ""});
+
+        corpus.classes[CLASS_SHORT].push_back({FRAME_TEXT, randomString(rng, 1 + rng.below(8), ALNUM), ""});
+        corpus.classes[CLASS_LONG].push_back({FRAME_TEXT, randomString(rng, 1024 + rng.below(1024), TEXT), ""});
+    }
+    for (size_t i = 0; i < REPEAT_DISTINCT; i++) {
+        corpus.classes[CLASS_REPEAT].push_back({FRAME_TEXT,
+            "https://example.com/landing/" + std::to_string(i), ""});
+    }
+
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        corpus.total_weight += config.weights[c];
+        corpus.cumulative[c] = corpus.total_weight;
+    }
+    if (corpus.total_weight == 0) {
+        throw std::runtime_error("--mix weights are all zero");
+    }
+
+    if (config.verify) {
+        // Эталоны строятся заранее и параллельно, до начала нагрузки
+        std::vector<Payload*> all;
+        for (auto& payloads : corpus.classes) {
+            for (auto& payload : payloads) all.push_back(&payload);
+        }
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> workers;
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned t = 0; t < cores; t++) {
+            workers.emplace_back([&] {
+                for (size_t i = next++; i < all.size(); i = next++) {
+                    Payload& payload = *all[i];
+                    std::string content = payload.data;
+                    if (payload.type == FRAME_GEO) {
+                        size_t comma = content.find(',');
+                        content = QRGenerator::formatLocation(std::stod(content.substr(0, comma)),
+                                                              std::stod(content.substr(comma + 1)));
+                    }
+                    QRGenerator::generateQRImage(content, payload.expected, config.raster,
+                                                 config.format);
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+    }
+    return corpus;
+}
+
+int connectTo(const BenchConfig& config) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    int rc = getaddrinfo(config.host.c_str(), std::to_string(config.port).c_str(), &hints, &result);
+    if (rc != 0) {
+        throw std::runtime_error("Cannot resolve " + config.host + ": " + gai_strerror(rc));
+    }
+    int fd = -1;
+    for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot connect to " + config.host + ":" + std::to_string(config.port));
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    return fd;
+}
+
+struct Pending {
+    uint8_t payload_class;
+    uint32_t index;
+    uint64_t sent;   // нс; в режиме open — момент по расписанию
+};
+
+struct Connection {
+    int fd = -1;
+    bool closed = false;
+    Rng rng{1};
+    FrameDecoder decoder;
+    std::string output;
+    size_t output_offset = 0;
+    uint32_t next_id = 1;
+    uint64_t next_send = 0;
+    std::unordered_map<uint32_t, Pending> pending;
+};
+
+/**
+ * Поток нагрузки: обслуживает свои соединения через ppoll
+ */
+class LoadThread {
+public:
+    LoadThread(const BenchConfig& config, const Corpus& corpus, std::vector<int> fds,
+               size_t first_index, uint64_t measure_start, uint64_t measure_end)
+        : config_(config), corpus_(corpus), flags_(encodeImageFlags(imageFlags(config))),
+          measure_start_(measure_start), measure_end_(measure_end) {
+        const uint64_t interval = sendInterval();
+        for (size_t i = 0; i < fds.size(); i++) {
+            Connection conn;
+            conn.fd = fds[i];
+            conn.rng = Rng(config.seed * 1000003 + first_index + i);
+            // Расписания соединений сдвинуты, чтобы не отправлять залпами
+            conn.next_send = measure_start - static_cast<uint64_t>(config.warmup * 1e9) +
+                             interval * (first_index + i) / config.connections;
+            connections_.push_back(std::move(conn));
+        }
+    }
+
+    void run() {
+        const uint64_t drain_deadline = measure_end_ + 5000000000ull;
+        std::vector<pollfd> polls(connections_.size());
+        while (true) {
+            const uint64_t now = clockNanos();
+            const bool sending = now < measure_end_;
+            if (!sending && (outstanding() == 0 || now >= drain_deadline)) break;
+
+            uint64_t wake = now + 100000000ull;
+            for (size_t i = 0; i < connections_.size(); i++) {
+                Connection& conn = connections_[i];
+                if (conn.closed) continue;
+                if (sending) {
+                    schedule(conn, now);
+                    if (config_.open_loop) wake = std::min(wake, conn.next_send);
+                }
+                flush(conn);
+                polls[i].fd = conn.closed ? -1 : conn.fd;
+                polls[i].events = POLLIN | (conn.output_offset < conn.output.size() ? POLLOUT : 0);
+                polls[i].revents = 0;
+            }
+            // ppoll, а не poll: миллисекундный таймаут сдвигал бы расписание open
+            const uint64_t after = clockNanos();
+            const uint64_t wait = wake > after ? wake - after : 0;
+            const timespec timeout = {static_cast<time_t>(wait / 1000000000ull),
+                                      static_cast<long>(wait % 1000000000ull)};
+            if (ppoll(polls.data(), polls.size(), &timeout, nullptr) < 0 && errno != EINTR) {
+                perror("ppoll");
+                break;
+            }
+            for (size_t i = 0; i < connections_.size(); i++) {
+                if (polls[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                    receive(connections_[i]);
+                }
+            }
+        }
+        for (Connection& conn : connections_) {
+            stats_.errors += conn.pending.size();   // ответ так и не пришёл
+            if (conn.fd >= 0) close(conn.fd);
+        }
+    }
+
+    const Stats& stats() const { return stats_; }
+    uint64_t completed() const { return completed_.load(std::memory_order_relaxed); }
+
+private:
+    static ImageFlags imageFlags(const BenchConfig& config) {
+        ImageFlags flags;
+        flags.format = static_cast<uint8_t>(config.format);
+        return flags;
+    }
+
+    uint64_t sendInterval() const {
+        return static_cast<uint64_t>(1e9 * config_.connections / config_.rate);
+    }
+
+    size_t outstanding() const {
+        size_t total = 0;
+        for (const Connection& conn : connections_) {
+            if (!conn.closed) total += conn.pending.size();
+        }
+        return total;
+    }
+
+    void schedule(Connection& conn, uint64_t now) {
+        if (config_.open_loop) {
+            const uint64_t interval = sendInterval();
+            while (conn.next_send <= now && conn.pending.size() < MAX_OUTSTANDING) {
+                enqueue(conn, conn.next_send);
+                conn.next_send += interval;
+            }
+        } else {
+            while (conn.pending.size() < config_.pipeline) {
+                enqueue(conn, now);
+            }
+        }
+    }
+
+    void enqueue(Connection& conn, uint64_t sent) {
+        const unsigned pick = static_cast<unsigned>(conn.rng.below(corpus_.total_weight));
+        int payload_class = 0;
+        while (pick >= corpus_.cumulative[payload_class]) payload_class++;
+        const std::vector<Payload>& payloads = corpus_.classes[payload_class];
+        const uint32_t index = static_cast<uint32_t>(conn.rng.below(payloads.size()));
+        const Payload& payload = payloads[index];
+
+        FrameHeader header;
+        header.type = payload.type;
+        header.request_id = conn.next_id++;
+        header.flags = flags_;
+        const size_t offset = beginFrame(conn.output);
+        conn.output.append(payload.data);
+        finishFrame(conn.output, offset, header);
+        conn.pending[header.request_id] = Pending{static_cast<uint8_t>(payload_class), index, sent};
+    }
+
+    void flush(Connection& conn) {
+        while (conn.output_offset < conn.output.size()) {
+            ssize_t n = send(conn.fd, conn.output.data() + conn.output_offset,
+                             conn.output.size() - conn.output_offset, MSG_NOSIGNAL);
+            if (n > 0) {
+                conn.output_offset += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            fail(conn, "send failed");
+            return;
+        }
+        conn.output.clear();
+        conn.output_offset = 0;
+    }
+
+    void receive(Connection& conn) {
+        char buffer[64 * 1024];
+        while (!conn.closed) {
+            ssize_t n = recv(conn.fd, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                conn.decoder.feed(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            fail(conn, n == 0 ? "server closed connection" : "recv failed");
+            return;
+        }
+
+        FrameHeader header;
+        std::string payload;
+        try {
+            while (conn.decoder.next(header, payload)) {
+                complete(conn, header, payload);
+            }
+        } catch (const ProtocolException& e) {
+            fail(conn, e.what());
+        }
+    }
+
+    void complete(Connection& conn, const FrameHeader& header, const std::string& payload) {
+        const uint64_t now = clockNanos();
+        auto it = conn.pending.find(header.request_id);
+        if (it == conn.pending.end() || header.type != FRAME_IMAGE) {
+            stats_.protocol_errors++;
+            return;
+        }
+        const Pending pending = it->second;
+        conn.pending.erase(it);
+        completed_.store(completed_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (pending.sent < measure_start_ || pending.sent >= measure_end_) {
+            return;   // прогрев и хвост не учитываются
+        }
+
+        const Payload& expected = corpus_.classes[pending.payload_class][pending.index];
+        if (header.status == STATUS_BUSY) {
+            stats_.busy++;
+            return;
+        }
+        if (header.status != STATUS_OK) {
+            stats_.errors++;
+            report(conn, "error for \"" + expected.data.substr(0, 40) + "\": " + payload);
+            return;
+        }
+        if (config_.verify && payload != expected.expected) {
+            stats_.mismatches++;
+            report(conn, "mismatch for \"" + expected.data.substr(0, 40) + "\": " +
+                   std::to_string(payload.size()) + " bytes, expected " +
+                   std::to_string(expected.expected.size()));
+            return;
+        }
+        stats_.ok++;
+        stats_.bytes += payload.size();
+        recordLatency(stats_.latency, now - pending.sent);
+        recordLatency(stats_.classes[pending.payload_class], now - pending.sent);
+    }
+
+    void fail(Connection& conn, const std::string& reason) {
+        report(conn, reason);
+        stats_.errors += conn.pending.size();
+        conn.pending.clear();
+        conn.closed = true;
+        close(conn.fd);
+        conn.fd = -1;
+    }
+
+    void report(const Connection&, const std::string& message) {
+        if (reported_++ < MAX_REPORTED_ERRORS) {
+            std::cerr << message << std::endl;
+        }
+    }
+
+    const BenchConfig& config_;
+    const Corpus& corpus_;
+    const uint32_t flags_;
+    const uint64_t measure_start_;
+    const uint64_t measure_end_;
+    std::vector<Connection> connections_;
+    Stats stats_;
+    std::atomic<uint64_t> completed_{0};
+    int reported_ = 0;
+};
+
+void printLatency(const char* name, const Metrics::Histogram& h) {
+    printf("%-8s %9llu  p50 %8.1f  p90 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f\n", name,
+           static_cast<unsigned long long>(h.count), h.percentile(0.5) / 1e3,
+           h.percentile(0.9) / 1e3, h.percentile(0.99) / 1e3, h.percentile(0.999) / 1e3,
+           h.max / 1e3);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config = parseArgs(argc, argv);
+    QRGenerator::setBackend(config.backend);
+    QRGenerator::setPngCompression(config.png_compression);
+    Logger::setLevel(Logger::ERROR);
+
+    Corpus corpus;
+    std::vector<int> fds;
+    try {
+        corpus = buildCorpus(config);
+        for (size_t i = 0; i < config.connections; i++) {
+            fds.push_back(connectTo(config));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const uint64_t start = clockNanos();
+    const uint64_t measure_start = start + static_cast<uint64_t>(config.warmup * 1e9);
+    const uint64_t measure_end = measure_start + static_cast<uint64_t>(config.duration * 1e9);
+
+    std::vector<std::unique_ptr<LoadThread>> loads;
+    for (size_t t = 0; t < config.threads; t++) {
+        const size_t first = config.connections * t / config.threads;
+        const size_t last = config.connections * (t + 1) / config.threads;
+        loads.emplace_back(new LoadThread(config, corpus,
+                                          std::vector<int>(fds.begin() + first, fds.begin() + last),
+                                          first, measure_start, measure_end));
+    }
+    std::vector<std::thread> threads;
+    for (auto& load : loads) {
+        threads.emplace_back(&LoadThread::run, load.get());
+    }
+
+    if (config.report_interval > 0) {
+        uint64_t previous = 0;
+        uint64_t previous_time = start;
+        const auto interval = std::chrono::duration<double>(config.report_interval);
+        while (clockNanos() + interval.count() * 1e9 < measure_end) {
+            std::this_thread::sleep_for(interval);
+            uint64_t completed = 0;
+            for (auto& load : loads) completed += load->completed();
+            const uint64_t now = clockNanos();
+            fprintf(stderr, "%6.1f s  %10.0f req/s\n", (now - start) / 1e9,
+                    (completed - previous) * 1e9 / (now - previous_time));
+            previous = completed;
+            previous_time = now;
+        }
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    Stats total;
+    for (auto& load : loads) {
+        const Stats& stats = load->stats();
+        mergeHistogram(total.latency, stats.latency);
+        for (int c = 0; c < CLASS_COUNT; c++) mergeHistogram(total.classes[c], stats.classes[c]);
+        total.ok += stats.ok;
+        total.errors += stats.errors;
+        total.busy += stats.busy;
+        total.mismatches += stats.mismatches;
+        total.protocol_errors += stats.protocol_errors;
+        total.bytes += stats.bytes;
+    }
+
+    printf("%s loop, %zu connections, %zu threads, %s %.0f, %.1f s measured\n",
+           config.open_loop ? "open" : "closed", config.connections, config.threads,
+           config.open_loop ? "rate" : "pipeline",
+           config.open_loop ? config.rate : static_cast<double>(config.pipeline), config.duration);
+    printf("ok %llu  errors %llu  busy %llu  mismatches %llu  protocol errors %llu%s\n",
+           static_cast<unsigned long long>(total.ok), static_cast<unsigned long long>(total.errors),
+           static_cast<unsigned long long>(total.busy),
+           static_cast<unsigned long long>(total.mismatches),
+           static_cast<unsigned long long>(total.protocol_errors),
+           config.verify ? "" : "  (not verified)");
+    printf("throughput %.1f req/s  %.2f MB/s\n", total.ok / config.duration,
+           total.bytes / config.duration / 1e6);
+    printf("latency, us\n");
+    printLatency("all", total.latency);
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        if (total.classes[c].count) printLatency(CLASS_NAMES[c], total.classes[c]);
+    }
+
+    const bool failed = total.errors || total.mismatches || total.protocol_errors;
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
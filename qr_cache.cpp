@@ -0,0 +1,140 @@
+#include "qr_cache.h"
+#include <functional>
+
+namespace {
+
+// Приблизительные накладные расходы записи: узел списка, узел индекса, ключ
+const size_t ENTRY_OVERHEAD = 128;
+
+} // namespace
+
+QRCache::QRCache(size_t capacity_bytes, size_t shards)
+    : capacity_bytes_(capacity_bytes) {
+    if (shards == 0) shards = 1;
+    shard_capacity_ = capacity_bytes_ / shards;
+    shards_.reserve(shards);
+    for (size_t i = 0; i < shards; i++) {
+        shards_.emplace_back(new Shard());
+    }
+}
+
+std::string QRCache::makeKey(const std::string& content, const std::string& options) {
+    std::string key;
+    key.reserve(options.size() + 1 + content.size());
+    key.append(options);
+    key.push_back('\0');
+    key.append(content);
+    return key;
+}
+
+QRCache::Shard& QRCache::shardFor(const std::string& key) {
+    return *shards_[std::hash<std::string>()(key) % shards_.size()];
+}
+
+size_t QRCache::chargeFor(const std::string& key, const Buffer& value) const {
+    return value->size() + key.size() * 2 + ENTRY_OVERHEAD;
+}
+
+void QRCache::insertLocked(Shard& shard, const std::string& key, Buffer value, size_t charge) {
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        shard.bytes -= it->second->charge;
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+
+    while (!shard.lru.empty() && shard.bytes + charge > shard_capacity_) {
+        Entry& victim = shard.lru.back();
+        shard.bytes -= victim.charge;
+        shard.index.erase(victim.key);
+        shard.lru.pop_back();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shard.lru.push_front(Entry{key, std::move(value), charge});
+    shard.index.emplace(key, shard.lru.begin());
+    shard.bytes += charge;
+}
+
+// Запись по ключу с переносом в начало LRU; промах не учитывается
+QRCache::Buffer QRCache::findLocked(Shard& shard, const std::string& key) {
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        return nullptr;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second->value;
+}
+
+QRCache::Buffer QRCache::getOrCreate(const std::string& key, const Producer& producer,
+                                     bool* coalesced) {
+    if (coalesced) *coalesced = false;
+
+    Shard& shard = shardFor(key);
+    std::promise<Buffer> promise;
+    {
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        if (Buffer cached = findLocked(shard, key)) {
+            return cached;
+        }
+
+        auto flight = shard.in_flight.find(key);
+        if (flight != shard.in_flight.end()) {
+            std::shared_future<Buffer> result = flight->second;
+            lock.unlock();
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+            if (coalesced) *coalesced = true;
+            return result.get();
+        }
+
+        if (enabled()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.in_flight.emplace(key, promise.get_future().share());
+    }
+
+    // Генерация идёт без блокировки сегмента: остальные ключи не ждут
+    Buffer value;
+    try {
+        value = producer();
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.in_flight.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        // Запись в кэш и снятие отметки — под одной блокировкой, чтобы
+        // следующий запрос нашёл либо генерацию, либо готовую запись
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (enabled() && value) {
+            size_t charge = chargeFor(key, value);
+            if (charge <= shard_capacity_) {
+                insertLocked(shard, key, value, charge);
+            }
+        }
+        shard.in_flight.erase(key);
+    }
+    promise.set_value(value);
+    return value;
+}
+
+QRCache::Stats QRCache::stats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+    stats.capacity_bytes = capacity_bytes_;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->index.size();
+        stats.bytes += shard->bytes;
+        stats.in_flight += shard->in_flight.size();
+    }
+    return stats;
+}
@@ -0,0 +1,110 @@
+#ifndef QR_CACHE_H
+#define QR_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Кэш готовых изображений QR-кодов с вытеснением LRU.
+ *
+ * Ключ — то, что реально кодируется (текст или geo:-URI) вместе с
+ * параметрами отрисовки, поэтому одинаковые запросы разными путями
+ * попадают в одну запись. Значения хранятся как shared_ptr на
+ * неизменяемый буфер: выдача из кэша не копирует байты, а вытеснение
+ * не мешает ответам, которые ещё отправляются.
+ *
+ * Кэш разбит на сегменты со своими блокировками, бюджет памяти делится
+ * между сегментами поровну.
+ *
+ * Единственная точка входа — getOrCreate: она же объединяет одновременные
+ * промахи по одному ключу. Изображение строит первый запрос, остальные
+ * ждут его результата и получают тот же буфер. Объединение работает и
+ * при выключенном кэше.
+ */
+class QRCache {
+public:
+    using Buffer = std::shared_ptr<const std::string>;
+
+    using Producer = std::function<Buffer()>;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t coalesced = 0;     // запросов, дождавшихся чужой генерации
+        uint64_t in_flight = 0;     // генераций, идущих сейчас
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+        uint64_t capacity_bytes = 0;
+    };
+
+    /**
+     * @param capacity_bytes Бюджет памяти на все сегменты (0 — кэш выключен)
+     * @param shards Число сегментов
+     */
+    explicit QRCache(size_t capacity_bytes, size_t shards = 16);
+
+    QRCache(const QRCache&) = delete;
+    QRCache& operator=(const QRCache&) = delete;
+
+    /**
+     * Собирает ключ кэша из кодируемого содержимого и параметров отрисовки
+     */
+    static std::string makeKey(const std::string& content, const std::string& options = std::string());
+
+    /**
+     * Возвращает изображение из кэша, а при промахе строит его producer'ом
+     * и кладёт в кэш, вытесняя давно не использованные записи; изображения
+     * больше бюджета сегмента не кэшируются. Если тот же ключ уже строится
+     * в другом потоке, ждёт
+     * его результата вместо повторной генерации.
+     * Исключение producer'а получают все ожидающие этого ключа; в кэш
+     * ничего не попадает, и следующий запрос попробует снова.
+     * @param coalesced Если не nullptr, сюда пишется, был ли результат чужим
+     */
+    Buffer getOrCreate(const std::string& key, const Producer& producer,
+                       bool* coalesced = nullptr);
+
+    bool enabled() const { return capacity_bytes_ > 0; }
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        Buffer value;
+        size_t charge;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;    // в начале — недавно использованные
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        std::unordered_map<std::string, std::shared_future<Buffer>> in_flight;
+        size_t bytes = 0;
+    };
+
+    Shard& shardFor(const std::string& key);
+    size_t chargeFor(const std::string& key, const Buffer& value) const;
+    Buffer findLocked(Shard& shard, const std::string& key);
+    void insertLocked(Shard& shard, const std::string& key, Buffer value, size_t charge);
+
+    size_t capacity_bytes_;
+    size_t shard_capacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> coalesced_{0};
+};
+
+#endif // QR_CACHE_H
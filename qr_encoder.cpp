@@ -0,0 +1,600 @@
+#include "qr_encoder.h"
+#include "qr_mask.h"
+#include "gf256.h"
+#include "logging.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+// Проверочных байт на блок, [уровень][версия]
+const int8_t ECC_CODEWORDS_PER_BLOCK[4][41] = {
+    {-1,  7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28, 28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+    {-1, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26, 26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28},
+    {-1, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24, 28, 26, 24, 20, 30, 24, 28, 28, 26, 30, 28, 30, 30, 30, 30, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+    {-1, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28, 24, 28, 22, 24, 24, 30, 28, 28, 26, 28, 30, 24, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+};
+
+// Число блоков коррекции, [уровень][версия]
+const int8_t NUM_ERROR_CORRECTION_BLOCKS[4][41] = {
+    {-1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 4, 6, 6, 6, 6, 7, 8, 8, 9, 9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25},
+    {-1, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5, 5, 8, 9, 9, 10, 10, 11, 13, 14, 16, 17, 17, 18, 20, 21, 23, 25, 26, 28, 29, 31, 33, 35, 37, 38, 40, 43, 45, 47, 49},
+    {-1, 1, 1, 2, 2, 4, 4, 6, 6, 8, 8, 8, 10, 12, 16, 12, 17, 16, 18, 21, 20, 23, 23, 25, 27, 29, 34, 34, 35, 38, 40, 43, 45, 48, 51, 53, 56, 59, 62, 65, 68},
+    {-1, 1, 1, 2, 4, 4, 4, 5, 6, 8, 8, 11, 11, 16, 16, 18, 16, 19, 21, 25, 25, 25, 34, 30, 32, 35, 37, 40, 42, 45, 48, 51, 54, 57, 60, 63, 66, 70, 74, 77, 81},
+};
+
+// Биты уровня коррекции в слове формата
+const int FORMAT_EC_BITS[4] = {1, 0, 3, 2};
+
+// Число модулей под данные и коррекцию (без служебных узоров)
+int rawDataModules(int version) {
+    int result = (16 * version + 128) * version + 64;
+    if (version >= 2) {
+        int num_align = version / 7 + 2;
+        result -= (25 * num_align - 10) * num_align - 55;
+        if (version >= 7) {
+            result -= 36;
+        }
+    }
+    return result;
+}
+
+std::vector<int> alignmentPositions(int version) {
+    if (version == 1) {
+        return std::vector<int>();
+    }
+    int num_align = version / 7 + 2;
+    int step = (version == 32) ? 26 : (version * 4 + num_align * 2 + 1) / (num_align * 2 - 2) * 2;
+    int size = version * 4 + 17;
+
+    std::vector<int> result(num_align);
+    result[0] = 6;
+    for (int i = num_align - 1, pos = size - 7; i >= 1; i--, pos -= step) {
+        result[i] = pos;
+    }
+    return result;
+}
+
+/**
+ * Разметка версии: строится один раз и используется всеми потоками
+ */
+struct VersionLayout {
+    QRMatrix base;                       // служебные узоры, область формата пуста
+    QRMatrix function;                   // 1 — служебный модуль
+    std::vector<uint16_t> data_order;    // (y << 8) | x в порядке размещения битов
+    QRMatrix masks[8];                   // маски, обрезанные по области данных
+};
+
+void setFunction(VersionLayout& layout, int x, int y, bool dark) {
+    layout.base.set(x, y, dark);
+    layout.function.set(x, y, true);
+}
+
+bool maskBit(int mask, int x, int y) {
+    switch (mask) {
+        case 0: return (x + y) % 2 == 0;
+        case 1: return y % 2 == 0;
+        case 2: return x % 3 == 0;
+        case 3: return (x + y) % 3 == 0;
+        case 4: return (x / 3 + y / 2) % 2 == 0;
+        case 5: return x * y % 2 + x * y % 3 == 0;
+        case 6: return (x * y % 2 + x * y % 3) % 2 == 0;
+        case 7: return ((x + y) % 2 + x * y % 3) % 2 == 0;
+    }
+    return false;
+}
+
+std::unique_ptr<VersionLayout> buildLayout(int version) {
+    std::unique_ptr<VersionLayout> layout(new VersionLayout());
+    layout->base = QRMatrix(version);
+    layout->function = QRMatrix(version);
+    const int size = layout->base.size();
+
+    // Синхронизирующие линии
+    for (int i = 0; i < size; i++) {
+        setFunction(*layout, 6, i, i % 2 == 0);
+        setFunction(*layout, i, 6, i % 2 == 0);
+    }
+
+    // Поисковые узоры вместе с разделителями
+    const int finders[3][2] = {{3, 3}, {size - 4, 3}, {3, size - 4}};
+    for (const auto& center : finders) {
+        for (int dy = -4; dy <= 4; dy++) {
+            for (int dx = -4; dx <= 4; dx++) {
+                int x = center[0] + dx;
+                int y = center[1] + dy;
+                if (x < 0 || x >= size || y < 0 || y >= size) continue;
+                int dist = std::max(std::abs(dx), std::abs(dy));
+                setFunction(*layout, x, y, dist != 2 && dist != 4);
+            }
+        }
+    }
+
+    // Выравнивающие узоры
+    std::vector<int> positions = alignmentPositions(version);
+    const int count = static_cast<int>(positions.size());
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < count; j++) {
+            if ((i == 0 && j == 0) || (i == 0 && j == count - 1) || (i == count - 1 && j == 0)) {
+                continue;
+            }
+            for (int dy = -2; dy <= 2; dy++) {
+                for (int dx = -2; dx <= 2; dx++) {
+                    setFunction(*layout, positions[i] + dx, positions[j] + dy,
+                                std::max(std::abs(dx), std::abs(dy)) != 1);
+                }
+            }
+        }
+    }
+
+    // Область формата резервируется светлой, тёмный модуль постоянный
+    for (int i = 0; i <= 8; i++) {
+        if (i != 6) {
+            setFunction(*layout, 8, i, false);
+            setFunction(*layout, i, 8, false);
+        }
+    }
+    for (int i = 0; i < 8; i++) {
+        setFunction(*layout, size - 1 - i, 8, false);
+        setFunction(*layout, 8, size - 1 - i, false);
+    }
+    setFunction(*layout, 8, size - 8, true);
+
+    // Информация о версии (начиная с 7)
+    if (version >= 7) {
+        int rem = version;
+        for (int i = 0; i < 12; i++) {
+            rem = (rem << 1) ^ ((rem >> 11) * 0x1F25);
+        }
+        long bits = static_cast<long>(version) << 12 | rem;
+        for (int i = 0; i < 18; i++) {
+            bool bit = (bits >> i) & 1;
+            int a = size - 11 + i % 3;
+            int b = i / 3;
+            setFunction(*layout, a, b, bit);
+            setFunction(*layout, b, a, bit);
+        }
+    }
+
+    // Порядок размещения данных: пары столбцов справа налево, зигзагом
+    layout->data_order.reserve(rawDataModules(version));
+    for (int right = size - 1; right >= 1; right -= 2) {
+        if (right == 6) right = 5;
+        for (int vert = 0; vert < size; vert++) {
+            for (int j = 0; j < 2; j++) {
+                int x = right - j;
+                bool upward = ((right + 1) & 2) == 0;
+                int y = upward ? size - 1 - vert : vert;
+                if (!layout->function.get(x, y)) {
+                    layout->data_order.push_back(static_cast<uint16_t>((y << 8) | x));
+                }
+            }
+        }
+    }
+
+    for (int mask = 0; mask < 8; mask++) {
+        layout->masks[mask] = QRMatrix(version);
+        for (uint16_t pos : layout->data_order) {
+            int x = pos & 0xFF;
+            int y = pos >> 8;
+            if (maskBit(mask, x, y)) {
+                layout->masks[mask].set(x, y, true);
+            }
+        }
+    }
+    return layout;
+}
+
+const VersionLayout& layoutFor(int version) {
+    static std::once_flag flags[QREncoder::MAX_VERSION + 1];
+    static std::unique_ptr<VersionLayout> layouts[QREncoder::MAX_VERSION + 1];
+    std::call_once(flags[version], [version] {
+        // Разметка живёт до конца процесса, арена запроса для неё не годится
+        QRArena::Suspend suspend;
+        layouts[version] = buildLayout(version);
+    });
+    return *layouts[version];
+}
+
+// Длина поля счётчика символов, [режим][группа версий 1-9, 10-26, 27-40]
+const int CHAR_COUNT_BITS[3][3] = {
+    {10, 12, 14},
+    {9, 11, 13},
+    {8, 16, 16},
+};
+
+// Индикатор режима сегмента
+const uint32_t MODE_INDICATORS[3] = {0x1, 0x2, 0x4};
+
+const char ALPHANUMERIC_SPECIALS[] = " $%*+-./:";
+
+int versionGroup(int version) {
+    return version <= 9 ? 0 : (version <= 26 ? 1 : 2);
+}
+
+int charCountBits(QREncoder::Mode mode, int version) {
+    return CHAR_COUNT_BITS[mode][versionGroup(version)];
+}
+
+// Значение символа в буквенно-цифровом режиме, -1 — символ не кодируется
+int alphanumericValue(unsigned char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    const char* special = c != 0 ? strchr(ALPHANUMERIC_SPECIALS, c) : nullptr;
+    return special ? 36 + static_cast<int>(special - ALPHANUMERIC_SPECIALS) : -1;
+}
+
+bool isDigit(unsigned char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Длина данных сегмента в битах без заголовка
+size_t payloadBits(QREncoder::Mode mode, size_t length) {
+    switch (mode) {
+        case QREncoder::MODE_NUMERIC:
+            return length / 3 * 10 + (length % 3 == 0 ? 0 : (length % 3 == 1 ? 4 : 7));
+        case QREncoder::MODE_ALPHANUMERIC:
+            return length / 2 * 11 + length % 2 * 6;
+        case QREncoder::MODE_BYTE:
+            return length * 8;
+    }
+    return 0;
+}
+
+// Накопитель битов со старшего
+class BitBuffer {
+public:
+    void append(uint32_t value, int bits) {
+        for (int i = bits - 1; i >= 0; i--) {
+            push((value >> i) & 1);
+        }
+    }
+
+    void push(bool bit) {
+        if (length_ % 8 == 0) bytes_.push_back(0);
+        if (bit) bytes_.back() |= static_cast<uint8_t>(0x80 >> (length_ % 8));
+        length_++;
+    }
+
+    size_t length() const { return length_; }
+    ArenaVector<uint8_t>& bytes() { return bytes_; }
+
+private:
+    ArenaVector<uint8_t> bytes_;
+    size_t length_ = 0;
+};
+
+void appendSegment(BitBuffer& bits, const std::string& data, const QREncoder::Segment& segment,
+                   int version) {
+    bits.append(MODE_INDICATORS[segment.mode], 4);
+    bits.append(static_cast<uint32_t>(segment.length), charCountBits(segment.mode, version));
+
+    const char* chars = data.data() + segment.offset;
+    switch (segment.mode) {
+        case QREncoder::MODE_NUMERIC:
+            // Группы по три цифры, остаток из одной или двух — 4 или 7 бит
+            for (size_t i = 0; i < segment.length; i += 3) {
+                const size_t group = std::min<size_t>(3, segment.length - i);
+                uint32_t value = 0;
+                for (size_t j = 0; j < group; j++) value = value * 10 + (chars[i + j] - '0');
+                bits.append(value, static_cast<int>(group * 3 + 1));
+            }
+            break;
+        case QREncoder::MODE_ALPHANUMERIC:
+            for (size_t i = 0; i + 1 < segment.length; i += 2) {
+                bits.append(alphanumericValue(chars[i]) * 45 + alphanumericValue(chars[i + 1]), 11);
+            }
+            if (segment.length % 2) {
+                bits.append(alphanumericValue(chars[segment.length - 1]), 6);
+            }
+            break;
+        case QREncoder::MODE_BYTE:
+            for (size_t i = 0; i < segment.length; i++) {
+                bits.append(static_cast<unsigned char>(chars[i]), 8);
+            }
+            break;
+    }
+}
+
+} // namespace
+
+ArenaVector<QREncoder::Segment> QREncoder::optimizeSegments(const std::string& data, int version) {
+    ArenaVector<Segment> segments;
+    const size_t length = data.size();
+    if (length == 0) {
+        return segments;
+    }
+
+    // Длины в шестых долях бита: цифра — 10/3 бита, буквенно-цифровой
+    // символ — 11/2, байт — 8. Заголовок сегмента — индикатор и счётчик.
+    const uint32_t CHAR_COST[3] = {20, 33, 48};
+    const uint32_t UNREACHABLE = UINT32_MAX / 2;
+    uint32_t head[3];
+    uint32_t cost[3];
+    for (int m = 0; m < 3; m++) {
+        head[m] = (4 + charCountBits(static_cast<Mode>(m), version)) * 6;
+        cost[m] = head[m];
+    }
+
+    // from[i][m] — режим символа i на лучшем пути, который после символа i
+    // находится в режиме m
+    ArenaVector<std::array<uint8_t, 3>> from(length);
+    for (size_t i = 0; i < length; i++) {
+        const unsigned char c = data[i];
+        const bool allowed[3] = {isDigit(c), alphanumericValue(c) >= 0, true};
+        uint32_t encoded[3];
+        for (int m = 0; m < 3; m++) {
+            encoded[m] = allowed[m] ? cost[m] + CHAR_COST[m] : UNREACHABLE;
+            cost[m] = encoded[m];
+            from[i][m] = static_cast<uint8_t>(m);
+        }
+
+        // Новый сегмент после символа i: хвост прежнего округляется до бита
+        for (int to = 0; to < 3; to++) {
+            for (int m = 0; m < 3; m++) {
+                if (m == to || encoded[m] == UNREACHABLE) continue;
+                const uint32_t switched = (encoded[m] + 5) / 6 * 6 + head[to];
+                if (switched < cost[to]) {
+                    cost[to] = switched;
+                    from[i][to] = static_cast<uint8_t>(m);
+                }
+            }
+        }
+    }
+
+    int mode = 0;
+    for (int m = 1; m < 3; m++) {
+        if (cost[m] < cost[mode]) mode = m;
+    }
+
+    // Обратный проход восстанавливает режим каждого символа
+    ArenaVector<uint8_t> modes(length);
+    for (size_t i = length; i-- > 0;) {
+        mode = from[i][mode];
+        modes[i] = static_cast<uint8_t>(mode);
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        if (segments.empty() || segments.back().mode != modes[i]) {
+            segments.push_back(Segment{static_cast<Mode>(modes[i]), i, 0});
+        }
+        segments.back().length++;
+    }
+    return segments;
+}
+
+size_t QREncoder::segmentBits(const ArenaVector<Segment>& segments, int version) {
+    size_t bits = 0;
+    for (const Segment& segment : segments) {
+        bits += 4 + charCountBits(segment.mode, version) + payloadBits(segment.mode, segment.length);
+    }
+    return bits;
+}
+
+int QREncoder::dataCodewords(int version, ECLevel level) {
+    return rawDataModules(version) / 8 -
+           ECC_CODEWORDS_PER_BLOCK[level][version] * NUM_ERROR_CORRECTION_BLOCKS[level][version];
+}
+
+void QREncoder::reedSolomon(const uint8_t* data, size_t length, int ecc_length, uint8_t* ecc) {
+    const auto& divisor = rs_generators.poly[ecc_length];
+    memset(ecc, 0, ecc_length);
+    for (size_t i = 0; i < length; i++) {
+        uint8_t factor = data[i] ^ ecc[0];
+        memmove(ecc, ecc + 1, ecc_length - 1);
+        ecc[ecc_length - 1] = 0;
+        if (factor == 0) continue;
+        const uint8_t log_factor = gf256.log[factor];
+        for (int j = 0; j < ecc_length; j++) {
+            if (divisor[j]) ecc[j] ^= gf256.exp[gf256.log[divisor[j]] + log_factor];
+        }
+    }
+}
+
+ArenaVector<uint8_t> QREncoder::addErrorCorrection(const ArenaVector<uint8_t>& data,
+                                                   int version, ECLevel level) {
+    const int num_blocks = NUM_ERROR_CORRECTION_BLOCKS[level][version];
+    const int ecc_length = ECC_CODEWORDS_PER_BLOCK[level][version];
+    const int raw_codewords = rawDataModules(version) / 8;
+    const int num_short_blocks = num_blocks - raw_codewords % num_blocks;
+    const int short_data_length = raw_codewords / num_blocks - ecc_length;
+
+    ArenaVector<uint8_t> ecc(static_cast<size_t>(num_blocks) * ecc_length);
+    ArenaVector<size_t> block_start(num_blocks);
+    size_t offset = 0;
+    for (int b = 0; b < num_blocks; b++) {
+        int length = short_data_length + (b < num_short_blocks ? 0 : 1);
+        block_start[b] = offset;
+        reedSolomon(&data[offset], length, ecc_length, &ecc[static_cast<size_t>(b) * ecc_length]);
+        offset += length;
+    }
+
+    // Данные блоков по столбцам, затем коррекция по столбцам
+    ArenaVector<uint8_t> result;
+    result.reserve(raw_codewords);
+    for (int i = 0; i <= short_data_length; i++) {
+        for (int b = 0; b < num_blocks; b++) {
+            if (i < short_data_length || b >= num_short_blocks) {
+                result.push_back(data[block_start[b] + i]);
+            }
+        }
+    }
+    for (int i = 0; i < ecc_length; i++) {
+        for (int b = 0; b < num_blocks; b++) {
+            result.push_back(ecc[static_cast<size_t>(b) * ecc_length + i]);
+        }
+    }
+    return result;
+}
+
+void QREncoder::drawFormatBits(QRMatrix& matrix, ECLevel level, int mask) {
+    int data = FORMAT_EC_BITS[level] << 3 | mask;
+    int rem = data;
+    for (int i = 0; i < 10; i++) {
+        rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+    }
+    int bits = (data << 10 | rem) ^ 0x5412;
+    const int size = matrix.size();
+
+    // Первая копия — вокруг левого верхнего поискового узора
+    for (int i = 0; i <= 5; i++) {
+        matrix.set(8, i, (bits >> i) & 1);
+    }
+    matrix.set(8, 7, (bits >> 6) & 1);
+    matrix.set(8, 8, (bits >> 7) & 1);
+    matrix.set(7, 8, (bits >> 8) & 1);
+    for (int i = 9; i < 15; i++) {
+        matrix.set(14 - i, 8, (bits >> i) & 1);
+    }
+
+    // Вторая копия — у правого верхнего и левого нижнего узоров
+    for (int i = 0; i < 8; i++) {
+        matrix.set(size - 1 - i, 8, (bits >> i) & 1);
+    }
+    for (int i = 8; i < 15; i++) {
+        matrix.set(8, size - 15 + i, (bits >> i) & 1);
+    }
+    matrix.set(8, size - 8, true);
+}
+
+void QREncoder::applyMask(QRMatrix& matrix, int mask) {
+    const QRMatrix& pattern = layoutFor(matrix.version()).masks[mask];
+    uint8_t* out = matrix.data();
+    const uint8_t* in = pattern.data();
+    for (size_t i = 0; i < matrix.bytes(); i++) {
+        out[i] ^= in[i];
+    }
+}
+
+QRMatrix QREncoder::buildMatrix(const ArenaVector<uint8_t>& codewords, int version,
+                                ECLevel level, int mask) {
+    const VersionLayout& layout = layoutFor(version);
+    QRMatrix matrix = layout.base;
+
+    const size_t total_bits = codewords.size() * 8;
+    const size_t count = std::min(total_bits, layout.data_order.size());
+    for (size_t i = 0; i < count; i++) {
+        if ((codewords[i >> 3] >> (7 - (i & 7))) & 1) {
+            uint16_t pos = layout.data_order[i];
+            matrix.set(pos & 0xFF, pos >> 8, true);
+        }
+    }
+
+    if (mask != AUTO_MASK) {
+        applyMask(matrix, mask);
+        drawFormatBits(matrix, level, mask);
+        return matrix;
+    }
+
+    // Кандидаты копируются здесь, в потоке запроса: арена не потокобезопасна,
+    // а маски для больших версий считаются параллельно
+    struct Candidates {
+        QRMatrix matrices[8];
+        int penalties[8];
+    } candidates;
+    for (int m = 0; m < 8; m++) {
+        candidates.matrices[m] = matrix;
+    }
+    QRMask::forEachMask([&candidates, level](int m) {
+        QRMatrix& candidate = candidates.matrices[m];
+        applyMask(candidate, m);
+        drawFormatBits(candidate, level, m);
+        candidates.penalties[m] = QRMask::penalty(candidate);
+    }, version >= QRMask::PARALLEL_MIN_VERSION);
+
+    int best = 0;
+    for (int m = 1; m < 8; m++) {
+        if (candidates.penalties[m] < candidates.penalties[best]) best = m;
+    }
+    return std::move(candidates.matrices[best]);
+}
+
+QRMatrix QREncoder::encode(const std::string& data, ECLevel level,
+                           int min_version, int max_version, int mask) {
+    EncodeOptions options;
+    options.level = level;
+    options.min_version = min_version;
+    options.max_version = max_version;
+    options.mask = mask;
+    options.optimize_segments = false;
+    return encode(data, options);
+}
+
+QRMatrix QREncoder::encode(const std::string& data, const EncodeOptions& options) {
+    if (options.level < EC_L || options.level > EC_H) {
+        throw std::invalid_argument("Invalid QR error correction level");
+    }
+    if (options.min_version < MIN_VERSION || options.max_version > MAX_VERSION ||
+        options.min_version > options.max_version) {
+        throw std::invalid_argument("Invalid QR version range");
+    }
+    if (options.mask < AUTO_MASK || options.mask > 7) {
+        throw std::invalid_argument("Invalid QR mask");
+    }
+
+    // Разбиение зависит только от группы версий: пересчитывается при её смене
+    ArenaVector<Segment> segments;
+    size_t needed = 0;
+    int group = -1;
+    int version = options.min_version;
+    for (; version <= options.max_version; version++) {
+        if (versionGroup(version) != group) {
+            group = versionGroup(version);
+            segments = options.optimize_segments ? optimizeSegments(data, version)
+                                                 : ArenaVector<Segment>{{MODE_BYTE, 0, data.size()}};
+            needed = segmentBits(segments, version);
+        }
+        if (needed <= static_cast<size_t>(dataCodewords(version, options.level)) * 8) {
+            break;
+        }
+    }
+    if (version > options.max_version) {
+        LOG_ERROR("Data too long for QR code: " + std::to_string(data.size()) + " bytes");
+        throw std::runtime_error("Data too long for QR code");
+    }
+
+    const size_t capacity = static_cast<size_t>(dataCodewords(version, options.level)) * 8;
+    BitBuffer bits;
+    for (const Segment& segment : segments) {
+        appendSegment(bits, data, segment, version);
+    }
+
+    // Терминатор, выравнивание до байта и заполнители 0xEC/0x11
+    bits.append(0, static_cast<int>(std::min<size_t>(4, capacity - bits.length())));
+    bits.append(0, static_cast<int>((8 - bits.length() % 8) % 8));
+    for (uint8_t pad = 0xEC; bits.length() < capacity; pad ^= 0xEC ^ 0x11) {
+        bits.append(pad, 8);
+    }
+
+    return buildMatrix(addErrorCorrection(bits.bytes(), version, options.level), version,
+                       options.level, options.mask);
+}
+
+QREncoder::ECLevel QREncoder::parseLevel(const std::string& name) {
+    static const char LEVELS[] = "LMQH";
+    if (name.size() == 1 && name[0] != '\0') {
+        if (const char* found = strchr(LEVELS, std::toupper(static_cast<unsigned char>(name[0])))) {
+            return static_cast<ECLevel>(found - LEVELS);
+        }
+    }
+    LOG_ERROR("Unknown error correction level: " + name);
+    throw std::runtime_error("Unknown error correction level: " + name);
+}
+
+const char* QREncoder::levelName(ECLevel level) {
+    static const char* const NAMES[4] = {"L", "M", "Q", "H"};
+    return level >= EC_L && level <= EC_H ? NAMES[level] : "unknown";
+}
+
+std::string EncodeOptions::key() const {
+    return std::string(QREncoder::levelName(level)) + std::to_string(min_version) + "-" +
+           std::to_string(max_version) + "m" +
+           (mask == QREncoder::AUTO_MASK ? std::string("a") : std::to_string(mask)) +
+           (optimize_segments ? "s" : "b");
+}
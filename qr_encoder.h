@@ -0,0 +1,151 @@
+#ifndef QR_ENCODER_H
+#define QR_ENCODER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "qr_arena.h"
+#include "qr_matrix.h"
+
+struct EncodeOptions;
+
+/**
+ * Собственный кодировщик QR-кодов (ISO/IEC 18004), альтернатива libqrencode.
+ *
+ * Коэффициенты Рида-Соломона считаются по таблицам GF(256), построенным
+ * на этапе компиляции (gf256.h). Для каждой версии один раз строится
+ * разметка: служебные узоры, порядок размещения данных и восемь масок,
+ * уже совмещённых с областью данных, — наложение маски сводится
+ * к побайтовому XOR упакованных строк.
+ */
+class QREncoder {
+public:
+    enum ECLevel {
+        EC_L,   // ~7% восстановления
+        EC_M,   // ~15%
+        EC_Q,   // ~25%
+        EC_H    // ~30%
+    };
+
+    /**
+     * Режимы кодирования сегментов
+     */
+    enum Mode {
+        MODE_NUMERIC,        // 0-9: 10 бит на три цифры
+        MODE_ALPHANUMERIC,   // 0-9 A-Z пробел $%*+-./: — 11 бит на два символа
+        MODE_BYTE            // произвольные байты: 8 бит на байт
+    };
+
+    /**
+     * Участок данных, кодируемый одним режимом
+     */
+    struct Segment {
+        Mode mode;
+        size_t offset;   // начало в исходных данных
+        size_t length;   // число символов (байт)
+    };
+
+    static const int AUTO_MASK = -1;
+    static const int MIN_VERSION = 1;
+    static const int MAX_VERSION = 40;
+
+    /**
+     * Кодирует данные с параметрами запроса: уровень коррекции, диапазон
+     * версий, маска и разбиение на сегменты. Выбирается наименьшая версия
+     * диапазона, в которую помещаются данные.
+     * @param data Данные для кодирования
+     * @param options Параметры кодирования
+     * @return Матрица модулей
+     * @throws std::invalid_argument При недопустимых параметрах
+     * @throws std::runtime_error Если данные не помещаются в наибольшую версию
+     */
+    static QRMatrix encode(const std::string& data, const EncodeOptions& options);
+
+    /**
+     * Кодирует данные в байтовом режиме
+     * @param data Данные для кодирования
+     * @param level Уровень коррекции ошибок
+     * @param min_version Наименьшая допустимая версия
+     * @param max_version Наибольшая допустимая версия
+     * @param mask Номер маски 0-7 или AUTO_MASK для выбора по штрафам
+     * @return Матрица модулей
+     */
+    static QRMatrix encode(const std::string& data, ECLevel level = EC_L,
+                           int min_version = MIN_VERSION, int max_version = MAX_VERSION,
+                           int mask = AUTO_MASK);
+
+    /**
+     * Разбирает уровень коррекции ("L", "M", "Q", "H", регистр не важен)
+     */
+    static ECLevel parseLevel(const std::string& name);
+    static const char* levelName(ECLevel level);
+
+    /**
+     * Число байт данных (без проверочных) в символе
+     */
+    static int dataCodewords(int version, ECLevel level);
+
+    /**
+     * Разбивает данные на сегменты с наименьшей суммарной длиной в битах
+     * для версии version. Длина поля счётчика символов зависит от группы
+     * версий (1-9, 10-26, 27-40), поэтому и разбиение тоже. Динамика по
+     * символам: для каждого режима хранится лучшая длина кодирования
+     * префикса, заканчивающегося в этом режиме; смена режима стоит
+     * заголовка нового сегмента.
+     */
+    static ArenaVector<Segment> optimizeSegments(const std::string& data, int version);
+
+    /**
+     * Длина закодированных сегментов в битах вместе с заголовками
+     */
+    static size_t segmentBits(const ArenaVector<Segment>& segments, int version);
+
+    /**
+     * Дописывает к блоку данных проверочные байты Рида-Соломона
+     * @param data Байты данных блока
+     * @param ecc_length Число проверочных байт (7-30)
+     * @param ecc Выход: ecc_length проверочных байт
+     */
+    static void reedSolomon(const uint8_t* data, size_t length, int ecc_length, uint8_t* ecc);
+
+    /**
+     * Рисует 15 бит формата (уровень коррекции и маска) в обе копии
+     */
+    static void drawFormatBits(QRMatrix& matrix, ECLevel level, int mask);
+
+    /**
+     * Накладывает маску на область данных (XOR), служебные модули не меняются
+     */
+    static void applyMask(QRMatrix& matrix, int mask);
+
+    /**
+     * Переставляет кодовые слова блоков в итоговый порядок и добавляет
+     * к ним коррекцию ошибок
+     */
+    static ArenaVector<uint8_t> addErrorCorrection(const ArenaVector<uint8_t>& data,
+                                                   int version, ECLevel level);
+
+    /**
+     * Размещает биты кодовых слов в матрице по зигзагу и выбирает маску
+     */
+    static QRMatrix buildMatrix(const ArenaVector<uint8_t>& codewords, int version,
+                                ECLevel level, int mask = AUTO_MASK);
+};
+
+/**
+ * Параметры кодирования одного запроса
+ */
+struct EncodeOptions {
+    QREncoder::ECLevel level = QREncoder::EC_L;
+    int min_version = QREncoder::MIN_VERSION;
+    int max_version = QREncoder::MAX_VERSION;
+    int mask = QREncoder::AUTO_MASK;   // 0-7 или AUTO_MASK
+    bool optimize_segments = true;     // иначе все данные — один байтовый сегмент
+
+    /**
+     * Ключ для кэша: все поля, влияющие на матрицу (например "L1-40ma")
+     */
+    std::string key() const;
+};
+
+#endif // QR_ENCODER_H
@@ -0,0 +1,137 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <qrencode.h>
+#include "qr_encoder.h"
+
+/**
+ * Сверка и бенчмарк собственного кодировщика против libqrencode.
+ *
+ * Сверка: для каждой строки и уровня коррекции символ строится обоими
+ * кодировщиками в байтовом режиме; маска, выбранная libqrencode,
+ * считывается из битов формата и навязывается собственному кодировщику,
+ * после чего матрицы сравниваются модуль в модуль. Отдельно считается,
+ * как часто совпадает и сам выбор маски.
+ *
+ * Бенчмарк: символов в секунду для каждого кодировщика по классам длины.
+ */
+
+namespace {
+
+const QRecLevel LIBQRENCODE_LEVELS[4] = {QR_ECLEVEL_L, QR_ECLEVEL_M, QR_ECLEVEL_Q, QR_ECLEVEL_H};
+const char LEVEL_NAMES[4] = {'L', 'M', 'Q', 'H'};
+
+std::string makePayload(size_t length, unsigned seed) {
+    static const char alphabet[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789:/?&=.-_";
+    std::string payload;
+    payload.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        payload.push_back(alphabet[(seed >> 16) % (sizeof(alphabet) - 1)]);
+    }
+    return payload;
+}
+
+QRMatrix fromLibqrencode(const QRcode* qr) {
+    QRMatrix matrix(qr->version);
+    for (int y = 0; y < qr->width; y++) {
+        for (int x = 0; x < qr->width; x++) {
+            if (qr->data[y * qr->width + x] & 1) matrix.set(x, y, true);
+        }
+    }
+    return matrix;
+}
+
+// Номер маски из первой копии битов формата
+int readMask(const QRMatrix& matrix) {
+    int bits = 0;
+    for (int i = 0; i <= 5; i++) bits |= matrix.get(8, i) << i;
+    bits |= matrix.get(8, 7) << 6;
+    bits |= matrix.get(8, 8) << 7;
+    bits |= matrix.get(7, 8) << 8;
+    for (int i = 9; i < 15; i++) bits |= matrix.get(14 - i, 8) << i;
+    return ((bits ^ 0x5412) >> 10) & 7;
+}
+
+int crossCheck(int samples) {
+    int compared = 0, identical = 0, same_mask = 0;
+    for (int level = 0; level < 4; level++) {
+        for (int i = 0; i < samples; i++) {
+            size_t length = 1 + (static_cast<size_t>(i) * 37) % 1200;
+            std::string payload = makePayload(length, i * 7919 + level);
+
+            QRcode* qr = QRcode_encodeString8bit(payload.c_str(), 0, LIBQRENCODE_LEVELS[level]);
+            if (!qr) continue;   // не поместилось на этом уровне
+            QRMatrix reference = fromLibqrencode(qr);
+            QRcode_free(qr);
+
+            int mask = readMask(reference);
+            QRMatrix native = QREncoder::encode(payload, static_cast<QREncoder::ECLevel>(level),
+                                                reference.version(), reference.version(), mask);
+            QRMatrix automatic = QREncoder::encode(payload, static_cast<QREncoder::ECLevel>(level));
+
+            compared++;
+            if (native == reference) {
+                identical++;
+            } else {
+                std::printf("MISMATCH level=%c length=%zu version=%d mask=%d\n",
+                            LEVEL_NAMES[level], length, reference.version(), mask);
+            }
+            if (automatic == reference) same_mask++;
+        }
+    }
+
+    std::printf("cross-check: %d/%d identical matrices, %d/%d identical with own mask choice\n",
+                identical, compared, same_mask, compared);
+    return identical == compared ? 0 : 1;
+}
+
+template <typename Encode>
+double symbolsPerSecond(const std::vector<std::string>& payloads, Encode encode) {
+    const auto start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    do {
+        for (const auto& payload : payloads) {
+            encode(payload);
+            count++;
+        }
+    } while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(300));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return count / seconds;
+}
+
+void throughput() {
+    const size_t lengths[] = {16, 64, 256, 1024, 2900};
+    std::printf("%8s %5s %14s %14s %8s\n", "length", "level", "libqrencode/s", "native/s", "speedup");
+    for (size_t length : lengths) {
+        for (int level = 0; level < 4; level++) {
+            std::vector<std::string> payloads;
+            for (unsigned i = 0; i < 16; i++) payloads.push_back(makePayload(length, i));
+
+            QRcode* probe = QRcode_encodeString8bit(payloads[0].c_str(), 0, LIBQRENCODE_LEVELS[level]);
+            if (!probe) continue;
+            QRcode_free(probe);
+
+            double reference = symbolsPerSecond(payloads, [level](const std::string& p) {
+                QRcode_free(QRcode_encodeString8bit(p.c_str(), 0, LIBQRENCODE_LEVELS[level]));
+            });
+            double native = symbolsPerSecond(payloads, [level](const std::string& p) {
+                QREncoder::encode(p, static_cast<QREncoder::ECLevel>(level));
+            });
+            std::printf("%8zu %5c %14.0f %14.0f %7.2fx\n",
+                        length, LEVEL_NAMES[level], reference, native, native / reference);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int samples = argc > 1 ? std::atoi(argv[1]) : 200;
+    int status = crossCheck(samples);
+    throughput();
+    return status;
+}
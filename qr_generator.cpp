@@ -1,79 +1,124 @@
 #include "qr_generator.h"
+#include "qr_encoder.h"
+#include "qr_arena.h"
+#include "metrics.h"
 #include <qrencode.h>
-#include <png.h>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
+#include <charconv>
 #include <cstring>
 
-void QRGenerator::saveQRToPNG(const std::string& data, const std::string& output_file) {
-    std::lock_guard<std::mutex> lock(file_mutex);
-    
-    // Генерация QR-кода
-    QRcode* qr = QRcode_encodeString(data.c_str(), 0, QR_ECLEVEL_L, QR_MODE_8, 1);
-    if (!qr) {
-        LOG_ERROR("Failed to generate QR code");
-        throw std::runtime_error("Failed to generate QR code");
-    }
+QRGenerator::Backend QRGenerator::parseBackend(const std::string& name) {
+    if (name == "libqrencode") return BACKEND_LIBQRENCODE;
+    if (name == "native") return BACKEND_NATIVE;
+    throw std::runtime_error("Unknown QR backend: " + name);
+}
 
-    // Сохранение в PNG
-    FILE* fp = fopen(output_file.c_str(), "wb");
-    if (!fp) {
-        QRcode_free(qr);
-        LOG_ERROR("Failed to create QR image file: " + output_file);
-        throw std::runtime_error("Failed to create QR image file");
-    }
+std::string QRGenerator::renderKey(const RasterOptions& raster, QROutput::Format format,
+                                   const EncodeOptions& encoding) {
+    return raster.key() + QROutput::formatName(format) + encoding.key();
+}
 
-    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (!png) {
-        fclose(fp);
-        QRcode_free(qr);
-        LOG_ERROR("Failed to initialize PNG writer");
-        throw std::runtime_error("Failed to initialize PNG writer");
+QRMatrix QRGenerator::encodeMatrix(const std::string& data, Backend backend,
+                                   const EncodeOptions& encoding) {
+    Metrics::Timer timer(Metrics::STAGE_ENCODE);
+    if (backend == BACKEND_NATIVE) {
+        return QREncoder::encode(data, encoding);
     }
 
-    png_infop info = png_create_info_struct(png);
-    if (!info) {
-        png_destroy_write_struct(&png, NULL);
-        fclose(fp);
-        QRcode_free(qr);
-        LOG_ERROR("Failed to initialize PNG info");
-        throw std::runtime_error("Failed to initialize PNG info");
+    if (encoding.mask != QREncoder::AUTO_MASK) {
+        LOG_ERROR("Forced mask is not supported by libqrencode");
+        throw std::runtime_error("Forced mask requires the native backend");
     }
+    static const QRecLevel LEVELS[4] = {QR_ECLEVEL_L, QR_ECLEVEL_M, QR_ECLEVEL_Q, QR_ECLEVEL_H};
+    const QRecLevel level = LEVELS[encoding.level];
 
-    if (setjmp(png_jmpbuf(png))) {
-        png_destroy_write_struct(&png, &info);
-        fclose(fp);
+    // Генерация QR-кода: наименьшая версия не меньше min_version
+    QRcode* qr = encoding.optimize_segments
+        ? QRcode_encodeString(data.c_str(), encoding.min_version, level, QR_MODE_8, 1)
+        : QRcode_encodeString8bit(data.c_str(), encoding.min_version, level);
+    if (!qr) {
+        LOG_ERROR("Failed to generate QR code");
+        throw std::runtime_error("Failed to generate QR code");
+    }
+    if (qr->version > encoding.max_version) {
         QRcode_free(qr);
-        LOG_ERROR("Error during PNG creation");
-        throw std::runtime_error("Error during PNG creation");
+        LOG_ERROR("Data too long for QR code: " + std::to_string(data.size()) + " bytes");
+        throw std::runtime_error("Data too long for QR code");
     }
 
-    png_init_io(png, fp);
-    png_set_IHDR(png, info, qr->width, qr->width, 1,
-                 PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE,
-                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
-    png_write_info(png, info);
-
-    png_bytep row = (png_bytep)malloc((qr->width + 7) / 8);
+    QRMatrix matrix(qr->version);
     for (int y = 0; y < qr->width; y++) {
-        memset(row, 0, (qr->width + 7) / 8);
         for (int x = 0; x < qr->width; x++) {
             if (qr->data[y * qr->width + x] & 1) {
-                row[x / 8] |= (1 << (7 - x % 8));
+                matrix.set(x, y, true);
             }
         }
-        png_write_row(png, row);
     }
-
-    free(row);
-    png_write_end(png, NULL);
-    png_destroy_write_struct(&png, &info);
-    fclose(fp);
     QRcode_free(qr);
+    return matrix;
+}
+
+void QRGenerator::encodeQRToPNG(const std::string& data, std::string& output,
+                                const RasterOptions& raster) {
+    encodeQRImage(data, output, raster, QROutput::FORMAT_PNG, EncodeOptions());
+}
+
+void QRGenerator::encodeQRImage(const std::string& data, std::string& output,
+                                const RasterOptions& raster, QROutput::Format format,
+                                const EncodeOptions& encoding) {
+    // Промежуточные буферы кодирования и растеризации — в арене потока,
+    // сбрасываемой по выходе; в куче остаётся только output
+    QRArena::Scope scope;
+    QRRaster::validate(raster);
+    QROutput::encode(encodeMatrix(data, backend(), encoding), format, raster, pngCompression(),
+                     output);
+}
+
+void QRGenerator::saveQRToPNG(const std::string& data, const std::string& output_file) {
+    std::lock_guard<std::mutex> lock(file_mutex);
+
+    std::string image;
+    encodeQRToPNG(data, image);
+
+    // Сохранение в PNG
+    std::ofstream file(output_file, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        LOG_ERROR("Failed to create QR image file: " + output_file);
+        throw std::runtime_error("Failed to create QR image file");
+    }
+    file.write(image.data(), image.size());
     LOG_DEBUG("QR code saved to " + output_file);
 }
 
+std::string QRGenerator::formatLocation(double latitude, double longitude, int zoom) {
+    char buffer[LOCATION_BUFFER_SIZE];
+    return std::string(buffer, formatLocation(latitude, longitude, zoom, buffer));
+}
+
+size_t QRGenerator::formatLocation(double latitude, double longitude, int zoom, char* buffer) {
+    if (!(latitude >= -90 && latitude <= 90 && longitude >= -180 && longitude <= 180)) {
+        LOG_ERROR("Invalid coordinates: lat=" + std::to_string(latitude) + 
+                 ", long=" + std::to_string(longitude));
+        throw std::runtime_error("Invalid coordinates (lat: -90..90, long: -180..180)");
+    }
+
+    // Самая длинная строка "geo:-90.00000,-180.00000?z=-2147483648" — 38 символов
+    char* const end = buffer + LOCATION_BUFFER_SIZE - 1;
+    char* p = buffer;
+    memcpy(p, "geo:", 4);
+    p += 4;
+    p = std::to_chars(p, end, latitude, std::chars_format::fixed, 5).ptr;
+    *p++ = ',';
+    p = std::to_chars(p, end, longitude, std::chars_format::fixed, 5).ptr;
+    memcpy(p, "?z=", 3);
+    p += 3;
+    p = std::to_chars(p, end, zoom).ptr;
+    *p = '\0';
+
+    LOG_DEBUG("QR code content: " + std::string(buffer, p));
+    return static_cast<size_t>(p - buffer);
+}
+
 void QRGenerator::generateQR(const std::string& data) {
     LOG_INFO("Generating QR code for: " + data);
     saveQRToPNG(data, qr_file);
@@ -82,19 +127,7 @@ void QRGenerator::generateQR(const std::string& data) {
 void QRGenerator::generateLocationQR(double latitude, double longitude, int zoom) {
     LOG_INFO("Generating QR for coordinates: lat=" + std::to_string(latitude) + 
             ", long=" + std::to_string(longitude));
-    
-    if (latitude < -90 || latitude > 90 || longitude < -180 || longitude > 180) {
-        LOG_ERROR("Invalid coordinates: lat=" + std::to_string(latitude) + 
-                 ", long=" + std::to_string(longitude));
-        throw std::runtime_error("Invalid coordinates (lat: -90..90, long: -180..180)");
-    }
-
-    std::ostringstream location_stream;
-    location_stream << std::fixed << std::setprecision(5);
-    location_stream << "geo:" << latitude << "," << longitude << "?z=" << zoom;
-    
-    LOG_DEBUG("QR code content: " + location_stream.str());
-    saveQRToPNG(location_stream.str(), qr_file);
+    saveQRToPNG(formatLocation(latitude, longitude, zoom), qr_file);
 }
 
 std::string QRGenerator::getQRImage() {
@@ -109,3 +142,26 @@ std::string QRGenerator::getQRImage() {
                            std::istreambuf_iterator<char>());
     return std::string(buffer.begin(), buffer.end());
 }
+
+void QRGenerator::generateQRImage(const std::string& data, std::string& output,
+                                  const RasterOptions& raster, QROutput::Format format,
+                                  const EncodeOptions& encoding) {
+    LOG_INFO("Generating QR code for: " + data);
+    encodeQRImage(data, output, raster, format, encoding);
+}
+
+std::string QRGenerator::generateQRImage(const std::string& data, const RasterOptions& raster,
+                                         QROutput::Format format, const EncodeOptions& encoding) {
+    std::string output;
+    generateQRImage(data, output, raster, format, encoding);
+    return output;
+}
+
+void QRGenerator::generateLocationQRImage(double latitude, double longitude,
+                                          std::string& output, int zoom,
+                                          const RasterOptions& raster, QROutput::Format format,
+                                          const EncodeOptions& encoding) {
+    LOG_INFO("Generating QR for coordinates: lat=" + std::to_string(latitude) + 
+            ", long=" + std::to_string(longitude));
+    encodeQRImage(formatLocation(latitude, longitude, zoom), output, raster, format, encoding);
+}
@@ -4,15 +4,49 @@
 #include <string>
 #include <mutex>
 #include <vector>
+#include <atomic>
 #include "logging.h"
+#include "qr_matrix.h"
+#include "qr_encoder.h"
+#include "qr_raster.h"
+#include "qr_png.h"
+#include "qr_output.h"
 
 class QRGenerator {
+public:
+    /**
+     * Кодировщик, строящий матрицу модулей
+     */
+    enum Backend {
+        BACKEND_LIBQRENCODE,   // libqrencode
+        BACKEND_NATIVE         // собственный кодировщик libqr (qr_encoder.h)
+    };
+
 private:
     std::string qr_file = "/tmp/qrcode.png";
     std::mutex file_mutex;
 
     void saveQRToPNG(const std::string& data, const std::string& output_file);
 
+    /**
+     * Кодирует QR-код в PNG прямо в память (PNGWriter)
+     * @param data Текст для кодирования
+     * @param output Буфер, в конец которого дописываются PNG-данные
+     * @param raster Масштаб, светлое поле и глубина цвета
+     */
+    static void encodeQRToPNG(const std::string& data, std::string& output,
+                              const RasterOptions& raster = RasterOptions());
+
+    /**
+     * Кодирует QR-код в изображение заданного формата
+     */
+    static void encodeQRImage(const std::string& data, std::string& output,
+                              const RasterOptions& raster, QROutput::Format format,
+                              const EncodeOptions& encoding);
+
+    static inline std::atomic<int> backend_{BACKEND_LIBQRENCODE};
+    static inline std::atomic<int> png_compression_{PNGWriter::COMPRESSION_FAST};
+
 public:
     /**
      * Генерирует QR-код из текста
@@ -33,6 +67,114 @@ public:
      * @return Бинарные данные изображения PNG
      */
     std::string getQRImage();
+
+    /**
+     * Генерирует PNG с QR-кодом из текста без обращения к файловой системе.
+     * Статические generate*Image реентерабельны: не используют общих файлов
+     * и блокировок, поэтому их можно вызывать из любого числа потоков.
+     * @param data Текст для кодирования
+     * @param output Буфер, в конец которого дописываются PNG-данные
+     *               (позволяет заранее положить туда заголовок ответа)
+     * @param raster Масштаб, светлое поле и глубина цвета
+     * @param format Формат изображения
+     * @param encoding Уровень коррекции, диапазон версий, маска и сегменты
+     */
+    static void generateQRImage(const std::string& data, std::string& output,
+                                const RasterOptions& raster = RasterOptions(),
+                                QROutput::Format format = QROutput::FORMAT_PNG,
+                                const EncodeOptions& encoding = EncodeOptions());
+
+    /**
+     * Генерирует PNG с QR-кодом из текста без обращения к файловой системе
+     * @param data Текст для кодирования
+     * @param raster Масштаб, светлое поле и глубина цвета
+     * @param format Формат изображения
+     * @param encoding Уровень коррекции, диапазон версий, маска и сегменты
+     * @return Бинарные данные изображения
+     */
+    static std::string generateQRImage(const std::string& data,
+                                       const RasterOptions& raster = RasterOptions(),
+                                       QROutput::Format format = QROutput::FORMAT_PNG,
+                                       const EncodeOptions& encoding = EncodeOptions());
+
+    /**
+     * Генерирует PNG с QR-кодом геолокации без обращения к файловой системе
+     * @param latitude Широта (-90 до 90)
+     * @param longitude Долгота (-180 до 180)
+     * @param output Буфер, в конец которого дописываются PNG-данные
+     * @param zoom Уровень масштаба (1-20)
+     * @param raster Масштаб, светлое поле и глубина цвета
+     * @param format Формат изображения
+     * @param encoding Уровень коррекции, диапазон версий, маска и сегменты
+     */
+    static void generateLocationQRImage(double latitude, double longitude,
+                                        std::string& output, int zoom = 15,
+                                        const RasterOptions& raster = RasterOptions(),
+                                        QROutput::Format format = QROutput::FORMAT_PNG,
+                                        const EncodeOptions& encoding = EncodeOptions());
+
+    /**
+     * Формирует содержимое QR-кода геолокации (geo:-URI)
+     * @param latitude Широта (-90 до 90)
+     * @param longitude Долгота (-180 до 180)
+     * @param zoom Уровень масштаба (1-20)
+     * @return Строка вида "geo:55.75580,37.61730?z=15"
+     */
+    static std::string formatLocation(double latitude, double longitude, int zoom = 15);
+
+    /**
+     * Наибольшая длина geo:-URI вместе с завершающим нулём
+     */
+    static const size_t LOCATION_BUFFER_SIZE = 48;
+
+    /**
+     * То же в буфер вызывающего, без потоков и выделений памяти:
+     * std::to_chars с пятью знаками после точки, как прежний вывод
+     * через ostringstream с setprecision(5)
+     * @param buffer Не меньше LOCATION_BUFFER_SIZE байт; строка завершается нулём
+     * @return Длина строки без нуля
+     * @throws std::runtime_error При координатах вне диапазона
+     */
+    static size_t formatLocation(double latitude, double longitude, int zoom, char* buffer);
+
+    /**
+     * Выбирает кодировщик для всех последующих вызовов
+     */
+    static void setBackend(Backend backend) { backend_.store(backend, std::memory_order_relaxed); }
+    static Backend backend() { return static_cast<Backend>(backend_.load(std::memory_order_relaxed)); }
+
+    /**
+     * Уровень сжатия PNG для всех последующих вызовов
+     */
+    static void setPngCompression(PNGWriter::Compression compression) {
+        png_compression_.store(compression, std::memory_order_relaxed);
+    }
+    static PNGWriter::Compression pngCompression() {
+        return static_cast<PNGWriter::Compression>(png_compression_.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Строка всех параметров, от которых зависит изображение при том же
+     * содержимом: ключ кэша сервера и метка параметров архива qr_batch
+     */
+    static std::string renderKey(const RasterOptions& raster, QROutput::Format format,
+                                 const EncodeOptions& encoding);
+
+    /**
+     * Разбирает имя кодировщика ("libqrencode", "native")
+     */
+    static Backend parseBackend(const std::string& name);
+
+    /**
+     * Строит матрицу модулей выбранным кодировщиком.
+     * libqrencode сам разбивает данные на сегменты, но не умеет
+     * принудительную маску — такой запрос отклоняется.
+     * @param data Текст для кодирования
+     * @param backend Кодировщик
+     * @param encoding Уровень коррекции, диапазон версий, маска и сегменты
+     */
+    static QRMatrix encodeMatrix(const std::string& data, Backend backend,
+                                 const EncodeOptions& encoding = EncodeOptions());
 };
 
 #endif // QR_GENERATOR_H
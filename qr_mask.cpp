@@ -0,0 +1,452 @@
+#include "qr_mask.h"
+#include "qr_mask_kernel.h"
+#include "logging.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// 1:1:3:1:1 с четырьмя светлыми модулями слева или справа
+const unsigned FINDER_LEFT = 0x05D;    // 0000 1011101
+const unsigned FINDER_RIGHT = 0x5D0;   // 1011101 0000
+
+// Правила N1 и N3 для одной линии модулей
+int linePenalty(const QRMatrix& matrix, bool vertical, int index) {
+    const int size = matrix.size();
+    int penalty = 0;
+    int run = 0;
+    bool run_color = false;
+    unsigned window = 0;
+
+    for (int i = 0; i < size + 4; i++) {
+        bool dark = i < size && (vertical ? matrix.get(index, i) : matrix.get(i, index));
+        if (i < size) {
+            if (i > 0 && dark == run_color) {
+                run++;
+            } else {
+                if (run >= 5) penalty += PENALTY_N1 + (run - 5);
+                run = 1;
+                run_color = dark;
+            }
+        }
+
+        // Окно из 11 модулей; слева символ дополнен четырьмя светлыми
+        window = ((window << 1) | (dark ? 1u : 0u)) & 0x7FF;
+        if (i + 4 >= 10 && (window == FINDER_LEFT || window == FINDER_RIGHT)) {
+            penalty += PENALTY_N3;
+        }
+    }
+    if (run >= 5) penalty += PENALTY_N1 + (run - 5);
+    return penalty;
+}
+
+int referencePenalty(const QRMatrix& matrix) {
+    const int size = matrix.size();
+    int penalty = 0;
+
+    for (int i = 0; i < size; i++) {
+        penalty += linePenalty(matrix, false, i);
+        penalty += linePenalty(matrix, true, i);
+    }
+
+    long dark = 0;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            bool color = matrix.get(x, y);
+            dark += color;
+            if (x + 1 < size && y + 1 < size &&
+                color == matrix.get(x + 1, y) &&
+                color == matrix.get(x, y + 1) &&
+                color == matrix.get(x + 1, y + 1)) {
+                penalty += PENALTY_N2;
+            }
+        }
+    }
+    return penalty + balancePenalty(dark, size);
+}
+
+// Строка из четырёх 64-битных слов, без векторных расширений
+struct ScalarRow {
+    typedef uint64_t Acc;
+    uint64_t w[MASK_ROW_WORDS];
+
+    static ScalarRow load(const uint64_t* p) {
+        ScalarRow r;
+        for (int i = 0; i < MASK_ROW_WORDS; i++) r.w[i] = p[i];
+        return r;
+    }
+    static ScalarRow zero() { return ScalarRow{{0, 0, 0, 0}}; }
+    static ScalarRow next(const ScalarRow& a, int k) {
+        ScalarRow r;
+        for (int i = 0; i + 1 < MASK_ROW_WORDS; i++) {
+            r.w[i] = (a.w[i] << k) | (a.w[i + 1] >> (64 - k));
+        }
+        r.w[MASK_ROW_WORDS - 1] = a.w[MASK_ROW_WORDS - 1] << k;
+        return r;
+    }
+    static Acc zeroAcc() { return 0; }
+    static Acc count(Acc acc, const ScalarRow& a) {
+        for (int i = 0; i < MASK_ROW_WORDS; i++) acc += __builtin_popcountll(a.w[i]);
+        return acc;
+    }
+    static uint64_t total(Acc acc) { return acc; }
+
+#define SCALAR_ROW_OP(op) \
+    friend ScalarRow operator op(const ScalarRow& a, const ScalarRow& b) { \
+        ScalarRow r; \
+        for (int i = 0; i < MASK_ROW_WORDS; i++) r.w[i] = a.w[i] op b.w[i]; \
+        return r; \
+    }
+    SCALAR_ROW_OP(&)
+    SCALAR_ROW_OP(|)
+    SCALAR_ROW_OP(^)
+#undef SCALAR_ROW_OP
+    friend ScalarRow operator~(const ScalarRow& a) {
+        ScalarRow r;
+        for (int i = 0; i < MASK_ROW_WORDS; i++) r.w[i] = ~a.w[i];
+        return r;
+    }
+};
+
+#ifdef __SSE2__
+// Строка в двух регистрах SSE2: слова 0-1 и 2-3
+struct Sse2Row {
+    typedef __m128i Acc;
+    __m128i lo, hi;
+
+    static Sse2Row load(const uint64_t* p) {
+        return Sse2Row{_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2))};
+    }
+    static Sse2Row zero() { return Sse2Row{_mm_setzero_si128(), _mm_setzero_si128()}; }
+    static Sse2Row next(const Sse2Row& a, int k) {
+        // Следующие слова: (1, 2) и (3, 0)
+        const __m128i next_lo = _mm_or_si128(_mm_srli_si128(a.lo, 8), _mm_slli_si128(a.hi, 8));
+        const __m128i next_hi = _mm_srli_si128(a.hi, 8);
+        const __m128i left = _mm_cvtsi32_si128(k);
+        const __m128i right = _mm_cvtsi32_si128(64 - k);
+        return Sse2Row{_mm_or_si128(_mm_sll_epi64(a.lo, left), _mm_srl_epi64(next_lo, right)),
+                       _mm_or_si128(_mm_sll_epi64(a.hi, left), _mm_srl_epi64(next_hi, right))};
+    }
+    static Acc zeroAcc() { return _mm_setzero_si128(); }
+
+    // Единицы по байтам (SWAR), затем psadbw в две 64-битные суммы
+    static __m128i bytePopcount(__m128i x) {
+        const __m128i m1 = _mm_set1_epi8(0x55);
+        const __m128i m2 = _mm_set1_epi8(0x33);
+        const __m128i m4 = _mm_set1_epi8(0x0F);
+        x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi16(x, 1), m1));
+        x = _mm_add_epi8(_mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi16(x, 2), m2));
+        return _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi16(x, 4)), m4);
+    }
+    static Acc count(Acc acc, const Sse2Row& a) {
+        const __m128i bytes = _mm_add_epi8(bytePopcount(a.lo), bytePopcount(a.hi));
+        return _mm_add_epi64(acc, _mm_sad_epu8(bytes, _mm_setzero_si128()));
+    }
+    static uint64_t total(Acc acc) {
+        return static_cast<uint64_t>(_mm_cvtsi128_si64(acc)) +
+               static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc)));
+    }
+
+    friend Sse2Row operator&(const Sse2Row& a, const Sse2Row& b) {
+        return Sse2Row{_mm_and_si128(a.lo, b.lo), _mm_and_si128(a.hi, b.hi)};
+    }
+    friend Sse2Row operator|(const Sse2Row& a, const Sse2Row& b) {
+        return Sse2Row{_mm_or_si128(a.lo, b.lo), _mm_or_si128(a.hi, b.hi)};
+    }
+    friend Sse2Row operator^(const Sse2Row& a, const Sse2Row& b) {
+        return Sse2Row{_mm_xor_si128(a.lo, b.lo), _mm_xor_si128(a.hi, b.hi)};
+    }
+    friend Sse2Row operator~(const Sse2Row& a) {
+        const __m128i ones = _mm_set1_epi32(-1);
+        return Sse2Row{_mm_xor_si128(a.lo, ones), _mm_xor_si128(a.hi, ones)};
+    }
+};
+#endif
+
+uint64_t loadBigEndian(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value = (value << 8) | p[i];
+    return value;
+}
+
+// Переупаковка строк матрицы в раскладку ядер (см. qr_mask_kernel.h)
+const uint64_t* packRows(const QRMatrix& matrix) {
+    thread_local std::vector<uint64_t> rows;
+    const int size = matrix.size();
+    rows.assign(static_cast<size_t>(size + 2 * MASK_ROW_MARGIN) * MASK_ROW_WORDS, 0);
+
+    const size_t words = matrix.stride() / 8;
+    for (int y = 0; y < size; y++) {
+        const uint8_t* src = matrix.row(y);
+        uint64_t* dst = &rows[static_cast<size_t>(y + MASK_ROW_MARGIN) * MASK_ROW_WORDS];
+        uint64_t carry = 0;
+        for (size_t j = 0; j < words; j++) {
+            uint64_t word = loadBigEndian(src + j * 8);
+            dst[j] = carry | (word >> MASK_ROW_PAD);
+            carry = word << (64 - MASK_ROW_PAD);
+        }
+        dst[words] = carry;
+    }
+    return rows.data();
+}
+
+bool cpuSupports(QRMask::Kernel kernel) {
+    switch (kernel) {
+        case QRMask::KERNEL_AUTO:
+        case QRMask::KERNEL_REFERENCE:
+        case QRMask::KERNEL_SCALAR:
+            return true;
+        case QRMask::KERNEL_SSE2:
+#ifdef __SSE2__
+            return true;
+#else
+            return false;
+#endif
+        case QRMask::KERNEL_AVX2:
+#if defined(__x86_64__) || defined(__i386__)
+            return avx2MaskKernel() != nullptr && __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+QRMask::Kernel bestKernel() {
+    static const QRMask::Kernel best =
+        cpuSupports(QRMask::KERNEL_AVX2) ? QRMask::KERNEL_AVX2 :
+        cpuSupports(QRMask::KERNEL_SSE2) ? QRMask::KERNEL_SSE2 : QRMask::KERNEL_SCALAR;
+    return best;
+}
+
+/**
+ * Вспомогательные потоки для оценки масок. Одновременно обслуживается
+ * один символ; маски раздаются атомарным счётчиком, вызывающий поток
+ * берёт их наравне с помощниками.
+ *
+ * Счётчик несёт и номер поколения (ticket_ = поколение * 16 + маска):
+ * помощник, задержавшийся после конца прошлого символа, не может взять
+ * маску следующего — его CAS не совпадёт по поколению. Задачу помощник
+ * берёт под mutex_ вместе с поколением, а не читает task_ без блокировки.
+ */
+class MaskHelpers {
+public:
+    static MaskHelpers& instance() {
+        static MaskHelpers helpers;
+        return helpers;
+    }
+
+    ~MaskHelpers() { resize(0); }
+
+    void resize(int count) {
+        std::lock_guard<std::mutex> busy(busy_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_) thread.join();
+        threads_.clear();
+
+        stop_ = false;
+        for (int i = 0; i < count; i++) {
+            threads_.emplace_back(&MaskHelpers::helperLoop, this);
+        }
+        count_.store(count, std::memory_order_relaxed);
+    }
+
+    int count() const { return count_.load(std::memory_order_relaxed); }
+
+    /**
+     * @return false, если помощников нет или они заняты — маски не считались
+     */
+    bool run(const std::function<void(int)>& evaluate) {
+        std::unique_lock<std::mutex> busy(busy_mutex_, std::try_to_lock);
+        if (!busy.owns_lock() || threads_.empty()) {
+            return false;
+        }
+
+        uint64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task_ = &evaluate;
+            remaining_ = 8;
+            error_ = nullptr;
+            generation = ++generation_;
+            ticket_.store(generation << TICKET_SHIFT, std::memory_order_relaxed);
+        }
+        wake_.notify_all();
+
+        work(generation, evaluate);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return remaining_ == 0; });
+        task_ = nullptr;
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return true;
+    }
+
+private:
+    MaskHelpers() = default;
+
+    // Берёт маски поколения generation, пока они есть
+    void work(uint64_t generation, const std::function<void(int)>& task) {
+        uint64_t ticket = ticket_.load(std::memory_order_relaxed);
+        while ((ticket >> TICKET_SHIFT) == generation && (ticket & TICKET_MASK) < 8) {
+            if (!ticket_.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed)) {
+                continue;
+            }
+            const int mask = static_cast<int>(ticket & TICKET_MASK);
+            std::exception_ptr error;
+            try {
+                task(mask);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (error && !error_) error_ = error;
+                if (--remaining_ == 0) done_.notify_one();
+            }
+            ticket = ticket_.load(std::memory_order_relaxed);
+        }
+    }
+
+    void helperLoop() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] { return stop_ || (generation_ != seen && task_); });
+            if (stop_) return;
+            seen = generation_;
+            const std::function<void(int)>* task = task_;
+            lock.unlock();
+            work(seen, *task);
+            lock.lock();
+        }
+    }
+
+    static const int TICKET_SHIFT = 4;
+    static const uint64_t TICKET_MASK = (1u << TICKET_SHIFT) - 1;
+
+    std::mutex busy_mutex_;               // один символ за раз
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::vector<std::thread> threads_;
+    std::atomic<int> count_{0};
+    const std::function<void(int)>* task_ = nullptr;
+    std::atomic<uint64_t> ticket_{8};      // поколение * 16 + следующая маска
+    int remaining_ = 0;
+    uint64_t generation_ = 0;
+    std::exception_ptr error_;
+    bool stop_ = false;
+};
+
+MaskHelpers& helpers() {
+    static std::once_flag started;
+    std::call_once(started, [] {
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        MaskHelpers::instance().resize(std::max(0, std::min(3, cores - 1)));
+    });
+    return MaskHelpers::instance();
+}
+
+} // namespace
+
+int QRMask::penalty(const QRMatrix& matrix) {
+    Kernel active = static_cast<Kernel>(kernel_.load(std::memory_order_relaxed));
+    return penalty(matrix, active == KERNEL_AUTO ? bestKernel() : active);
+}
+
+int QRMask::penalty(const QRMatrix& matrix, Kernel kernel) {
+    if (kernel == KERNEL_AUTO) {
+        kernel = bestKernel();
+    }
+    switch (kernel) {
+        case KERNEL_REFERENCE:
+            return referencePenalty(matrix);
+        case KERNEL_SCALAR:
+            return penaltyKernel<ScalarRow>(packRows(matrix), matrix.size());
+#ifdef __SSE2__
+        case KERNEL_SSE2:
+            return penaltyKernel<Sse2Row>(packRows(matrix), matrix.size());
+#endif
+        case KERNEL_AVX2:
+            if (cpuSupports(KERNEL_AVX2)) {
+                return avx2MaskKernel()(packRows(matrix), matrix.size());
+            }
+            break;
+        default:
+            break;
+    }
+    LOG_ERROR(std::string("Mask kernel is not supported: ") + kernelName(kernel));
+    throw std::runtime_error("Mask kernel is not supported");
+}
+
+void QRMask::setKernel(Kernel kernel) {
+    if (!cpuSupports(kernel)) {
+        LOG_ERROR(std::string("Mask kernel is not supported: ") + kernelName(kernel));
+        throw std::runtime_error("Mask kernel is not supported");
+    }
+    kernel_.store(kernel, std::memory_order_relaxed);
+}
+
+QRMask::Kernel QRMask::kernel() {
+    Kernel active = static_cast<Kernel>(kernel_.load(std::memory_order_relaxed));
+    return active == KERNEL_AUTO ? bestKernel() : active;
+}
+
+bool QRMask::isSupported(Kernel kernel) {
+    return cpuSupports(kernel);
+}
+
+const char* QRMask::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case KERNEL_AUTO: return "auto";
+        case KERNEL_REFERENCE: return "reference";
+        case KERNEL_SCALAR: return "scalar";
+        case KERNEL_SSE2: return "sse2";
+        case KERNEL_AVX2: return "avx2";
+    }
+    return "unknown";
+}
+
+QRMask::Kernel QRMask::parseKernel(const std::string& name) {
+    for (Kernel kernel : {KERNEL_AUTO, KERNEL_REFERENCE, KERNEL_SCALAR, KERNEL_SSE2, KERNEL_AVX2}) {
+        if (name == kernelName(kernel)) {
+            return kernel;
+        }
+    }
+    LOG_ERROR("Unknown mask kernel: " + name);
+    throw std::runtime_error("Unknown mask kernel: " + name);
+}
+
+void QRMask::forEachMask(const std::function<void(int)>& evaluate, bool parallel) {
+    if (parallel && helpers().run(evaluate)) {
+        return;
+    }
+    for (int mask = 0; mask < 8; mask++) {
+        evaluate(mask);
+    }
+}
+
+void QRMask::setHelperThreads(int count) {
+    helpers().resize(std::max(0, count));
+}
+
+int QRMask::helperThreads() {
+    return helpers().count();
+}
@@ -0,0 +1,77 @@
+#ifndef QR_MASK_H
+#define QR_MASK_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include "qr_matrix.h"
+
+/**
+ * Выбор маски QR-кода: штрафные баллы по правилам ISO/IEC 18004 (раздел 7.8.3):
+ *   N1 — серии из 5 и более одинаковых модулей в строке или столбце;
+ *   N2 — одноцветные блоки 2x2;
+ *   N3 — узоры, похожие на поисковые (1:1:3:1:1 со светлой полосой в 4 модуля);
+ *   N4 — отклонение доли тёмных модулей от 50%.
+ * Модули за границей символа считаются светлыми.
+ *
+ * Штраф считается над упакованными строками: каждое правило сводится
+ * к побитовым операциям над строкой, её сдвигами и соседними строками,
+ * плюс подсчёт единиц. Ядра SSE2 и AVX2 выбираются во время выполнения
+ * по возможностям процессора, скалярное ядро работает везде.
+ */
+class QRMask {
+public:
+    enum Kernel {
+        KERNEL_AUTO,        // лучшее из поддерживаемых
+        KERNEL_REFERENCE,   // помодульный обход, эталон для сверки
+        KERNEL_SCALAR,      // 64-битные слова
+        KERNEL_SSE2,
+        KERNEL_AVX2
+    };
+
+    // С этой версии маски по умолчанию оцениваются параллельно
+    static const int PARALLEL_MIN_VERSION = 25;
+
+    /**
+     * Штраф символа текущим ядром
+     */
+    static int penalty(const QRMatrix& matrix);
+
+    /**
+     * Штраф символа указанным ядром
+     * @throws std::runtime_error Если ядро не поддерживается процессором
+     */
+    static int penalty(const QRMatrix& matrix, Kernel kernel);
+
+    /**
+     * Выбор ядра; KERNEL_AUTO — лучшее из поддерживаемых
+     * @throws std::runtime_error Если ядро не поддерживается процессором
+     */
+    static void setKernel(Kernel kernel);
+    static Kernel kernel();
+
+    static bool isSupported(Kernel kernel);
+    static const char* kernelName(Kernel kernel);
+    static Kernel parseKernel(const std::string& name);
+
+    /**
+     * Вызывает evaluate(mask) для всех восьми масок. При parallel маски
+     * раздаются вспомогательным потокам, вызывающий поток участвует наравне;
+     * если помощники заняты другим символом, все маски считаются на месте.
+     * @param evaluate Оценка одной маски, вызывается конкурентно
+     * @param parallel Разрешить вспомогательные потоки
+     */
+    static void forEachMask(const std::function<void(int)>& evaluate, bool parallel);
+
+    /**
+     * Число вспомогательных потоков (0 — всегда последовательно).
+     * По умолчанию min(3, число ядер - 1).
+     */
+    static void setHelperThreads(int count);
+    static int helperThreads();
+
+private:
+    static inline std::atomic<int> kernel_{KERNEL_AUTO};
+};
+
+#endif // QR_MASK_H
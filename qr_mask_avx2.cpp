@@ -0,0 +1,77 @@
+#include "qr_mask_kernel.h"
+
+// Собирается с -mavx2; вызывается только после проверки процессора
+// в qr_mask.cpp, поэтому остальной код библиотеки флаг не получает.
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+namespace {
+
+// Строка целиком в одном регистре
+struct Avx2Row {
+    typedef __m256i Acc;
+    __m256i v;
+
+    static Avx2Row load(const uint64_t* p) {
+        return Avx2Row{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))};
+    }
+    static Avx2Row zero() { return Avx2Row{_mm256_setzero_si256()}; }
+    static Avx2Row next(const Avx2Row& a, int k) {
+        // Следующие слова: (1, 2, 3, 0)
+        const __m256i shifted = _mm256_permute4x64_epi64(a.v, _MM_SHUFFLE(3, 3, 2, 1));
+        const __m256i following = _mm256_blend_epi32(shifted, _mm256_setzero_si256(), 0xC0);
+        return Avx2Row{_mm256_or_si256(_mm256_sll_epi64(a.v, _mm_cvtsi32_si128(k)),
+                                       _mm256_srl_epi64(following, _mm_cvtsi32_si128(64 - k)))};
+    }
+    static Acc zeroAcc() { return _mm256_setzero_si256(); }
+
+    // Единицы по полубайтам через таблицу в vpshufb, затем vpsadbw
+    static Acc count(Acc acc, const Avx2Row& a) {
+        const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                               0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low_mask = _mm256_set1_epi8(0x0F);
+        const __m256i low = _mm256_and_si256(a.v, low_mask);
+        const __m256i high = _mm256_and_si256(_mm256_srli_epi16(a.v, 4), low_mask);
+        const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(table, low),
+                                              _mm256_shuffle_epi8(table, high));
+        return _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+    static uint64_t total(Acc acc) {
+        const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc),
+                                          _mm256_extracti128_si256(acc, 1));
+        return static_cast<uint64_t>(_mm_cvtsi128_si64(sum)) +
+               static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(sum, sum)));
+    }
+
+    friend Avx2Row operator&(const Avx2Row& a, const Avx2Row& b) {
+        return Avx2Row{_mm256_and_si256(a.v, b.v)};
+    }
+    friend Avx2Row operator|(const Avx2Row& a, const Avx2Row& b) {
+        return Avx2Row{_mm256_or_si256(a.v, b.v)};
+    }
+    friend Avx2Row operator^(const Avx2Row& a, const Avx2Row& b) {
+        return Avx2Row{_mm256_xor_si256(a.v, b.v)};
+    }
+    friend Avx2Row operator~(const Avx2Row& a) {
+        return Avx2Row{_mm256_xor_si256(a.v, _mm256_set1_epi32(-1))};
+    }
+};
+
+int avx2Penalty(const uint64_t* rows, int size) {
+    return penaltyKernel<Avx2Row>(rows, size);
+}
+
+} // namespace
+
+MaskKernelFn avx2MaskKernel() {
+    return avx2Penalty;
+}
+
+#else
+
+MaskKernelFn avx2MaskKernel() {
+    return nullptr;
+}
+
+#endif
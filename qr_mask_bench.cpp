@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "qr_encoder.h"
+#include "qr_mask.h"
+
+/**
+ * Сверка и микробенчмарк ядер штрафа масок по версиям.
+ *
+ * Сверка: штраф каждого поддерживаемого ядра сравнивается с помодульным
+ * эталоном на символах всех версий со всеми масками и на случайных
+ * матрицах (в них чаще встречаются поисковые узоры у края). Выбор маски
+ * с потоками-помощниками сверяется с последовательным: несколько потоков
+ * кодируют одновременно, помощников не меньше одного даже на одном ядре
+ * (иначе параллельный путь не исполняется; имеет смысл и под TSan).
+ *
+ * Бенчмарк: наносекунд на оценку одной маски каждым ядром и время
+ * полного кодирования с выбором маски последовательно и параллельно.
+ */
+
+namespace {
+
+const QRMask::Kernel KERNELS[] = {QRMask::KERNEL_REFERENCE, QRMask::KERNEL_SCALAR,
+                                  QRMask::KERNEL_SSE2, QRMask::KERNEL_AVX2};
+
+std::string makePayload(size_t length, unsigned seed) {
+    std::string payload;
+    payload.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        payload.push_back(static_cast<char>(seed >> 16));
+    }
+    return payload;
+}
+
+// Наибольшая длина в байтовом режиме, помещающаяся в версию на уровне L
+size_t capacity(int version) {
+    size_t header = 4 + (version < 10 ? 8 : 16);
+    return (QREncoder::dataCodewords(version, QREncoder::EC_L) * 8 - header) / 8;
+}
+
+QRMatrix randomMatrix(int version, unsigned seed, int density) {
+    QRMatrix matrix(version);
+    for (int y = 0; y < matrix.size(); y++) {
+        for (int x = 0; x < matrix.size(); x++) {
+            seed = seed * 1103515245u + 12345u;
+            matrix.set(x, y, static_cast<int>((seed >> 16) % 100) < density);
+        }
+    }
+    return matrix;
+}
+
+int compareKernels(const QRMatrix& matrix, const char* what) {
+    const int expected = QRMask::penalty(matrix, QRMask::KERNEL_REFERENCE);
+    int failures = 0;
+    for (QRMask::Kernel kernel : KERNELS) {
+        if (!QRMask::isSupported(kernel)) continue;
+        int actual = QRMask::penalty(matrix, kernel);
+        if (actual != expected) {
+            std::printf("MISMATCH %s version=%d kernel=%s penalty=%d expected=%d\n",
+                        what, matrix.version(), QRMask::kernelName(kernel), actual, expected);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int crossCheck(int samples) {
+    int checked = 0, failures = 0;
+    for (int version = QREncoder::MIN_VERSION; version <= QREncoder::MAX_VERSION; version++) {
+        for (int i = 0; i < samples; i++) {
+            std::string payload = makePayload(capacity(version) - i % 7, version * 131 + i);
+            for (int mask = 0; mask < 8; mask++) {
+                QRMatrix symbol = QREncoder::encode(payload, QREncoder::EC_L, version, version, mask);
+                failures += compareKernels(symbol, "symbol");
+                checked++;
+            }
+            for (int density : {10, 50, 90}) {
+                failures += compareKernels(randomMatrix(version, version * 7 + i, density), "random");
+                checked++;
+            }
+        }
+    }
+    std::printf("cross-check: %d matrices, %d mismatches\n", checked, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+int parallelCheck(int samples, int helpers) {
+    const int CALLERS = 3;
+    std::vector<std::string> payloads;
+    std::vector<QRMatrix> expected;
+    QRMask::setHelperThreads(0);
+    for (int version = QRMask::PARALLEL_MIN_VERSION; version <= QREncoder::MAX_VERSION; version++) {
+        for (int i = 0; i < samples; i++) {
+            payloads.push_back(makePayload(capacity(version) - i % 7, version * 977 + i));
+            expected.push_back(QREncoder::encode(payloads.back(), QREncoder::EC_L, version, version));
+        }
+    }
+
+    QRMask::setHelperThreads(std::max(1, helpers));
+    std::atomic<int> failures{0};
+    std::vector<std::thread> callers;
+    for (int c = 0; c < CALLERS; c++) {
+        callers.emplace_back([&, c] {
+            for (size_t n = 0; n < payloads.size(); n++) {
+                const size_t i = (n + c * payloads.size() / CALLERS) % payloads.size();
+                const int version = expected[i].version();
+                if (QREncoder::encode(payloads[i], QREncoder::EC_L, version, version) != expected[i]) {
+                    std::printf("MISMATCH parallel version=%d\n", version);
+                    failures.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (std::thread& caller : callers) caller.join();
+
+    std::printf("parallel check: %zu symbols x %d threads, %d helper threads, %d mismatches\n",
+                payloads.size(), CALLERS, QRMask::helperThreads(), failures.load());
+    QRMask::setHelperThreads(helpers);
+    return failures.load() == 0 ? 0 : 1;
+}
+
+template <typename Body>
+double nanosecondsPer(Body body) {
+    const auto start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    do {
+        for (int i = 0; i < 16; i++) body();
+        count += 16;
+    } while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(200));
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+           count;
+}
+
+void perVersion() {
+    std::printf("\nkernel %s, %d helper threads\n",
+                QRMask::kernelName(QRMask::kernel()), QRMask::helperThreads());
+    std::printf("%7s", "version");
+    for (QRMask::Kernel kernel : KERNELS) {
+        if (QRMask::isSupported(kernel)) std::printf(" %11s ns", QRMask::kernelName(kernel));
+    }
+    std::printf(" %11s us %11s us\n", "encode seq", "encode par");
+
+    const int helpers = QRMask::helperThreads();
+    for (int version = 1; version <= QREncoder::MAX_VERSION; version += (version < 5 ? 4 : 5)) {
+        std::string payload = makePayload(capacity(version), version);
+        QRMatrix symbol = QREncoder::encode(payload, QREncoder::EC_L, version, version);
+
+        std::printf("%7d", version);
+        for (QRMask::Kernel kernel : KERNELS) {
+            if (!QRMask::isSupported(kernel)) continue;
+            std::printf(" %14.0f", nanosecondsPer([&] { QRMask::penalty(symbol, kernel); }));
+        }
+
+        auto encode = [&] { QREncoder::encode(payload, QREncoder::EC_L, version, version); };
+        QRMask::setHelperThreads(0);
+        double sequential = nanosecondsPer(encode) / 1000;
+        QRMask::setHelperThreads(helpers);
+        double parallel = version >= QRMask::PARALLEL_MIN_VERSION && helpers > 0
+                              ? nanosecondsPer(encode) / 1000 : sequential;
+        std::printf(" %14.1f %14.1f\n", sequential, parallel);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int samples = argc > 1 ? std::atoi(argv[1]) : 4;
+    int helpers = argc > 2 ? std::atoi(argv[2]) : QRMask::helperThreads();
+    int status = crossCheck(samples);
+    status |= parallelCheck(samples, helpers);
+    perVersion();
+    return status;
+}
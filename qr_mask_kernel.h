@@ -0,0 +1,138 @@
+#ifndef QR_MASK_KERNEL_H
+#define QR_MASK_KERNEL_H
+
+// Внутренний заголовок libqr: общее ядро штрафа масок для qr_mask.cpp
+// и qr_mask_avx2.cpp. Всё, кроме констант, — в безымянном пространстве
+// имён: единицы трансляции собираются с разными флагами процессора.
+
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Строки символа для ядер: по MASK_ROW_WORDS 64-битных слов на строку,
+ * бит p лежит в слове p / 64, разряд 63 - p % 64 (старший бит — левый).
+ * Модуль x занимает бит x + MASK_ROW_PAD; слева и справа от символа нули,
+ * сверху и снизу по MASK_ROW_MARGIN пустых строк — светлые поля
+ * для правила N3 без проверок границ.
+ */
+const int MASK_ROW_WORDS = 4;
+const int MASK_ROW_PAD = 8;
+const int MASK_ROW_MARGIN = 4;
+
+const int PENALTY_N1 = 3;
+const int PENALTY_N2 = 3;
+const int PENALTY_N3 = 40;
+const int PENALTY_N4 = 10;
+
+typedef int (*MaskKernelFn)(const uint64_t* rows, int size);
+
+/**
+ * Ядро AVX2 из qr_mask_avx2.cpp; nullptr, если оно собрано без -mavx2
+ */
+MaskKernelFn avx2MaskKernel();
+
+namespace {
+
+// Биты [MASK_ROW_PAD, MASK_ROW_PAD + count)
+inline void rowMask(uint64_t* words, int count) {
+    for (int i = 0; i < MASK_ROW_WORDS; i++) words[i] = 0;
+    for (int p = MASK_ROW_PAD; p < MASK_ROW_PAD + count; p++) {
+        words[p >> 6] |= uint64_t(1) << (63 - (p & 63));
+    }
+}
+
+inline int balancePenalty(long dark, int size) {
+    const long total = static_cast<long>(size) * size;
+    int k = static_cast<int>((std::labs(dark * 20L - total * 10L) + total - 1) / total) - 1;
+    return k * PENALTY_N4;
+}
+
+/**
+ * Штраф по упакованным строкам. V — строка целиком (256 бит) с операторами
+ * & | ^ ~ и статическими load, zero, next(v, k) — бит p + k на место p,
+ * count(acc, v) — прибавить число единиц, total(acc).
+ *
+ * N1: same — модуль совпадает со следующим; run5 = same и три следующих
+ * same — начало пятёрки. Серия длины L даёт L - 4 бит run5 и один конец,
+ * что вместе с весом конца PENALTY_N1 - 1 равно PENALTY_N1 + (L - 5).
+ * N3: core — начало 1011101, light — четыре светлых подряд; узор
+ * засчитывается отдельно со светлой полосой справа и слева.
+ */
+template <class V>
+int penaltyKernel(const uint64_t* rows, int size) {
+    typedef typename V::Acc Acc;
+    uint64_t valid_words[MASK_ROW_WORDS];
+    uint64_t pair_words[MASK_ROW_WORDS];
+    rowMask(valid_words, size);
+    rowMask(pair_words, size - 1);
+    const V valid = V::load(valid_words);
+    const V pair = V::load(pair_words);
+    auto row = [rows](int y) {
+        return V::load(rows + static_cast<size_t>(y + MASK_ROW_MARGIN) * MASK_ROW_WORDS);
+    };
+
+    Acc runs = V::zeroAcc();
+    Acc run_ends = V::zeroAcc();
+    Acc blocks = V::zeroAcc();
+    Acc finders = V::zeroAcc();
+    Acc dark = V::zeroAcc();
+
+    // По строкам: N1, N3, N2 вместе со следующей строкой, N4
+    for (int y = 0; y < size; y++) {
+        const V r = row(y);
+        const V r1 = V::next(r, 1);
+        const V r2 = V::next(r, 2);
+        const V r3 = V::next(r, 3);
+        dark = V::count(dark, r);
+
+        const V same = pair & ~(r ^ r1);
+        const V run5 = same & V::next(same, 1) & V::next(same, 2) & V::next(same, 3);
+        runs = V::count(runs, run5);
+        run_ends = V::count(run_ends, run5 & ~V::next(run5, 1));
+
+        const V core = r & ~r1 & r2 & r3 & V::next(r, 4) & ~V::next(r, 5) & V::next(r, 6);
+        const V light = ~(r | r1 | r2 | r3);
+        finders = V::count(finders, core & V::next(light, 7));
+        finders = V::count(finders, light & V::next(core, 4));
+
+        if (y + 1 < size) {
+            const V below = ~(r ^ row(y + 1));
+            blocks = V::count(blocks, same & below & V::next(below, 1));
+        }
+    }
+
+    // По столбцам: N1 скользящим окном из четырёх пар строк
+    auto vsame = [&](int y) { return valid & ~(row(y) ^ row(y + 1)); };
+    if (size >= 5) {
+        V s0 = vsame(0), s1 = vsame(1), s2 = vsame(2);
+        V prev = V::zero();
+        for (int y = 0; y + 5 <= size; y++) {
+            const V s3 = vsame(y + 3);
+            const V run5 = s0 & s1 & s2 & s3;
+            runs = V::count(runs, run5);
+            run_ends = V::count(run_ends, prev & ~run5);
+            prev = run5;
+            s0 = s1;
+            s1 = s2;
+            s2 = s3;
+        }
+        run_ends = V::count(run_ends, prev);
+    }
+
+    // По столбцам: N3, поля сверху и снизу уже светлые
+    auto vlight = [&](int y) { return ~(row(y) | row(y + 1) | row(y + 2) | row(y + 3)); };
+    for (int y = 0; y + 7 <= size; y++) {
+        const V core = row(y) & ~row(y + 1) & row(y + 2) & row(y + 3) &
+                       row(y + 4) & ~row(y + 5) & row(y + 6);
+        finders = V::count(finders, core & vlight(y + 7));
+        finders = V::count(finders, core & vlight(y - 4));
+    }
+
+    return static_cast<int>(V::total(runs) + (PENALTY_N1 - 1) * V::total(run_ends) +
+                            PENALTY_N2 * V::total(blocks) + PENALTY_N3 * V::total(finders)) +
+           balancePenalty(static_cast<long>(V::total(dark)), size);
+}
+
+} // namespace
+
+#endif // QR_MASK_KERNEL_H
@@ -0,0 +1,66 @@
+#ifndef QR_MATRIX_H
+#define QR_MATRIX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "qr_arena.h"
+
+/**
+ * Матрица модулей QR-кода, упакованная по битам.
+ *
+ * Каждая строка занимает stride() байт, старший бит байта — левый модуль
+ * (тот же порядок, что у 1-битной строки PNG). stride кратен 8, поэтому
+ * строку можно обрабатывать 64-битными словами и векторными регистрами;
+ * биты за пределами ширины символа всегда нулевые (светлые).
+ *
+ * Модули хранятся через ArenaAllocator: матрица, созданная или
+ * скопированная внутри QRArena::Scope, живёт в арене запроса.
+ */
+class QRMatrix {
+public:
+    QRMatrix() = default;
+
+    /**
+     * @param version Версия символа (1-40), сторона = 4 * version + 17
+     */
+    explicit QRMatrix(int version)
+        : version_(version), size_(version * 4 + 17),
+          stride_(((static_cast<size_t>(size_) + 63) / 64) * 8),
+          bits_(stride_ * size_, 0) {}
+
+    int version() const { return version_; }
+    int size() const { return size_; }
+    size_t stride() const { return stride_; }
+    bool empty() const { return size_ == 0; }
+
+    bool get(int x, int y) const {
+        return (bits_[y * stride_ + (x >> 3)] >> (7 - (x & 7))) & 1;
+    }
+
+    void set(int x, int y, bool dark) {
+        uint8_t bit = static_cast<uint8_t>(0x80 >> (x & 7));
+        uint8_t& byte = bits_[y * stride_ + (x >> 3)];
+        byte = dark ? (byte | bit) : (byte & ~bit);
+    }
+
+    const uint8_t* row(int y) const { return &bits_[y * stride_]; }
+    uint8_t* row(int y) { return &bits_[y * stride_]; }
+
+    const uint8_t* data() const { return bits_.data(); }
+    uint8_t* data() { return bits_.data(); }
+    size_t bytes() const { return bits_.size(); }
+
+    bool operator==(const QRMatrix& other) const {
+        return version_ == other.version_ && bits_ == other.bits_;
+    }
+    bool operator!=(const QRMatrix& other) const { return !(*this == other); }
+
+private:
+    int version_ = 0;
+    int size_ = 0;
+    size_t stride_ = 0;
+    ArenaVector<uint8_t> bits_;
+};
+
+#endif // QR_MATRIX_H
@@ -0,0 +1,196 @@
+#include "qr_output.h"
+#include "logging.h"
+#include "metrics.h"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+namespace {
+
+void appendInt(std::string& out, int value) {
+    char buffer[16];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+uint64_t loadBigEndian(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value = (value << 8) | p[i];
+    return value;
+}
+
+/**
+ * Вызывает emit(x, length) для каждой серии тёмных модулей строки y.
+ * Строка просматривается 64-битными словами, границы серий ищутся
+ * подсчётом ведущих нулей и единиц, а не обходом модулей.
+ */
+template <typename Emit>
+void forEachDarkRun(const QRMatrix& matrix, int y, Emit emit) {
+    const uint8_t* row = matrix.row(y);
+    const size_t words = matrix.stride() / 8;
+    bool in_run = false;
+    int start = 0;
+    for (size_t j = 0; j < words; j++) {
+        const uint64_t word = loadBigEndian(row + j * 8);
+        const int base = static_cast<int>(j * 64);
+        int bit = 0;
+        while (bit < 64) {
+            const uint64_t rest = word << bit;
+            if (!in_run) {
+                if (rest == 0) break;
+                bit += __builtin_clzll(rest);
+                start = base + bit;
+                in_run = true;
+            } else {
+                const uint64_t inverted = ~rest;
+                int ones = inverted == 0 ? 64 : __builtin_clzll(inverted);
+                bit += std::min(ones, 64 - bit);
+                if (bit < 64) {
+                    emit(start, base + bit - start);
+                    in_run = false;
+                }
+            }
+        }
+    }
+    // Биты за шириной символа нулевые, серия закрывается внутри строки
+    if (in_run) {
+        emit(start, static_cast<int>(words * 64) - start);
+    }
+}
+
+void encodePng(const QRMatrix& matrix, const RasterOptions& raster,
+               PNGWriter::Compression compression, std::string& output) {
+    PNGWriter::write(matrix, raster, compression, output);
+}
+
+void encodeSvg(const QRMatrix& matrix, const RasterOptions& raster,
+               PNGWriter::Compression, std::string& output) {
+    QRRaster::validate(raster);
+    const int modules = matrix.size() + 2 * raster.margin;
+    const int pixels = modules * raster.scale;
+
+    output.append("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+    appendInt(output, pixels);
+    output.append("\" height=\"");
+    appendInt(output, pixels);
+    output.append("\" viewBox=\"0 0 ");
+    appendInt(output, modules);
+    output.push_back(' ');
+    appendInt(output, modules);
+    output.append("\" shape-rendering=\"crispEdges\">"
+                  "<rect width=\"100%\" height=\"100%\" fill=\"#fff\"/>"
+                  "<path fill=\"#000\" d=\"");
+
+    // Серия тёмных модулей — прямоугольник высотой в один модуль
+    for (int y = 0; y < matrix.size(); y++) {
+        forEachDarkRun(matrix, y, [&](int x, int length) {
+            output.push_back('M');
+            appendInt(output, x + raster.margin);
+            output.push_back(' ');
+            appendInt(output, y + raster.margin);
+            output.push_back('h');
+            appendInt(output, length);
+            output.append("v1h-");
+            appendInt(output, length);
+            output.push_back('z');
+        });
+    }
+    output.append("\"/></svg>\n");
+}
+
+void encodePbm(const QRMatrix& matrix, const RasterOptions& raster,
+               PNGWriter::Compression, std::string& output) {
+    RasterOptions bilevel = raster;
+    bilevel.bit_depth = 1;
+    QRRaster::validate(bilevel);
+    const int size = QRRaster::imageSize(matrix, bilevel);
+    const size_t row_bytes = QRRaster::rowBytes(size, 1);
+
+    output.append("P4\n");
+    appendInt(output, size);
+    output.push_back(' ');
+    appendInt(output, size);
+    output.push_back('\n');
+
+    // Весь объём заранее: повторы строк копируются из уже записанной
+    output.reserve(output.size() + row_bytes * size);
+    QRRaster::rasterize(matrix, bilevel, [&](const uint8_t* row, int repeat) {
+        // В PBM 1 — чёрный, у растеризатора 1 — светлый
+        const size_t offset = output.size();
+        for (size_t i = 0; i < row_bytes; i++) {
+            output.push_back(static_cast<char>(~row[i]));
+        }
+        for (int i = 1; i < repeat; i++) {
+            output.append(output.data() + offset, row_bytes);
+        }
+    });
+}
+
+void encodeRaw(const QRMatrix& matrix, const RasterOptions&,
+               PNGWriter::Compression, std::string& output) {
+    const size_t row_bytes = (static_cast<size_t>(matrix.size()) + 7) / 8;
+    output.reserve(output.size() + 1 + row_bytes * matrix.size());
+    output.push_back(static_cast<char>(matrix.version()));
+    for (int y = 0; y < matrix.size(); y++) {
+        output.append(reinterpret_cast<const char*>(matrix.row(y)), row_bytes);
+    }
+}
+
+typedef void (*Encoder)(const QRMatrix&, const RasterOptions&, PNGWriter::Compression,
+                        std::string&);
+
+struct FormatEntry {
+    const char* name;
+    const char* mime_type;
+    Encoder encode;
+};
+
+const FormatEntry FORMATS[QROutput::FORMAT_COUNT] = {
+    {"png", "image/png", encodePng},
+    {"svg", "image/svg+xml", encodeSvg},
+    {"pbm", "image/x-portable-bitmap", encodePbm},
+    {"raw", "application/octet-stream", encodeRaw},
+};
+
+bool validFormat(QROutput::Format format) {
+    return format >= 0 && format < QROutput::FORMAT_COUNT;
+}
+
+} // namespace
+
+void QROutput::encode(const QRMatrix& matrix, Format format, const RasterOptions& raster,
+                      PNGWriter::Compression compression, std::string& output) {
+    if (!validFormat(format)) {
+        LOG_ERROR("Unsupported image format: " + std::to_string(format));
+        throw std::runtime_error("Unsupported image format " + std::to_string(format));
+    }
+
+    // PNG делит время на растеризацию и сжатие сам (qr_png.cpp)
+    const uint64_t start = format == FORMAT_PNG ? 0 : Metrics::now();
+    const size_t initial_size = output.size();
+    try {
+        FORMATS[format].encode(matrix, raster, compression, output);
+    } catch (...) {
+        output.resize(initial_size);
+        throw;
+    }
+    Metrics::recordSince(Metrics::STAGE_RASTERIZE, start);
+}
+
+QROutput::Format QROutput::parseFormat(const std::string& name) {
+    for (int i = 0; i < FORMAT_COUNT; i++) {
+        if (name == FORMATS[i].name) {
+            return static_cast<Format>(i);
+        }
+    }
+    LOG_ERROR("Unknown image format: " + name);
+    throw std::runtime_error("Unknown image format: " + name);
+}
+
+const char* QROutput::formatName(Format format) {
+    return validFormat(format) ? FORMATS[format].name : "unknown";
+}
+
+const char* QROutput::mimeType(Format format) {
+    return validFormat(format) ? FORMATS[format].mime_type : "application/octet-stream";
+}
@@ -0,0 +1,55 @@
+#ifndef QR_OUTPUT_H
+#define QR_OUTPUT_H
+
+#include <string>
+#include "qr_matrix.h"
+#include "qr_raster.h"
+#include "qr_png.h"
+
+/**
+ * Форматы изображения QR-кода. Кодировщики собраны в таблицу по формату,
+ * новый формат — это функция и строка в таблице. Только PNG проходит
+ * через zlib; остальные форматы строятся прямо из матрицы или из строк
+ * растеризатора.
+ */
+class QROutput {
+public:
+    /**
+     * Значения совпадают с кодами формата в поле flags протокола (protocol.h)
+     */
+    enum Format {
+        FORMAT_PNG = 0,   // оттенки серого, 1 или 8 бит
+        FORMAT_SVG = 1,   // вектор: серии тёмных модулей строки — один путь
+        FORMAT_PBM = 2,   // Netpbm P4, 1 бит на пиксель
+        FORMAT_RAW = 3    // упакованная матрица модулей, см. encode()
+    };
+
+    static const int FORMAT_COUNT = 4;
+
+    /**
+     * Кодирует матрицу и дописывает результат в конец output.
+     *
+     * SVG и PBM учитывают масштаб и светлое поле, глубина цвета
+     * относится только к PNG. RAW не зависит от raster: байт версии,
+     * затем size строк по (size + 7) / 8 байт, старший бит — левый модуль,
+     * 1 — тёмный модуль.
+     *
+     * @param matrix Матрица модулей
+     * @param format Формат
+     * @param raster Масштаб, светлое поле и глубина цвета
+     * @param compression Уровень сжатия PNG
+     * @param output Буфер; при ошибке остаётся прежним
+     * @throws std::runtime_error При неизвестном формате или недопустимых параметрах
+     */
+    static void encode(const QRMatrix& matrix, Format format, const RasterOptions& raster,
+                       PNGWriter::Compression compression, std::string& output);
+
+    /**
+     * Разбирает имя формата ("png", "svg", "pbm", "raw")
+     */
+    static Format parseFormat(const std::string& name);
+    static const char* formatName(Format format);
+    static const char* mimeType(Format format);
+};
+
+#endif // QR_OUTPUT_H
@@ -0,0 +1,245 @@
+#include "qr_png.h"
+#include "logging.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+
+const char PNG_SIGNATURE[8] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1A', '\n'};
+const uint8_t COLOR_TYPE_GRAY = 0;
+const uint8_t FILTER_NONE = 0;
+const uint8_t FILTER_UP = 2;
+const size_t STAGING_BYTES = 16 * 1024;   // отфильтрованные строки копятся до вызова deflate
+
+// Уровень и стратегия zlib для STORE, FAST, BEST
+const int ZLIB_LEVELS[3] = {0, 1, 6};
+const int ZLIB_STRATEGIES[3] = {Z_DEFAULT_STRATEGY, Z_RLE, Z_FILTERED};
+
+/**
+ * Фильтр Up превращает повторённые строки в нули — как раз то, что
+ * сжимает Z_RLE, и лучший выбор для 8-битных строк. 1-битные строки
+ * без фильтра deflate сжимает плотнее ссылками на предыдущую строку.
+ */
+bool useUpFilter(PNGWriter::Compression compression, int bit_depth) {
+    return compression == PNGWriter::COMPRESSION_FAST ||
+           (compression == PNGWriter::COMPRESSION_BEST && bit_depth == 8);
+}
+
+void putU32(char* out, uint32_t value) {
+    out[0] = static_cast<char>(value >> 24);
+    out[1] = static_cast<char>(value >> 16);
+    out[2] = static_cast<char>(value >> 8);
+    out[3] = static_cast<char>(value);
+}
+
+void appendU32(std::string& out, uint32_t value) {
+    char bytes[4];
+    putU32(bytes, value);
+    out.append(bytes, 4);
+}
+
+uint32_t chunkCrc(const std::string& out, size_t type_offset, size_t length) {
+    return static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(out.data() + type_offset),
+                                       static_cast<uInt>(length + 4)));
+}
+
+void appendChunk(std::string& out, const char* type, const char* data, uint32_t length) {
+    appendU32(out, length);
+    const size_t type_offset = out.size();
+    out.append(type, 4);
+    out.append(data, length);
+    appendU32(out, chunkCrc(out, type_offset, length));
+}
+
+/**
+ * Состояние zlib одного потока: по потоку deflate на уровень сжатия
+ * и буферы строк. Освобождается при завершении потока.
+ */
+class DeflateState {
+public:
+    DeflateState() { memset(ready_, 0, sizeof(ready_)); }
+
+    ~DeflateState() {
+        for (int i = 0; i < 3; i++) {
+            if (ready_[i]) deflateEnd(&streams_[i]);
+        }
+    }
+
+    z_stream& stream(PNGWriter::Compression compression) {
+        z_stream& zs = streams_[compression];
+        if (ready_[compression]) {
+            deflateReset(&zs);
+            return zs;
+        }
+        memset(&zs, 0, sizeof(zs));
+        if (deflateInit2(&zs, ZLIB_LEVELS[compression], Z_DEFLATED, 15, 8,
+                         ZLIB_STRATEGIES[compression]) != Z_OK) {
+            LOG_ERROR("Failed to initialize zlib stream");
+            throw std::runtime_error("Failed to initialize zlib stream");
+        }
+        ready_[compression] = true;
+        return zs;
+    }
+
+    std::vector<uint8_t> staging;
+    std::vector<uint8_t> previous;
+
+private:
+    z_stream streams_[3];
+    bool ready_[3];
+};
+
+thread_local DeflateState deflate_state;
+
+/**
+ * Сжимает данные в output начиная с end, наращивая строку по мере нужды
+ */
+void deflateInto(z_stream& zs, const uint8_t* data, size_t length, int flush,
+                 std::string& output, size_t& end) {
+    zs.next_in = const_cast<Bytef*>(data);
+    zs.avail_in = static_cast<uInt>(length);
+    while (true) {
+        if (output.size() - end < 64) {
+            output.resize(std::max(output.size() * 2, end + 4096));
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(&output[end]);
+        zs.avail_out = static_cast<uInt>(output.size() - end);
+        int rc = deflate(&zs, flush);
+        end = output.size() - zs.avail_out;
+        if (rc == Z_STREAM_ERROR) {
+            LOG_ERROR("zlib deflate failed");
+            throw std::runtime_error("zlib deflate failed");
+        }
+        if (flush == Z_FINISH ? rc == Z_STREAM_END : (zs.avail_in == 0 && zs.avail_out > 0)) {
+            return;
+        }
+    }
+}
+
+} // namespace
+
+void PNGWriter::write(const QRMatrix& matrix, const RasterOptions& raster,
+                      Compression compression, std::string& output) {
+    QRRaster::validate(raster);
+    const uint32_t size = static_cast<uint32_t>(QRRaster::imageSize(matrix, raster));
+    const size_t row_bytes = QRRaster::rowBytes(size, raster.bit_depth);
+    const size_t line_bytes = row_bytes + 1;
+
+    DeflateState& state = deflate_state;
+    z_stream& zs = state.stream(compression);
+    const size_t initial_size = output.size();
+
+    // Растеризация и сжатие чередуются; время deflate копится отдельно
+    // (конец последнего вызова deflate считаем и концом записи — после него
+    // остаются только CRC и IEND)
+    const uint64_t started = Metrics::now();
+    uint64_t compress_ns = 0;
+    uint64_t finished = started;
+    auto compress = [&](int flush, size_t& end) {
+        const uint64_t start = Metrics::now();
+        deflateInto(zs, state.staging.data(), state.staging.size(), flush, output, end);
+        const uint64_t stop = Metrics::now();
+        if (start != 0 && stop > start) {
+            compress_ns += stop - start;
+            finished = stop;
+        }
+    };
+
+    try {
+        output.append(PNG_SIGNATURE, sizeof(PNG_SIGNATURE));
+
+        char header[13];
+        putU32(header, size);
+        putU32(header + 4, size);
+        header[8] = static_cast<char>(raster.bit_depth);
+        header[9] = COLOR_TYPE_GRAY;
+        header[10] = 0;   // deflate
+        header[11] = 0;   // адаптивная фильтрация (тип фильтра один на всё изображение)
+        header[12] = 0;   // без чересстрочности
+        appendChunk(output, "IHDR", header, sizeof(header));
+
+        // Длину IDAT проставим после сжатия
+        const size_t idat = output.size();
+        output.append("\0\0\0\0IDAT", 8);
+        size_t end = output.size();
+        output.resize(end + line_bytes * size / 16 + 1024);
+
+        std::vector<uint8_t>& staging = state.staging;
+        std::vector<uint8_t>& previous = state.previous;
+        staging.clear();
+        staging.reserve(std::max(STAGING_BYTES, line_bytes) + line_bytes);
+        previous.assign(row_bytes, 0);
+
+        auto stage = [&](size_t bytes) {
+            if (staging.size() + bytes > STAGING_BYTES && !staging.empty()) {
+                compress(Z_NO_FLUSH, end);
+                staging.clear();
+            }
+            const size_t offset = staging.size();
+            staging.resize(offset + bytes);
+            return &staging[offset];
+        };
+
+        const bool up = useUpFilter(compression, raster.bit_depth);
+        QRRaster::rasterize(matrix, raster, [&](const uint8_t* row, int repeat) {
+            uint8_t* line = stage(line_bytes);
+            if (!up) {
+                for (int i = 0; i < repeat; i++) {
+                    if (i > 0) line = stage(line_bytes);
+                    line[0] = FILTER_NONE;
+                    memcpy(line + 1, row, row_bytes);
+                }
+                return;
+            }
+
+            line[0] = FILTER_UP;
+            for (size_t i = 0; i < row_bytes; i++) {
+                line[i + 1] = static_cast<uint8_t>(row[i] - previous[i]);
+            }
+            memcpy(previous.data(), row, row_bytes);
+
+            // Повтор строки после фильтра Up — одни нули
+            for (int i = 1; i < repeat; i++) {
+                line = stage(line_bytes);
+                line[0] = FILTER_UP;
+                memset(line + 1, 0, row_bytes);
+            }
+        });
+        compress(Z_FINISH, end);
+
+        output.resize(end);
+        putU32(&output[idat], static_cast<uint32_t>(end - idat - 8));
+        appendU32(output, chunkCrc(output, idat + 4, end - idat - 8));
+        appendChunk(output, "IEND", "", 0);
+
+        if (started != 0) {
+            Metrics::record(Metrics::STAGE_COMPRESS, compress_ns);
+            Metrics::record(Metrics::STAGE_RASTERIZE,
+                            finished > started + compress_ns ? finished - started - compress_ns : 0);
+        }
+    } catch (...) {
+        output.resize(initial_size);
+        throw;
+    }
+}
+
+PNGWriter::Compression PNGWriter::parseCompression(const std::string& name) {
+    if (name == "store") return COMPRESSION_STORE;
+    if (name == "fast") return COMPRESSION_FAST;
+    if (name == "best") return COMPRESSION_BEST;
+    LOG_ERROR("Unknown PNG compression: " + name);
+    throw std::runtime_error("Unknown PNG compression: " + name);
+}
+
+const char* PNGWriter::compressionName(Compression compression) {
+    switch (compression) {
+        case COMPRESSION_STORE: return "store";
+        case COMPRESSION_FAST: return "fast";
+        case COMPRESSION_BEST: return "best";
+    }
+    return "unknown";
+}
@@ -0,0 +1,47 @@
+#ifndef QR_PNG_H
+#define QR_PNG_H
+
+#include <string>
+#include "qr_matrix.h"
+#include "qr_raster.h"
+
+/**
+ * Запись PNG для QR-кодов (оттенки серого, 1 или 8 бит) без libpng.
+ *
+ * Чанки собираются вручную, IDAT сжимается zlib прямо в выходной буфер.
+ * Поток deflate и рабочие буферы живут в потоке и переиспользуются
+ * через deflateReset, поэтому на изображение не тратится ни одной
+ * инициализации zlib. Фильтр строк один на изображение и выбирается
+ * по уровню сжатия, а не перебором для каждой строки, как в libpng;
+ * строки, повторённые растеризатором, повторно не фильтруются.
+ */
+class PNGWriter {
+public:
+    /**
+     * Компромисс скорость/размер
+     */
+    enum Compression {
+        COMPRESSION_STORE,   // deflate без сжатия: быстрее всего, крупнее всего
+        COMPRESSION_FAST,    // фильтр Up и Z_RLE: серии нулей и одинаковых байт
+        COMPRESSION_BEST     // уровень 6, Z_FILTERED
+    };
+
+    /**
+     * Растеризует символ и дописывает PNG в конец output
+     * @param matrix Матрица модулей
+     * @param raster Масштаб, светлое поле и глубина цвета
+     * @param compression Уровень сжатия
+     * @param output Буфер; при ошибке остаётся прежним
+     * @throws std::runtime_error При ошибке zlib или недопустимых параметрах
+     */
+    static void write(const QRMatrix& matrix, const RasterOptions& raster,
+                      Compression compression, std::string& output);
+
+    /**
+     * Разбирает имя уровня ("store", "fast", "best")
+     */
+    static Compression parseCompression(const std::string& name);
+    static const char* compressionName(Compression compression);
+};
+
+#endif // QR_PNG_H
@@ -0,0 +1,166 @@
+#include <chrono>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <png.h>
+#include "qr_encoder.h"
+#include "qr_png.h"
+#include "qr_raster.h"
+
+/**
+ * Сверка и бенчмарк PNGWriter против прежнего пути через libpng
+ * (png_create_write_struct на каждый вызов, настройки по умолчанию).
+ *
+ * Сверка: оба PNG читаются обратно libpng и сравниваются попиксельно.
+ * Бенчмарк: байт на изображение и микросекунд на изображение
+ * для каждого уровня сжатия по версиям, масштабам и глубине цвета.
+ */
+
+namespace {
+
+void appendToString(png_structp png, png_bytep data, png_size_t length) {
+    static_cast<std::string*>(png_get_io_ptr(png))->append(reinterpret_cast<char*>(data), length);
+}
+
+void flushNoop(png_structp) {}
+
+// Прежний путь: libpng с настройками по умолчанию
+void writeLibpng(const QRMatrix& matrix, const RasterOptions& raster, std::string& output) {
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info = png_create_info_struct(png);
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        throw std::runtime_error("libpng write failed");
+    }
+    const int size = QRRaster::imageSize(matrix, raster);
+    png_set_write_fn(png, &output, appendToString, flushNoop);
+    png_set_IHDR(png, info, size, size, raster.bit_depth, PNG_COLOR_TYPE_GRAY,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+    QRRaster::rasterize(matrix, raster, [png](const uint8_t* row, int repeat) {
+        for (int i = 0; i < repeat; i++) png_write_row(png, const_cast<png_bytep>(row));
+    });
+    png_write_end(png, NULL);
+    png_destroy_write_struct(&png, &info);
+}
+
+// Пиксели в 8-битных оттенках серого через упрощённый API libpng
+std::vector<uint8_t> decode(const std::string& data) {
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&image, data.data(), data.size())) {
+        throw std::runtime_error(std::string("libpng read failed: ") + image.message);
+    }
+    image.format = PNG_FORMAT_GRAY;
+    std::vector<uint8_t> pixels(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, NULL, pixels.data(), 0, NULL)) {
+        throw std::runtime_error(std::string("libpng read failed: ") + image.message);
+    }
+    return pixels;
+}
+
+std::string makePayload(size_t length, unsigned seed) {
+    std::string payload;
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        payload.push_back(static_cast<char>(seed >> 16));
+    }
+    return payload;
+}
+
+QRMatrix symbol(int version) {
+    size_t header = 4 + (version < 10 ? 8 : 16);
+    size_t length = (QREncoder::dataCodewords(version, QREncoder::EC_L) * 8 - header) / 8;
+    return QREncoder::encode(makePayload(length, version), QREncoder::EC_L, version, version);
+}
+
+template <typename Body>
+double microsecondsPer(Body body) {
+    const auto start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    do {
+        for (int i = 0; i < 8; i++) body();
+        count += 8;
+    } while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(200));
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+           count;
+}
+
+const PNGWriter::Compression COMPRESSIONS[] = {PNGWriter::COMPRESSION_STORE,
+                                               PNGWriter::COMPRESSION_FAST,
+                                               PNGWriter::COMPRESSION_BEST};
+
+int crossCheck() {
+    int checked = 0, failures = 0;
+    for (int version : {1, 2, 7, 10, 25, 40}) {
+        QRMatrix matrix = symbol(version);
+        for (int scale : {1, 2, 3, 8, 13}) {
+            for (int margin : {0, 1, 4}) {
+                for (int depth : {1, 8}) {
+                    RasterOptions raster = {scale, margin, depth};
+                    std::string reference;
+                    writeLibpng(matrix, raster, reference);
+                    std::vector<uint8_t> expected = decode(reference);
+                    for (PNGWriter::Compression compression : COMPRESSIONS) {
+                        std::string image;
+                        PNGWriter::write(matrix, raster, compression, image);
+                        checked++;
+                        if (decode(image) != expected) {
+                            failures++;
+                            std::printf("MISMATCH version=%d %s %s\n", version, raster.key().c_str(),
+                                        PNGWriter::compressionName(compression));
+                        }
+                    }
+                }
+            }
+        }
+    }
+    std::printf("cross-check: %d images, %d mismatches\n", checked, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+void throughput() {
+    std::printf("\n%7s %8s %16s", "version", "raster", "libpng B/us");
+    for (PNGWriter::Compression compression : COMPRESSIONS) {
+        std::printf(" %13s B/us", PNGWriter::compressionName(compression));
+    }
+    std::printf("\n");
+
+    for (int version : {2, 10, 25, 40}) {
+        QRMatrix matrix = symbol(version);
+        for (RasterOptions raster : {RasterOptions{1, 0, 1}, RasterOptions{4, 4, 1},
+                                     RasterOptions{8, 4, 1}, RasterOptions{4, 4, 8}}) {
+            std::string image;
+            writeLibpng(matrix, raster, image);
+            double micros = microsecondsPer([&] {
+                std::string out;
+                writeLibpng(matrix, raster, out);
+            });
+            std::printf("%7d %8s %8zu/%7.1f", version, raster.key().c_str(), image.size(), micros);
+
+            for (PNGWriter::Compression compression : COMPRESSIONS) {
+                image.clear();
+                PNGWriter::write(matrix, raster, compression, image);
+                micros = microsecondsPer([&] {
+                    std::string out;
+                    PNGWriter::write(matrix, raster, compression, out);
+                });
+                std::printf(" %8zu/%7.1f", image.size(), micros);
+            }
+            std::printf("\n");
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    int status = crossCheck();
+    throughput();
+    return status;
+}
@@ -0,0 +1,172 @@
+#include "qr_raster.h"
+#include "logging.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+const int TABLE_MAX_SCALE = 8;
+
+/**
+ * Полубайт пикселей -> 4 * scale бит, каждый бит повторён scale раз
+ */
+struct ExpandTable {
+    uint32_t bits[TABLE_MAX_SCALE + 1][16];
+
+    constexpr ExpandTable() : bits() {
+        for (int scale = 1; scale <= TABLE_MAX_SCALE; scale++) {
+            for (int nibble = 0; nibble < 16; nibble++) {
+                uint32_t value = 0;
+                for (int i = 3; i >= 0; i--) {
+                    for (int k = 0; k < scale; k++) {
+                        value = (value << 1) | ((nibble >> i) & 1);
+                    }
+                }
+                bits[scale][nibble] = value;
+            }
+        }
+    }
+};
+
+constexpr ExpandTable expand_table;
+
+// Побитовая запись со старшего бита
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t* out) : out_(out) {}
+
+    // count <= 32
+    void put(uint32_t value, int count) {
+        acc_ = (acc_ << count) | value;
+        bits_ += count;
+        while (bits_ >= 8) {
+            bits_ -= 8;
+            *out_++ = static_cast<uint8_t>(acc_ >> bits_);
+        }
+    }
+
+    void fill(bool one, int count) {
+        while (count > 0) {
+            int n = std::min(count, 32);
+            put(one ? (0xFFFFFFFFu >> (32 - n)) : 0, n);
+            count -= n;
+        }
+    }
+
+    // Добивает последний байт светлыми пикселями
+    void finish() {
+        if (bits_ > 0) fill(true, 8 - bits_);
+    }
+
+private:
+    uint8_t* out_;
+    uint64_t acc_ = 0;
+    int bits_ = 0;
+};
+
+// Строка модулей y -> 1-битная строка пикселей (1 — светлый)
+void expandRow1(const QRMatrix& matrix, int y, const RasterOptions& options, uint8_t* out) {
+    const int scale = options.scale;
+    const int size = matrix.size();
+    const uint8_t* modules = matrix.row(y);
+    BitWriter writer(out);
+
+    writer.fill(true, options.margin * scale);
+    int x = 0;
+    if (scale <= TABLE_MAX_SCALE) {
+        const uint32_t* table = expand_table.bits[scale];
+        for (; x + 4 <= size; x += 4) {
+            unsigned nibble = (modules[x >> 3] >> ((x & 4) ? 0 : 4)) & 0xF;
+            writer.put(table[~nibble & 0xF], 4 * scale);
+        }
+    }
+    for (; x < size; x++) {
+        writer.fill(!matrix.get(x, y), scale);
+    }
+    writer.fill(true, options.margin * scale);
+    writer.finish();
+}
+
+// Строка модулей y -> 8-битная строка пикселей
+void expandRow8(const QRMatrix& matrix, int y, const RasterOptions& options, uint8_t* out) {
+    const int scale = options.scale;
+    const int edge = options.margin * scale;
+    memset(out, 0xFF, edge);
+    out += edge;
+    for (int x = 0; x < matrix.size(); x++) {
+        memset(out, matrix.get(x, y) ? 0x00 : 0xFF, scale);
+        out += scale;
+    }
+    memset(out, 0xFF, edge);
+}
+
+} // namespace
+
+std::string RasterOptions::key() const {
+    return "s" + std::to_string(scale) + "m" + std::to_string(margin) +
+           "d" + std::to_string(bit_depth);
+}
+
+void QRRaster::validate(const RasterOptions& options) {
+    if (options.scale < 1 || options.scale > MAX_SCALE) {
+        LOG_ERROR("Invalid raster scale: " + std::to_string(options.scale));
+        throw std::runtime_error("Invalid raster scale (1.." + std::to_string(MAX_SCALE) + ")");
+    }
+    if (options.margin < 0 || options.margin > MAX_MARGIN) {
+        LOG_ERROR("Invalid raster margin: " + std::to_string(options.margin));
+        throw std::runtime_error("Invalid raster margin (0.." + std::to_string(MAX_MARGIN) + ")");
+    }
+    if (options.bit_depth != 1 && options.bit_depth != 8) {
+        LOG_ERROR("Invalid raster bit depth: " + std::to_string(options.bit_depth));
+        throw std::runtime_error("Invalid raster bit depth (1 or 8)");
+    }
+}
+
+int QRRaster::imageSize(const QRMatrix& matrix, const RasterOptions& options) {
+    return (matrix.size() + 2 * options.margin) * options.scale;
+}
+
+size_t QRRaster::rowBytes(int width, int bit_depth) {
+    return (static_cast<size_t>(width) * bit_depth + 7) / 8;
+}
+
+void QRRaster::rasterize(const QRMatrix& matrix, const RasterOptions& options,
+                         const RowSink& emit) {
+    validate(options);
+    const size_t bytes = rowBytes(imageSize(matrix, options), options.bit_depth);
+    const int edge_rows = options.margin * options.scale;
+
+    ArenaVector<uint8_t> row(bytes);
+    ArenaVector<uint8_t> blank;
+    if (edge_rows > 0) {
+        blank.assign(bytes, 0xFF);
+        emit(blank.data(), edge_rows);
+    }
+
+    // Повторяющиеся строки модулей (синхронизация, поисковые узоры) не разворачиваются заново
+    int pending = 0;
+    for (int y = 0; y < matrix.size(); y++) {
+        if (pending > 0 && memcmp(matrix.row(y), matrix.row(y - 1), matrix.stride()) == 0) {
+            pending += options.scale;
+            continue;
+        }
+        if (pending > 0) {
+            emit(row.data(), pending);
+        }
+        if (options.bit_depth == 1) {
+            expandRow1(matrix, y, options, row.data());
+        } else {
+            expandRow8(matrix, y, options, row.data());
+        }
+        pending = options.scale;
+    }
+    if (pending > 0) {
+        emit(row.data(), pending);
+    }
+
+    if (edge_rows > 0) {
+        emit(blank.data(), edge_rows);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef QR_RASTER_H
+#define QR_RASTER_H
+
+#include <cstdint>
+#include <string>
+#include "qr_matrix.h"
+
+/**
+ * Параметры растеризации символа
+ */
+struct RasterOptions {
+    int scale = 1;       // пикселей на модуль по каждой оси
+    int margin = 0;      // светлое поле вокруг символа, в модулях (ISO/IEC 18004: 4)
+    int bit_depth = 1;   // 1 или 8 бит на пиксель (оттенки серого)
+
+    /**
+     * Короткая строка для ключа кэша, например "s4m4d1"
+     */
+    std::string key() const;
+};
+
+/**
+ * Растеризатор: разворачивает модули в пиксельные строки оттенков серого
+ * (тёмный модуль — 0, светлый и поле — максимум яркости).
+ *
+ * Строка 1-битного изображения собирается по таблице: полубайт модулей
+ * превращается сразу в 4 * scale бит. Каждая строка модулей разворачивается
+ * один раз и отдаётся вместе с числом повторов, одинаковые соседние строки
+ * символа и строки поля склеиваются в один вызов.
+ */
+class QRRaster {
+public:
+    static const int MAX_SCALE = 32;
+    static const int MAX_MARGIN = 16;
+
+    /**
+     * Получатель строк: row — упакованная строка пикселей (rowBytes байт),
+     * repeat — сколько раз подряд она повторяется в изображении.
+     * Ссылка на вызываемый объект без копирования и выделения памяти
+     * (в отличие от std::function с большим замыканием): объект должен
+     * жить до возврата из rasterize, что для лямбды-аргумента так и есть.
+     */
+    class RowSink {
+    public:
+        template <typename Function>
+        RowSink(const Function& function)
+            : object_(&function),
+              call_([](const void* object, const uint8_t* row, int repeat) {
+                  (*static_cast<const Function*>(object))(row, repeat);
+              }) {}
+
+        void operator()(const uint8_t* row, int repeat) const { call_(object_, row, repeat); }
+
+    private:
+        const void* object_;
+        void (*call_)(const void* object, const uint8_t* row, int repeat);
+    };
+
+    /**
+     * Проверяет параметры
+     * @throws std::runtime_error При недопустимом масштабе, поле или глубине
+     */
+    static void validate(const RasterOptions& options);
+
+    /**
+     * Ширина и высота изображения в пикселях
+     */
+    static int imageSize(const QRMatrix& matrix, const RasterOptions& options);
+
+    /**
+     * Байт в строке пикселей заданной ширины
+     */
+    static size_t rowBytes(int width, int bit_depth);
+
+    /**
+     * Растеризует символ сверху вниз
+     * @param matrix Матрица модулей
+     * @param options Масштаб, поле и глубина
+     * @param emit Получатель строк
+     */
+    static void rasterize(const QRMatrix& matrix, const RasterOptions& options,
+                          const RowSink& emit);
+};
+
+#endif // QR_RASTER_H
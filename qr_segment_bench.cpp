@@ -0,0 +1,190 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "qr_encoder.h"
+
+/**
+ * Сверка и бенчмарк разбиения на сегменты на корпусе, похожем на
+ * реальные запросы: ссылки (обычные, короткие, в верхнем регистре),
+ * артикулы, штрихкоды EAN-13 и строки GS1.
+ *
+ * Сверка: сегменты покрывают данные без пропусков, каждый символ
+ * допустим в режиме своего сегмента, а разбиение не длиннее
+ * байтового режима и любого однорежимного.
+ *
+ * Бенчмарк: средняя версия, площадь символа в модулях и длина данных
+ * в битах для байтового режима и для разбиения, по категориям корпуса
+ * и уровням коррекции, и время кодирования в микросекундах.
+ */
+
+namespace {
+
+struct Category {
+    const char* name;
+    std::vector<std::string> samples;
+};
+
+unsigned next(unsigned& seed) {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 16;
+}
+
+std::string randomString(unsigned& seed, const char* alphabet, size_t length) {
+    const size_t size = std::char_traits<char>::length(alphabet);
+    std::string result;
+    for (size_t i = 0; i < length; i++) {
+        result.push_back(alphabet[next(seed) % size]);
+    }
+    return result;
+}
+
+std::string digits(unsigned& seed, size_t length) {
+    return randomString(seed, "0123456789", length);
+}
+
+std::vector<Category> corpus() {
+    const char* LOWER = "abcdefghijklmnopqrstuvwxyz";
+    const char* BASE62 = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    const char* UPPER = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const char* COLORS[] = {"BLK", "WHT", "RED", "NVY", "GRN"};
+    const char* SIZES[] = {"XS", "S", "M", "L", "XL", "XXL"};
+
+    std::vector<Category> categories = {
+        {"url", {}}, {"short url", {}}, {"upper url", {}},
+        {"sku", {}}, {"ean-13", {}}, {"gs1", {}},
+    };
+    unsigned seed = 2024;
+    for (int i = 0; i < 200; i++) {
+        categories[0].samples.push_back(
+            "https://shop.example.com/products/" + randomString(seed, LOWER, 6 + next(seed) % 10) +
+            "-" + randomString(seed, LOWER, 4 + next(seed) % 6) + "-" + digits(seed, 6) +
+            "?utm_source=qr&utm_medium=print&utm_campaign=" + digits(seed, 4));
+        categories[1].samples.push_back("https://ex.co/" + randomString(seed, BASE62, 7));
+        categories[2].samples.push_back("HTTPS://EX.CO/P/" + digits(seed, 8) + "/" +
+                                        randomString(seed, UPPER, 4));
+        categories[3].samples.push_back("SKU-" + digits(seed, 6) + "-" + COLORS[next(seed) % 5] +
+                                        "-" + SIZES[next(seed) % 6]);
+        categories[4].samples.push_back(digits(seed, 13));
+        categories[5].samples.push_back("(01)" + digits(seed, 14) + "(17)" + digits(seed, 6) +
+                                        "(10)" + randomString(seed, UPPER, 3) + digits(seed, 5));
+    }
+    return categories;
+}
+
+bool allowed(QREncoder::Mode mode, unsigned char c) {
+    static const std::string ALPHANUMERIC = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+    switch (mode) {
+        case QREncoder::MODE_NUMERIC: return c >= '0' && c <= '9';
+        case QREncoder::MODE_ALPHANUMERIC: return c != 0 && ALPHANUMERIC.find(c) != std::string::npos;
+        case QREncoder::MODE_BYTE: return true;
+    }
+    return false;
+}
+
+// Длина данных одним сегментом режима mode, 0 — режим не подходит
+size_t singleModeBits(const std::string& data, QREncoder::Mode mode, int version) {
+    for (unsigned char c : data) {
+        if (!allowed(mode, c)) return 0;
+    }
+    return QREncoder::segmentBits({{mode, 0, data.size()}}, version);
+}
+
+int crossCheck(const std::vector<Category>& categories) {
+    int checked = 0, failures = 0;
+    for (const Category& category : categories) {
+        for (const std::string& data : category.samples) {
+            for (int version : {1, 10, 27}) {
+                ArenaVector<QREncoder::Segment> segments = QREncoder::optimizeSegments(data, version);
+                const size_t bits = QREncoder::segmentBits(segments, version);
+                bool ok = true;
+                size_t offset = 0;
+                for (const auto& segment : segments) {
+                    ok = ok && segment.offset == offset && segment.length > 0;
+                    for (size_t i = 0; ok && i < segment.length; i++) {
+                        ok = allowed(segment.mode, data[segment.offset + i]);
+                    }
+                    offset += segment.length;
+                }
+                ok = ok && offset == data.size();
+                for (QREncoder::Mode mode : {QREncoder::MODE_NUMERIC, QREncoder::MODE_ALPHANUMERIC,
+                                             QREncoder::MODE_BYTE}) {
+                    const size_t single = singleModeBits(data, mode, version);
+                    ok = ok && (single == 0 || bits <= single);
+                }
+                checked++;
+                if (!ok) {
+                    failures++;
+                    std::printf("MISMATCH version=%d data=%s\n", version, data.c_str());
+                }
+            }
+        }
+    }
+    std::printf("cross-check: %d samples, %d mismatches\n", checked, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+struct Totals {
+    double version = 0;
+    double modules = 0;
+    double bits = 0;
+    double micros = 0;
+};
+
+Totals measure(const std::vector<std::string>& samples, const EncodeOptions& options) {
+    Totals totals;
+    for (const std::string& data : samples) {
+        QRMatrix matrix = QREncoder::encode(data, options);
+        totals.version += matrix.version();
+        totals.modules += static_cast<double>(matrix.size()) * matrix.size();
+        ArenaVector<QREncoder::Segment> segments =
+            options.optimize_segments ? QREncoder::optimizeSegments(data, matrix.version())
+                                      : ArenaVector<QREncoder::Segment>{{QREncoder::MODE_BYTE, 0, data.size()}};
+        totals.bits += QREncoder::segmentBits(segments, matrix.version());
+    }
+
+    // Второй проход замеряется: разметки версий уже построены первым
+    const auto start = std::chrono::steady_clock::now();
+    for (const std::string& data : samples) {
+        QREncoder::encode(data, options);
+    }
+    totals.micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    const double count = static_cast<double>(samples.size());
+    totals.version /= count;
+    totals.modules /= count;
+    totals.bits /= count;
+    totals.micros /= count;
+    return totals;
+}
+
+void sizeReduction(const std::vector<Category>& categories) {
+    static const char LEVEL_NAMES[] = "LMQH";
+    std::printf("\n%-10s %2s %15s %15s %15s %9s %15s\n", "corpus", "ec", "version b/s",
+                "modules b/s", "bits b/s", "modules", "encode us b/s");
+    for (const Category& category : categories) {
+        for (QREncoder::ECLevel level : {QREncoder::EC_L, QREncoder::EC_M, QREncoder::EC_Q,
+                                         QREncoder::EC_H}) {
+            EncodeOptions options;
+            options.level = level;
+            options.optimize_segments = false;
+            const Totals bytes = measure(category.samples, options);
+            options.optimize_segments = true;
+            const Totals segments = measure(category.samples, options);
+            std::printf("%-10s %2c %7.2f/%7.2f %7.0f/%7.0f %7.0f/%7.0f %8.1f%% %7.1f/%7.1f\n",
+                        category.name, LEVEL_NAMES[level], bytes.version, segments.version,
+                        bytes.modules, segments.modules, bytes.bits, segments.bits,
+                        100.0 * (1.0 - segments.modules / bytes.modules), bytes.micros,
+                        segments.micros);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    const std::vector<Category> categories = corpus();
+    int status = crossCheck(categories);
+    sizeReduction(categories);
+    return status;
+}
@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "logging.h"
+#include "metrics.h"
+#include "qr_encoder.h"
+#include "qr_generator.h"
+#include "qr_mask.h"
+#include "qr_png.h"
+#include "qr_raster.h"
+
+/**
+ * Микробенчмарки стадий libqr по всем версиям и уровням коррекции.
+ *
+ * Стадии (наносекунд на операцию):
+ *   encode    данные -> матрица с фиксированной маской 0: упаковка бит,
+ *             Рид-Соломон, размещение модулей
+ *   mask      выбор маски: восемь кандидатов, штрафы, лучший — так же,
+ *             как в QREncoder::buildMatrix
+ *   rasterize развёртка модулей в пиксельные строки без получателя
+ *   compress  deflate внутри PNGWriter::write (по метрике STAGE_COMPRESS)
+ *   png       PNGWriter::write целиком: растеризация, фильтр, deflate, чанки
+ *   generate  QRGenerator::generateQRImage с выбранным бэкендом — сквозной путь
+ *
+ * Данные — печатные байты, заполняющие версию до предела на своём уровне,
+ * поэтому каждая строка таблицы измеряет именно эту версию. Каждая
+ * стадия меряется --rounds раз по --min-time, в отчёт идёт лучший
+ * раунд: он меньше всего зависит от соседей по машине.
+ *
+ * --json пишет результаты в файл, --compare сверяет их с сохранённым
+ * базовым файлом и завершается с кодом 1, если какая-либо стадия
+ * замедлилась больше чем на --threshold процентов. С --current
+ * сравниваются два готовых файла без запуска замеров.
+ */
+
+namespace {
+
+enum Stage {
+    STAGE_ENCODE,
+    STAGE_MASK,
+    STAGE_RASTERIZE,
+    STAGE_COMPRESS,
+    STAGE_PNG,
+    STAGE_GENERATE,
+    STAGE_COUNT
+};
+
+const char* const STAGE_NAMES[STAGE_COUNT] = {
+    "encode", "mask", "rasterize", "compress", "png", "generate"
+};
+
+struct BenchConfig {
+    int min_version = QREncoder::MIN_VERSION;
+    int max_version = QREncoder::MAX_VERSION;
+    std::string levels = "LMQH";
+    bool stages[STAGE_COUNT] = {true, true, true, true, true, true};
+    int min_time_ms = 20;
+    int rounds = 3;
+    RasterOptions raster = {4, 4, 1};
+    PNGWriter::Compression compression = PNGWriter::COMPRESSION_FAST;
+    QRGenerator::Backend backend = QRGenerator::BACKEND_NATIVE;
+    std::string json;
+    std::string compare;
+    std::string current;
+    double threshold = 10.0;   // процентов
+};
+
+/**
+ * Результат одной стадии; ключ сравнения — стадия, версия и уровень
+ */
+struct Result {
+    std::string stage;
+    int version;
+    std::string level;
+    double ns;
+};
+
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [--versions N|MIN-MAX] [--levels LMQH]"
+              << " [--stages encode,mask,rasterize,compress,png,generate]"
+              << " [--min-time MS] [--rounds N] [--scale N] [--margin N] [--bit-depth 1|8]"
+              << " [--png-compression store|fast|best] [--backend native|libqrencode]"
+              << " [--json FILE] [--compare BASELINE.json] [--current FILE] [--threshold PCT]"
+              << std::endl;
+}
+
+void parseStages(const std::string& value, bool* stages) {
+    std::fill(stages, stages + STAGE_COUNT, false);
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t comma = value.find(',', start);
+        if (comma == std::string::npos) comma = value.size();
+        const std::string name = value.substr(start, comma - start);
+        const char* const* found = std::find(STAGE_NAMES, STAGE_NAMES + STAGE_COUNT, name);
+        if (found == STAGE_NAMES + STAGE_COUNT) {
+            throw std::runtime_error("Unknown stage: " + name);
+        }
+        stages[found - STAGE_NAMES] = true;
+        start = comma + 1;
+    }
+}
+
+BenchConfig parseArgs(int argc, char* argv[]) {
+    BenchConfig config;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                exit(EXIT_SUCCESS);
+            }
+            if (i + 1 >= argc) {
+                printUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            std::string value = argv[++i];
+            if (arg == "--versions") {
+                size_t dash = value.find('-');
+                config.min_version = std::stoi(value.substr(0, dash));
+                config.max_version = dash == std::string::npos ? config.min_version
+                                                               : std::stoi(value.substr(dash + 1));
+            } else if (arg == "--levels") {
+                for (char c : value) QREncoder::parseLevel(std::string(1, c));
+                config.levels = value;
+            } else if (arg == "--stages") {
+                parseStages(value, config.stages);
+            } else if (arg == "--min-time") {
+                config.min_time_ms = std::max(1, std::stoi(value));
+            } else if (arg == "--rounds") {
+                config.rounds = std::max(1, std::stoi(value));
+            } else if (arg == "--scale") {
+                config.raster.scale = std::stoi(value);
+            } else if (arg == "--margin") {
+                config.raster.margin = std::stoi(value);
+            } else if (arg == "--bit-depth") {
+                config.raster.bit_depth = std::stoi(value);
+            } else if (arg == "--png-compression") {
+                config.compression = PNGWriter::parseCompression(value);
+            } else if (arg == "--backend") {
+                config.backend = QRGenerator::parseBackend(value);
+            } else if (arg == "--json") {
+                config.json = value;
+            } else if (arg == "--compare") {
+                config.compare = value;
+            } else if (arg == "--current") {
+                config.current = value;
+            } else if (arg == "--threshold") {
+                config.threshold = std::stod(value);
+            } else {
+                printUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        QRRaster::validate(config.raster);
+        if (config.min_version < QREncoder::MIN_VERSION ||
+            config.max_version > QREncoder::MAX_VERSION ||
+            config.min_version > config.max_version) {
+            throw std::runtime_error("Invalid version range");
+        }
+        if (!config.current.empty() && config.compare.empty()) {
+            throw std::runtime_error("--current requires --compare");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return config;
+}
+
+// Печатные байты: libqrencode принимает строку до первого нуля
+std::string makePayload(size_t length, unsigned seed) {
+    std::string payload;
+    payload.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        payload.push_back(static_cast<char>('a' + (seed >> 16) % 26));
+    }
+    return payload;
+}
+
+// Наибольшая длина в байтовом режиме, помещающаяся в версию на уровне level
+size_t capacity(int version, QREncoder::ECLevel level) {
+    size_t header = 4 + (version < 10 ? 8 : 16);
+    return (QREncoder::dataCodewords(version, level) * 8 - header) / 8;
+}
+
+template <typename Body>
+double nanosecondsPer(Body body, int min_time_ms) {
+    const auto limit = std::chrono::milliseconds(min_time_ms);
+    const auto start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    do {
+        for (int i = 0; i < 4; i++) body();
+        count += 4;
+    } while (std::chrono::steady_clock::now() - start < limit);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+           count;
+}
+
+template <typename Body>
+double bestOf(const BenchConfig& config, Body body) {
+    double best = nanosecondsPer(body, config.min_time_ms);
+    for (int r = 1; r < config.rounds; r++) {
+        best = std::min(best, nanosecondsPer(body, config.min_time_ms));
+    }
+    return best;
+}
+
+// Выбор маски по образцу QREncoder::buildMatrix: unmasked — символ без маски
+QRMatrix selectMask(const QRMatrix& unmasked, QREncoder::ECLevel level) {
+    struct Candidates {
+        QRMatrix matrices[8];
+        int penalties[8];
+    } candidates;
+    for (int m = 0; m < 8; m++) {
+        candidates.matrices[m] = unmasked;
+    }
+    QRMask::forEachMask([&candidates, level](int m) {
+        QRMatrix& candidate = candidates.matrices[m];
+        QREncoder::applyMask(candidate, m);
+        QREncoder::drawFormatBits(candidate, level, m);
+        candidates.penalties[m] = QRMask::penalty(candidate);
+    }, unmasked.version() >= QRMask::PARALLEL_MIN_VERSION);
+
+    int best = 0;
+    for (int m = 1; m < 8; m++) {
+        if (candidates.penalties[m] < candidates.penalties[best]) best = m;
+    }
+    return std::move(candidates.matrices[best]);
+}
+
+/**
+ * Замеры всех выбранных стадий для одной версии и уровня
+ */
+void measure(const BenchConfig& config, int version, QREncoder::ECLevel level, double* ns) {
+    const std::string payload = makePayload(capacity(version, level), version * 4 + level);
+    // Символ без маски: маска 0 снимается повторным XOR
+    QRMatrix unmasked = QREncoder::encode(payload, level, version, version, 0);
+    QREncoder::applyMask(unmasked, 0);
+    const QRMatrix symbol = selectMask(unmasked, level);
+    std::string output;
+    output.reserve(1 << 20);
+
+    // Метрики нужны только стадии compress: остальным не мешают часы
+    Metrics::setEnabled(false);
+    if (config.stages[STAGE_ENCODE]) {
+        ns[STAGE_ENCODE] = bestOf(config, [&] {
+            QREncoder::encode(payload, level, version, version, 0);
+        });
+    }
+    if (config.stages[STAGE_MASK]) {
+        ns[STAGE_MASK] = bestOf(config, [&] { selectMask(unmasked, level); });
+    }
+    if (config.stages[STAGE_RASTERIZE]) {
+        size_t rows = 0;
+        ns[STAGE_RASTERIZE] = bestOf(config, [&] {
+            QRRaster::rasterize(symbol, config.raster, [&rows](const uint8_t*, int repeat) {
+                rows += repeat;
+            });
+        });
+    }
+    if (config.stages[STAGE_PNG]) {
+        ns[STAGE_PNG] = bestOf(config, [&] {
+            output.clear();
+            PNGWriter::write(symbol, config.raster, config.compression, output);
+        });
+    }
+    if (config.stages[STAGE_COMPRESS]) {
+        // Лучший раунд по доле deflate, замеренной внутри PNGWriter
+        Metrics::setEnabled(true);
+        double best = 0;
+        for (int r = 0; r < config.rounds; r++) {
+            const Metrics::Histogram before = Metrics::snapshot().stages[Metrics::STAGE_COMPRESS];
+            nanosecondsPer([&] {
+                output.clear();
+                PNGWriter::write(symbol, config.raster, config.compression, output);
+            }, config.min_time_ms);
+            const Metrics::Histogram after = Metrics::snapshot().stages[Metrics::STAGE_COMPRESS];
+            const double round = static_cast<double>(after.sum - before.sum) /
+                                 std::max<uint64_t>(1, after.count - before.count);
+            best = r == 0 ? round : std::min(best, round);
+        }
+        ns[STAGE_COMPRESS] = best;
+        Metrics::setEnabled(false);
+    }
+    if (config.stages[STAGE_GENERATE]) {
+        EncodeOptions encoding;
+        encoding.level = level;
+        encoding.min_version = version;
+        encoding.max_version = version;
+        encoding.optimize_segments = false;
+        ns[STAGE_GENERATE] = bestOf(config, [&] {
+            output.clear();
+            QRGenerator::generateQRImage(payload, output, config.raster, QROutput::FORMAT_PNG,
+                                         encoding);
+        });
+    }
+    Metrics::setEnabled(true);
+}
+
+std::vector<Result> run(const BenchConfig& config) {
+    QRGenerator::setBackend(config.backend);
+    QRGenerator::setPngCompression(config.compression);
+
+    std::vector<Result> results;
+    std::printf("backend %s, mask kernel %s, raster %s, png %s; us per operation\n",
+                config.backend == QRGenerator::BACKEND_NATIVE ? "native" : "libqrencode",
+                QRMask::kernelName(QRMask::kernel()), config.raster.key().c_str(),
+                PNGWriter::compressionName(config.compression));
+    std::printf("%7s %5s", "version", "level");
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        if (config.stages[s]) std::printf(" %10s", STAGE_NAMES[s]);
+    }
+    std::printf("\n");
+
+    for (int version = config.min_version; version <= config.max_version; version++) {
+        for (char name : config.levels) {
+            const QREncoder::ECLevel level = QREncoder::parseLevel(std::string(1, name));
+            double ns[STAGE_COUNT] = {};
+            measure(config, version, level, ns);
+
+            std::printf("%7d %5s", version, QREncoder::levelName(level));
+            for (int s = 0; s < STAGE_COUNT; s++) {
+                if (!config.stages[s]) continue;
+                std::printf(" %10.2f", ns[s] / 1e3);
+                results.push_back({STAGE_NAMES[s], version, QREncoder::levelName(level), ns[s]});
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+    }
+    return results;
+}
+
+void writeJson(const BenchConfig& config, const std::vector<Result>& results) {
+    std::ofstream out(config.json, std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + config.json);
+    }
+    // Один результат на строку: файл читается readJson и удобно сравнивается diff
+    out << "{\n"
+        << "  \"benchmark\": \"qr_stage_bench\",\n"
+        << "  \"backend\": \"" << (config.backend == QRGenerator::BACKEND_NATIVE ? "native" : "libqrencode")
+        << "\",\n"
+        << "  \"mask_kernel\": \"" << QRMask::kernelName(QRMask::kernel()) << "\",\n"
+        << "  \"raster\": \"" << config.raster.key() << "\",\n"
+        << "  \"png_compression\": \"" << PNGWriter::compressionName(config.compression) << "\",\n"
+        << "  \"min_time_ms\": " << config.min_time_ms << ",\n"
+        << "  \"rounds\": " << config.rounds << ",\n"
+        << "  \"results\": [\n";
+    char line[160];
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        snprintf(line, sizeof(line),
+                 "    {\"stage\": \"%s\", \"version\": %d, \"level\": \"%s\", \"ns\": %.1f}%s\n",
+                 r.stage.c_str(), r.version, r.level.c_str(), r.ns,
+                 i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ]\n}\n";
+}
+
+/**
+ * Читает результаты из файла, записанного writeJson
+ */
+std::vector<Result> readJson(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot read " + path);
+    }
+    std::vector<Result> results;
+    std::string line;
+    while (std::getline(in, line)) {
+        char stage[32];
+        char level[4];
+        Result result;
+        if (sscanf(line.c_str(), " {\"stage\": \"%31[^\"]\", \"version\": %d, \"level\": \"%3[^\"]\", \"ns\": %lf",
+                   stage, &result.version, level, &result.ns) == 4) {
+            result.stage = stage;
+            result.level = level;
+            results.push_back(result);
+        }
+    }
+    if (results.empty()) {
+        throw std::runtime_error("No results in " + path);
+    }
+    return results;
+}
+
+/**
+ * Сравнивает результаты с базой: печатает замедления сверх порога
+ * и среднее геометрическое отношение по каждой стадии
+ * @return Число замедлений сверх порога
+ */
+int compare(const std::vector<Result>& baseline, const std::vector<Result>& current,
+            double threshold) {
+    std::map<std::string, double> base;
+    for (const Result& r : baseline) {
+        base[r.stage + "/" + std::to_string(r.version) + "/" + r.level] = r.ns;
+    }
+
+    struct Summary {
+        double log_sum = 0;
+        int count = 0;
+        int slower = 0;
+    };
+    std::map<std::string, Summary> stages;
+    int regressions = 0;
+    int missing = 0;
+    std::printf("\ncompare against baseline, threshold %.1f%%\n", threshold);
+    for (const Result& r : current) {
+        auto it = base.find(r.stage + "/" + std::to_string(r.version) + "/" + r.level);
+        if (it == base.end() || it->second <= 0 || r.ns <= 0) {
+            missing++;
+            continue;
+        }
+        const double ratio = r.ns / it->second;
+        Summary& summary = stages[r.stage];
+        summary.log_sum += std::log(ratio);
+        summary.count++;
+        if ((ratio - 1) * 100 > threshold) {
+            std::printf("SLOWER %-9s version %2d level %s: %10.2f us -> %10.2f us (%+.1f%%)\n",
+                        r.stage.c_str(), r.version, r.level.c_str(), it->second / 1e3, r.ns / 1e3,
+                        (ratio - 1) * 100);
+            summary.slower++;
+            regressions++;
+        }
+    }
+    for (const auto& entry : stages) {
+        const Summary& s = entry.second;
+        std::printf("%-9s geomean %+6.1f%%, %d of %d cases slower than threshold\n",
+                    entry.first.c_str(), (std::exp(s.log_sum / s.count) - 1) * 100, s.slower,
+                    s.count);
+    }
+    if (missing) {
+        std::printf("%d results without a baseline\n", missing);
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config = parseArgs(argc, argv);
+    Logger::setLevel(Logger::ERROR);
+
+    try {
+        std::vector<Result> results = config.current.empty() ? run(config) : readJson(config.current);
+        if (!config.json.empty() && config.current.empty()) {
+            writeJson(config, results);
+        }
+        if (!config.compare.empty()) {
+            return compare(readJson(config.compare), results, config.threshold) == 0
+                       ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
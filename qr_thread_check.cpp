@@ -0,0 +1,147 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "logging.h"
+#include "qr_generator.h"
+
+/**
+ * Проверка реентерабельности QRGenerator::generate*Image из N потоков.
+ *
+ * Каждому потоку достаётся свой набор различных содержимых: тексты
+ * разной длины (версии от малых до 40, чтобы задействовать и помощников
+ * выбора маски) и координаты. Эталон для каждого содержимого строится
+ * заранее в одном потоке. Затем потоки стартуют одновременно и строят
+ * свои изображения в формате RAW (упакованная матрица модулей — без
+ * внешнего декодера видно, тот ли символ получен) и PNG; каждое
+ * сравнивается байт в байт с эталоном своего содержимого.
+ * Любое расхождение или исключение — код возврата 1.
+ *
+ * Использование: qr_thread_check [потоков] [запросов на поток] [native|libqrencode]
+ */
+
+namespace {
+
+struct Item {
+    bool location;
+    std::string text;
+    double latitude;
+    double longitude;
+    std::string raw;   // эталоны
+    std::string png;
+};
+
+// Длины текстов покрывают версии от 1 до 40 байтовым режимом уровня L
+const size_t TEXT_LENGTHS[] = {8, 40, 120, 300, 700, 1200, 2000, 2900};
+
+std::string makeText(int thread, int index) {
+    std::string text = "thread " + std::to_string(thread) + " item " + std::to_string(index) + ":";
+    const size_t length = TEXT_LENGTHS[(thread + index) % (sizeof(TEXT_LENGTHS) / sizeof(TEXT_LENGTHS[0]))];
+    unsigned seed = static_cast<unsigned>(thread * 7919 + index);
+    while (text.size() < length) {
+        seed = seed * 1103515245u + 12345u;
+        text.push_back(static_cast<char>('a' + (seed >> 16) % 26));
+    }
+    return text;
+}
+
+void render(const Item& item, QROutput::Format format, std::string& output) {
+    output.clear();
+    if (item.location) {
+        QRGenerator::generateLocationQRImage(item.latitude, item.longitude, output, 15,
+                                             RasterOptions(), format);
+    } else {
+        QRGenerator::generateQRImage(item.text, output, RasterOptions(), format);
+    }
+}
+
+// Заголовок RAW: байт версии, затем size строк по (size + 7) / 8 байт
+bool rawLooksValid(const std::string& raw) {
+    if (raw.empty()) return false;
+    const int version = static_cast<uint8_t>(raw[0]);
+    if (version < 1 || version > 40) return false;
+    const size_t size = static_cast<size_t>(version) * 4 + 17;
+    return raw.size() == 1 + size * ((size + 7) / 8);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int threads = argc > 1 ? std::atoi(argv[1]) : 8;
+    const int per_thread = argc > 2 ? std::atoi(argv[2]) : 64;
+    if (threads <= 0 || per_thread <= 0) {
+        std::fprintf(stderr, "Usage: %s [threads] [requests per thread] [native|libqrencode]\n", argv[0]);
+        return 2;
+    }
+    Logger::setLevel(Logger::WARNING);
+    try {
+        QRGenerator::setBackend(QRGenerator::parseBackend(argc > 3 ? argv[3] : "native"));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+
+    // Эталоны строятся в одном потоке
+    std::vector<std::vector<Item>> items(threads);
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < per_thread; i++) {
+            Item item;
+            item.location = i % 4 == 3;
+            if (item.location) {
+                const int n = (t * per_thread + i) % 160000;
+                item.latitude = -80.0 + n * 0.001;
+                item.longitude = 170.0 - n * 0.002;
+            } else {
+                item.text = makeText(t, i);
+            }
+            render(item, QROutput::FORMAT_RAW, item.raw);
+            render(item, QROutput::FORMAT_PNG, item.png);
+            if (!rawLooksValid(item.raw)) {
+                std::printf("BAD RAW thread %d item %d: %zu bytes\n", t, i, item.raw.size());
+                return 1;
+            }
+            items[t].push_back(std::move(item));
+        }
+    }
+
+    std::atomic<int> ready{0};
+    std::atomic<int> mismatches{0};
+    std::atomic<int> errors{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            ready.fetch_add(1);
+            while (ready.load() < threads) std::this_thread::yield();
+
+            std::string output;
+            for (int i = 0; i < per_thread; i++) {
+                const Item& item = items[t][i];
+                try {
+                    render(item, QROutput::FORMAT_RAW, output);
+                    if (output != item.raw) {
+                        if (mismatches.fetch_add(1) < 10) {
+                            std::printf("MISMATCH raw thread %d item %d\n", t, i);
+                        }
+                    }
+                    render(item, QROutput::FORMAT_PNG, output);
+                    if (output != item.png) {
+                        if (mismatches.fetch_add(1) < 10) {
+                            std::printf("MISMATCH png thread %d item %d\n", t, i);
+                        }
+                    }
+                } catch (const std::exception& e) {
+                    if (errors.fetch_add(1) < 10) {
+                        std::printf("ERROR thread %d item %d: %s\n", t, i, e.what());
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    std::printf("thread check: %d threads x %d requests, %d mismatches, %d errors\n",
+                threads, per_thread, mismatches.load(), errors.load());
+    return mismatches.load() == 0 && errors.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,678 @@
+#include "reactor.h"
+#include "logging.h"
+#include "metrics.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const int MAX_EVENTS = 256;
+const size_t READ_CHUNK = 16 * 1024;
+const int BLOCKED_RETRY_MS = 5;   // повтор постановки в заполненный пул (BLOCK)
+
+void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        throw std::runtime_error("Failed to set O_NONBLOCK: " + std::string(strerror(errno)));
+    }
+}
+
+// Запрос явно не относится к протоколу — не ждём остатка данных
+bool hasInvalidPrefix(const std::string& input) {
+    if (input.size() < 4) {
+        return false;
+    }
+    return input.compare(0, 4, "TEXT") != 0 && input.compare(0, 4, "GEO:") != 0 &&
+           input.compare(0, 4, "STAT") != 0;
+}
+
+// Отрезает один завершающий "\n" или "\r\n"
+void stripLineEnd(std::string& input) {
+    if (!input.empty() && input.back() == '\n') {
+        input.pop_back();
+        if (!input.empty() && input.back() == '\r') input.pop_back();
+    }
+}
+
+uint64_t nowMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+Reactor::Reactor(int listen_fd, WorkerPool& pool, RequestHandler handler,
+                 FrameHandler frame_handler, ReactorLimits limits)
+    : listen_fd_(listen_fd), pool_(pool), handler_(std::move(handler)),
+      frame_handler_(std::move(frame_handler)), limits_(limits) {
+    if (limits_.max_pipeline == 0) limits_.max_pipeline = 1;
+    setNonBlocking(listen_fd_);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        LOG_ERROR("epoll_create1 failed");
+        throw std::runtime_error("epoll_create1 failed");
+    }
+
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0) {
+        close(epoll_fd_);
+        LOG_ERROR("eventfd failed");
+        throw std::runtime_error("eventfd failed");
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = listen_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev);
+
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = event_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev);
+}
+
+Reactor::~Reactor() {
+    for (auto& entry : connections_) {
+        close(entry.first);
+    }
+    close(event_fd_);
+    close(epoll_fd_);
+}
+
+void Reactor::run() {
+    running_ = true;
+    epoll_event events[MAX_EVENTS];
+
+    while (running_) {
+        int n = epoll_wait(epoll_fd_, events, MAX_EVENTS, nextTimeout());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("epoll_wait failed: " + std::string(strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd_) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == event_fd_) {
+                uint64_t counter;
+                while (read(event_fd_, &counter, sizeof(counter)) > 0) {}
+                drainCompletions();
+                continue;
+            }
+
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) continue;
+
+            if (events[i].events & EPOLLERR) {
+                closeConnection(fd);
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+                handleReadable(fd, it->second);
+                it = connections_.find(fd);
+                if (it == connections_.end()) continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                handleWritable(fd, it->second);
+            }
+        }
+        expireRequests();
+        retryBlocked();
+        resumeConnections();
+    }
+}
+
+int Reactor::nextTimeout() const {
+    if (!resumed_.empty()) {
+        return 0;
+    }
+    const int retry = blocked_.empty() ? -1 : BLOCKED_RETRY_MS;
+    if (deadlines_.empty()) {
+        return retry;
+    }
+    const uint64_t now = nowMs();
+    const uint64_t at = deadlines_.front().at;
+    const int timeout = at > now ? static_cast<int>(at - now) : 0;
+    return (retry >= 0 && retry < timeout) ? retry : timeout;
+}
+
+void Reactor::expireRequests() {
+    if (deadlines_.empty()) {
+        return;
+    }
+    const uint64_t now = nowMs();
+    while (!deadlines_.empty() && deadlines_.front().at <= now) {
+        const Deadline deadline = deadlines_.front();
+        deadlines_.pop_front();
+
+        auto it = connections_.find(deadline.fd);
+        if (it == connections_.end() || it->second.id != deadline.id ||
+            it->second.request_deadline != deadline.at) {
+            continue;
+        }
+        Connection& conn = it->second;
+        conn.request_deadline = 0;
+        if (conn.in_flight == 0 && !conn.close_after_write && !conn.input.empty()) {
+            LOG_DEBUG("Text request idle for " + std::to_string(limits_.request_timeout_ms) +
+                      " ms, handling it as complete");
+            dispatchRequest(deadline.fd, conn);
+        }
+    }
+}
+
+void Reactor::stop() {
+    running_ = false;
+    uint64_t one = 1;
+    if (write(event_fd_, &one, sizeof(one)) < 0) {
+        LOG_ERROR("Failed to wake up reactor");
+    }
+}
+
+void Reactor::acceptConnections() {
+    while (true) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            LOG_ERROR("Accept failed: " + std::string(strerror(errno)));
+            return;
+        }
+
+        // Ответы уходят по мере готовности: Nagle задержал бы ответ до ACK
+        // предыдущего, а клиент откладывает ACK до своего следующего запроса
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            LOG_ERROR("epoll_ctl(ADD) failed: " + std::string(strerror(errno)));
+            close(fd);
+            continue;
+        }
+
+        Connection& conn = connections_[fd];
+        conn = Connection();
+        conn.id = next_id_++;
+        active_connections_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Reactor::handleReadable(int fd, Connection& conn) {
+    // Edge-triggered: читаем до EAGAIN, иначе следующего события не будет.
+    // Исключение — приостановленное чтение: данные остаются в ядре,
+    // а чтение возобновится после ответа на часть запросов
+    char buffer[READ_CHUNK];
+    while (!conn.read_paused) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            if (conn.mode == MODE_UNKNOWN) {
+                conn.mode = (static_cast<uint8_t>(buffer[0]) == FRAME_MAGIC) ? MODE_FRAMED : MODE_LEGACY;
+                if (conn.mode == MODE_FRAMED) {
+                    conn.decoder = FrameDecoder(static_cast<uint32_t>(limits_.max_frame_size));
+                }
+            }
+
+            if (conn.mode == MODE_FRAMED) {
+                conn.decoder.feed(buffer, n);
+                processFrames(fd, conn);
+                if (connections_.find(fd) == connections_.end()) return;
+            } else if (conn.in_flight == 0 && !conn.close_after_write) {
+                conn.input.append(buffer, n);
+            }
+            continue;
+        }
+        if (n == 0) {
+            conn.read_closed = true;
+            break;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        closeConnection(fd);
+        return;
+    }
+
+    if (conn.mode == MODE_LEGACY) {
+        processLegacy(fd, conn);
+    } else {
+        handleWritable(fd, conn);
+    }
+}
+
+void Reactor::processLegacy(int fd, Connection& conn) {
+    if (conn.in_flight > 0 || conn.close_after_write) {
+        if (conn.read_closed && conn.in_flight == 0 && conn.output.empty()) {
+            closeConnection(fd);
+        }
+        return;
+    }
+
+    if (conn.input.size() > limits_.max_request_size) {
+        conn.request_deadline = 0;
+        conn.close_after_write = true;
+        queueOutput(conn, Response("ERROR:Request too large"));
+        handleWritable(fd, conn);
+        return;
+    }
+
+    if (hasInvalidPrefix(conn.input)) {
+        conn.request_deadline = 0;
+        dispatchRequest(fd, conn);
+        return;
+    }
+
+    // Перевод строки внутри запроса — часть текста; концом считается
+    // только перевод строки в конце всего принятого или закрытие клиентом
+    if (!conn.input.empty() && (conn.input.back() == '\n' || conn.read_closed)) {
+        conn.request_deadline = 0;
+        stripLineEnd(conn.input);
+        dispatchRequest(fd, conn);
+    } else if (conn.read_closed) {
+        closeConnection(fd);
+    } else if (!conn.input.empty() && limits_.request_timeout_ms > 0) {
+        // Запрос не завершён: ждём продолжения, отсчитывая срок от последних данных
+        conn.request_deadline = nowMs() + static_cast<uint64_t>(limits_.request_timeout_ms);
+        deadlines_.push_back(Deadline{conn.request_deadline, fd, conn.id});
+    }
+}
+
+void Reactor::processFrames(int fd, Connection& conn) {
+    FrameHeader header;
+    std::string payload;
+    try {
+        // Сначала раздаём начатый пакет: пока он не роздан, кадры не разбираются
+        dispatchBatch(fd, conn);
+        uint64_t started = Metrics::now();
+        while (canDispatch(conn) && !batchPending(conn) && conn.decoder.next(header, payload)) {
+            Metrics::recordSince(Metrics::STAGE_PARSE, started);
+            dispatchFrame(fd, conn, header, std::move(payload), started);
+            started = Metrics::now();
+        }
+    } catch (const ProtocolException& e) {
+        // Поток кадров повреждён — синхронизироваться уже не с чем
+        LOG_WARNING(std::string("Closing connection: ") + e.what());
+        closeConnection(fd);
+        return;
+    }
+
+    // Конвейер или очередь отправки заполнены: перестаём читать, пока не уйдут ответы
+    conn.read_paused = !canDispatch(conn) || batchPending(conn);
+}
+
+bool Reactor::canDispatch(const Connection& conn) const {
+    return !conn.blocked_task && conn.in_flight < limits_.max_pipeline &&
+           conn.output.pendingBytes() < limits_.max_output_bytes;
+}
+
+void Reactor::resumeConnections() {
+    // Новые записи, появившиеся по ходу, ждут следующей итерации —
+    // быстрый клиент не удерживает цикл на себе
+    std::vector<std::pair<int, uint64_t>> resumed;
+    resumed.swap(resumed_);
+    for (const auto& entry : resumed) {
+        auto it = connections_.find(entry.first);
+        if (it == connections_.end() || it->second.id != entry.second) continue;
+
+        Connection& conn = it->second;
+        processFrames(entry.first, conn);
+        if (connections_.find(entry.first) == connections_.end()) continue;
+        if (conn.read_paused) {
+            handleWritable(entry.first, conn);
+        } else {
+            handleReadable(entry.first, conn);
+        }
+    }
+}
+
+bool Reactor::submitTask(int fd, Connection& conn, WorkerPool::Task& task, bool may_reject) {
+    if (may_reject && pool_.policy() == WorkerPool::REJECT) {
+        return pool_.submit(std::move(task));
+    }
+    if (pool_.trySubmit(task)) {
+        return true;
+    }
+    // Ждать места в потоке реактора нельзя — остановились бы все его
+    // соединения. Ждёт только это: задача хранится на нём до retryBlocked()
+    conn.blocked_task = std::move(task);
+    blocked_.emplace_back(fd, conn.id);
+    return true;
+}
+
+void Reactor::retryBlocked() {
+    std::vector<std::pair<int, uint64_t>> blocked;
+    blocked.swap(blocked_);
+    for (const auto& entry : blocked) {
+        auto it = connections_.find(entry.first);
+        if (it == connections_.end() || it->second.id != entry.second) continue;
+
+        Connection& conn = it->second;
+        if (!pool_.trySubmit(conn.blocked_task)) {
+            blocked_.push_back(entry);
+            continue;
+        }
+        conn.blocked_task = nullptr;
+        if (conn.mode == MODE_FRAMED) {
+            resumed_.push_back(entry);
+        }
+    }
+}
+
+void Reactor::dispatchRequest(int fd, Connection& conn) {
+    conn.in_flight++;
+    std::string request;
+    request.swap(conn.input);
+    Metrics::add(Metrics::COUNTER_REQUESTS);
+
+    uint64_t id = conn.id;
+    const uint64_t started = Metrics::now();
+    WorkerPool::Task task = [this, fd, id, started, request = std::move(request)]() {
+        Metrics::recordSince(Metrics::STAGE_QUEUE, started);
+        Completion completion{fd, id, Response()};
+        completion.started = started;
+        try {
+            completion.response = handler_(request);
+        } catch (const std::exception& e) {
+            completion.response = Response("ERROR:" + std::string(e.what()));
+        }
+        postCompletion(std::move(completion));
+    };
+
+    if (!submitTask(fd, conn, task)) {
+        LOG_WARNING("Worker queue is full, rejecting request");
+        conn.in_flight--;
+        conn.close_after_write = true;
+        queueOutput(conn, Response("ERROR:Server busy"));
+        handleWritable(fd, conn);
+    }
+}
+
+void Reactor::dispatchFrame(int fd, Connection& conn, const FrameHeader& header,
+                            std::string payload, uint64_t started) {
+    if (header.type == FRAME_STATS) {
+        // Отчёт дешёвый и нужен именно под нагрузкой — отвечаем сразу, без пула
+        try {
+            queueOutput(conn, frame_handler_(header, payload));
+        } catch (const std::exception& e) {
+            FrameHeader error;
+            error.type = FRAME_STATS_REPLY;
+            error.status = STATUS_ERROR;
+            error.request_id = header.request_id;
+            queueOutput(conn, Response(encodeFrame(error, e.what())));
+        }
+        return;
+    }
+
+    if (header.type == FRAME_BATCH) {
+        startBatch(fd, conn, header, payload, started);
+        return;
+    }
+
+    conn.in_flight++;
+    Metrics::add(Metrics::COUNTER_REQUESTS);
+
+    uint64_t id = conn.id;
+    WorkerPool::Task task = [this, fd, id, started, header, payload = std::move(payload)]() {
+        Metrics::recordSince(Metrics::STAGE_QUEUE, started);
+
+        Completion completion{fd, id, Response()};
+        completion.started = started;
+        try {
+            completion.response = frame_handler_(header, payload);
+        } catch (const std::exception& e) {
+            FrameHeader error;
+            error.type = FRAME_IMAGE;
+            error.status = STATUS_ERROR;
+            error.request_id = header.request_id;
+            completion.response = Response(encodeFrame(error, e.what()));
+        }
+        postCompletion(std::move(completion));
+    };
+
+    if (!submitTask(fd, conn, task)) {
+        conn.in_flight--;
+        FrameHeader busy;
+        busy.type = FRAME_IMAGE;
+        busy.status = STATUS_BUSY;
+        busy.request_id = header.request_id;
+        queueOutput(conn, Response(encodeFrame(busy, "Server busy")));
+    }
+}
+
+void Reactor::startBatch(int fd, Connection& conn, const FrameHeader& header,
+                         const std::string& payload, uint64_t started) {
+    FrameHeader end;
+    end.type = FRAME_BATCH_END;
+    end.request_id = header.request_id;
+
+    Batch batch;
+    try {
+        batch.items = decodeBatch(payload, limits_.max_batch_items);
+    } catch (const ProtocolException& e) {
+        end.status = STATUS_ERROR;
+        queueOutput(conn, Response(encodeFrame(end, e.what())));
+        return;
+    }
+    if (batch.items.empty()) {
+        queueOutput(conn, Response(encodeFrame(end, encodeBatchSummary(BatchSummary()))));
+        return;
+    }
+
+    batch.header = header;
+    batch.count = static_cast<uint32_t>(batch.items.size());
+    batch.remaining = batch.count;
+    batch.started = started;
+    conn.batches.emplace(conn.next_batch++, std::move(batch));
+    dispatchBatch(fd, conn);
+}
+
+void Reactor::dispatchBatch(int fd, Connection& conn) {
+    if (!batchPending(conn)) {
+        return;
+    }
+    auto current = std::prev(conn.batches.end());
+    const uint64_t number = current->first;
+    Batch& batch = current->second;
+    const uint64_t id = conn.id;
+
+    while (batch.next < batch.count && canDispatch(conn)) {
+        const uint32_t index = batch.next++;
+        conn.in_flight++;
+        Metrics::add(Metrics::COUNTER_REQUESTS);
+
+        WorkerPool::Task task = [this, fd, id, number, index, header = batch.header,
+                                 item = std::move(batch.items[index])]() {
+            FrameHeader item_header;
+            item_header.type = item.type;
+            item_header.request_id = header.request_id;
+            item_header.flags = header.flags;
+
+            Response response;
+            try {
+                if (item.type != FRAME_TEXT && item.type != FRAME_GEO) {
+                    throw std::runtime_error("Unsupported batch item type " + std::to_string(item.type));
+                }
+                response = frame_handler_(item_header, item.payload);
+            } catch (const std::exception& e) {
+                FrameHeader error;
+                error.status = STATUS_ERROR;
+                error.request_id = header.request_id;
+                response = Response(encodeFrame(error, e.what()));
+            }
+            retagFrame(response.head, FRAME_BATCH_ITEM, index);
+
+            Completion completion{fd, id, std::move(response)};
+            completion.batch = number;
+            postCompletion(std::move(completion));
+        };
+
+        // Отказать можно только пакету целиком, пока ни один его элемент
+        // не отдан; дальше элементы принятого пакета ждут места в пуле
+        if (!submitTask(fd, conn, task, index == 0)) {
+            conn.in_flight--;
+            FrameHeader busy;
+            busy.type = FRAME_BATCH_END;
+            busy.status = STATUS_BUSY;
+            busy.request_id = batch.header.request_id;
+            conn.batches.erase(current);
+            queueOutput(conn, Response(encodeFrame(busy, "Server busy")));
+            return;
+        }
+    }
+
+    if (batch.next == batch.count) {
+        std::vector<BatchItem>().swap(batch.items);
+    }
+}
+
+void Reactor::finishBatchItem(Connection& conn, uint64_t number, bool failed) {
+    auto it = conn.batches.find(number);
+    if (it == conn.batches.end()) {
+        return;
+    }
+    Batch& batch = it->second;
+    if (failed) {
+        batch.failed++;
+    }
+    // Последний ответ закрывает пакет: ответы всех элементов уже в очереди перед ним
+    if (--batch.remaining > 0) {
+        return;
+    }
+
+    FrameHeader end;
+    end.type = FRAME_BATCH_END;
+    end.request_id = batch.header.request_id;
+    BatchSummary summary;
+    summary.count = batch.count;
+    summary.failed = batch.failed;
+    queueOutput(conn, Response(encodeFrame(end, encodeBatchSummary(summary))));
+    Metrics::recordSince(Metrics::STAGE_REQUEST, batch.started);
+    conn.batches.erase(it);
+}
+
+bool Reactor::batchPending(const Connection& conn) {
+    if (conn.batches.empty()) {
+        return false;
+    }
+    const Batch& batch = conn.batches.rbegin()->second;
+    return batch.next < batch.count;
+}
+
+void Reactor::postCompletion(Completion completion) {
+    {
+        std::lock_guard<std::mutex> lock(completions_mutex_);
+        completions_.push_back(std::move(completion));
+    }
+    uint64_t one = 1;
+    if (write(event_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        LOG_ERROR("Failed to signal completion: " + std::string(strerror(errno)));
+    }
+}
+
+void Reactor::drainCompletions() {
+    std::vector<Completion> ready;
+    {
+        std::lock_guard<std::mutex> lock(completions_mutex_);
+        ready.swap(completions_);
+    }
+
+    for (auto& completion : ready) {
+        auto it = connections_.find(completion.fd);
+        // Соединение могло закрыться, а дескриптор — достаться новому клиенту
+        if (it == connections_.end() || it->second.id != completion.id) continue;
+
+        Connection& conn = it->second;
+        conn.in_flight--;
+        if (conn.mode == MODE_LEGACY) {
+            conn.close_after_write = true;
+        }
+        if (completion.batch == 0) {
+            Metrics::recordSince(Metrics::STAGE_REQUEST, completion.started);
+            queueOutput(conn, std::move(completion.response));
+        } else {
+            const bool failed = static_cast<uint8_t>(completion.response.head[3]) != STATUS_OK;
+            queueOutput(conn, std::move(completion.response));
+            finishBatchItem(conn, completion.batch, failed);
+        }
+
+        bool was_paused = conn.read_paused;
+        if (conn.mode == MODE_FRAMED) {
+            // Разбираем кадры, накопленные пока конвейер был заполнен
+            processFrames(completion.fd, conn);
+            if (connections_.find(completion.fd) == connections_.end()) continue;
+        }
+
+        handleWritable(completion.fd, conn);
+        if (connections_.find(completion.fd) == connections_.end()) continue;
+
+        if (was_paused && !conn.read_paused) {
+            handleReadable(completion.fd, conn);
+        }
+    }
+}
+
+void Reactor::queueOutput(Connection& conn, Response response) {
+    // Все ответы проходят здесь: ошибка — статус кадра или префикс текстового ответа
+    const bool error = conn.mode == MODE_FRAMED
+        ? response.head.size() >= FRAME_HEADER_SIZE &&
+              static_cast<uint8_t>(response.head[3]) != STATUS_OK
+        : response.head.compare(0, 6, "ERROR:") == 0;
+    if (error) {
+        Metrics::add(Metrics::COUNTER_ERRORS);
+    }
+    conn.output.push(std::move(response));
+}
+
+void Reactor::handleWritable(int fd, Connection& conn) {
+    SendQueue::FlushResult result = SendQueue::FLUSH_DONE;
+    if (!conn.output.empty()) {
+        const size_t pending = conn.output.pendingBytes();
+        const uint64_t started = Metrics::now();
+        result = conn.output.flush(fd);
+        Metrics::recordSince(Metrics::STAGE_SEND, started);
+        Metrics::add(Metrics::COUNTER_BYTES_SENT, pending - conn.output.pendingBytes());
+
+        // Отправка освободила место: возобновляем чтение не отсюда (handleWritable
+        // вызывается и из handleReadable), а в конце итерации цикла
+        if (conn.read_paused && conn.mode == MODE_FRAMED && canDispatch(conn)) {
+            resumed_.emplace_back(fd, conn.id);
+        }
+    }
+
+    switch (result) {
+    case SendQueue::FLUSH_AGAIN:
+        return;   // допишем по следующему EPOLLOUT
+    case SendQueue::FLUSH_ERROR:
+        closeConnection(fd);
+        return;
+    case SendQueue::FLUSH_DONE:
+        break;
+    }
+
+    if (conn.close_after_write || (conn.read_closed && conn.in_flight == 0 && conn.batches.empty())) {
+        closeConnection(fd);
+    }
+}
+
+void Reactor::closeConnection(int fd) {
+    if (connections_.erase(fd)) {
+        active_connections_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+}
@@ -0,0 +1,195 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "worker_pool.h"
+#include "protocol.h"
+#include "send_queue.h"
+
+/**
+ * Ограничения на соединение
+ */
+struct ReactorLimits {
+    size_t max_request_size = 64 * 1024;        // текстовый запрос, байт
+    size_t max_frame_size = 4 * 1024 * 1024;    // нагрузка одного кадра, байт
+    size_t max_pipeline = 128;                  // запросов соединения, ждущих ответа
+    size_t max_output_bytes = 8 * 1024 * 1024;  // неотправленные ответы соединения, байт
+    size_t max_batch_items = 1024;              // элементов в одном пакете (FRAME_BATCH)
+    int request_timeout_ms = 1000;              // тишина, после которой частичный
+                                                // текстовый запрос считается полным
+                                                // (0 — ждать без срока)
+};
+
+/**
+ * Событийный цикл на epoll (edge-triggered, неблокирующие сокеты).
+ * Один Reactor обслуживает свой слушающий сокет (SO_REUSEPORT позволяет
+ * завести по сокету на каждый поток), читает запросы инкрементально и
+ * отдаёт готовые запросы на вычисление в WorkerPool. Ответ возвращается
+ * в поток реактора через eventfd и отправляется без блокировки.
+ *
+ * Режим соединения определяется по первому байту: текстовый протокол
+ * (один запрос, ответ, закрытие) или бинарные кадры (protocol.h) —
+ * постоянное соединение с конвейерной отправкой запросов.
+ *
+ * Чтение кадрового соединения приостанавливается, пока в пуле
+ * max_pipeline его запросов или пока неотправленные ответы занимают
+ * max_output_bytes: клиент, который шлёт запросы и не читает ответы,
+ * не раздувает память сервера. Элементы пакета отдаются в пул реактором
+ * по одному под теми же ограничениями; пока пакет не роздан целиком,
+ * следующие кадры не разбираются.
+ *
+ * Реактор никогда не ждёт места в очереди пула. При политике REJECT
+ * запрос сверх очереди получает отказ "занято"; при BLOCK задача остаётся
+ * на соединении, его чтение приостанавливается, а постановка повторяется,
+ * пока очередь не освободится.
+ *
+ * Текстовый запрос собирается из любого числа порций чтения. Он
+ * завершён переводом строки в конце принятых данных (один "\n" или
+ * "\r\n" отрезается) либо закрытием клиентом своей стороны. Клиенты,
+ * которые не делают ни того ни другого, получают ответ, когда соединение
+ * молчит request_timeout_ms: пауза короче этого срока запрос не обрезает.
+ */
+class Reactor {
+public:
+    using RequestHandler = std::function<Response(const std::string& request)>;
+    using FrameHandler = std::function<Response(const FrameHeader& header,
+                                                const std::string& payload)>;
+
+    /**
+     * @param listen_fd Слушающий сокет (будет переведён в неблокирующий режим)
+     * @param pool Пул вычислительных потоков
+     * @param handler Обработчик текстового запроса, вызывается в потоках пула
+     * @param frame_handler Обработчик кадра; возвращает готовый кадр ответа.
+     *        Элементы пакета (FRAME_BATCH) приходят в него по одному
+     * @param limits Ограничения на размер запросов и глубину конвейера
+     */
+    Reactor(int listen_fd, WorkerPool& pool, RequestHandler handler,
+            FrameHandler frame_handler, ReactorLimits limits = ReactorLimits());
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    /**
+     * Запускает цикл обработки событий в текущем потоке до вызова stop()
+     */
+    void run();
+
+    /**
+     * Останавливает цикл (можно вызывать из любого потока)
+     */
+    void stop();
+
+    size_t activeConnections() const { return active_connections_.load(std::memory_order_relaxed); }
+
+private:
+    enum Mode {
+        MODE_UNKNOWN,
+        MODE_LEGACY,
+        MODE_FRAMED
+    };
+
+    struct Batch {
+        FrameHeader header;             // request_id и flags пакета
+        std::vector<BatchItem> items;   // очищается, когда все элементы отданы в пул
+        uint32_t count = 0;
+        uint32_t next = 0;              // первый элемент, ещё не отданный в пул
+        uint32_t remaining = 0;         // элементы без ответа
+        uint32_t failed = 0;
+        uint64_t started = 0;           // Metrics::now() при разборе пакета
+    };
+
+    struct Connection {
+        uint64_t id = 0;
+        Mode mode = MODE_UNKNOWN;
+        std::string input;
+        FrameDecoder decoder;
+        SendQueue output;
+        size_t in_flight = 0;           // запросы и элементы пакетов, отданные в пул
+        bool read_paused = false;       // конвейер или очередь отправки заполнены,
+                                        // чтение приостановлено
+        bool read_closed = false;       // клиент закрыл свою сторону
+        bool close_after_write = false;
+        uint64_t request_deadline = 0;  // мс; 0 — частичного текстового запроса нет
+        WorkerPool::Task blocked_task;  // не принята заполненным пулом (BLOCK), ждёт места
+        std::map<uint64_t, Batch> batches;  // неотвеченные пакеты по номеру; раздаётся
+                                            // только последний
+        uint64_t next_batch = 1;
+    };
+
+    struct Deadline {
+        uint64_t at;
+        int fd;
+        uint64_t id;
+    };
+
+    struct Completion {
+        int fd;
+        uint64_t id;
+        Response response;
+        uint64_t batch = 0;             // номер пакета соединения; 0 — не элемент пакета
+        uint64_t started = 0;           // Metrics::now() при разборе запроса
+    };
+
+    void acceptConnections();
+    void handleReadable(int fd, Connection& conn);
+    void handleWritable(int fd, Connection& conn);
+    void processLegacy(int fd, Connection& conn);
+    void expireRequests();
+    int nextTimeout() const;
+    void processFrames(int fd, Connection& conn);
+    bool canDispatch(const Connection& conn) const;
+    void resumeConnections();
+    bool submitTask(int fd, Connection& conn, WorkerPool::Task& task, bool may_reject = true);
+    void retryBlocked();
+    void dispatchRequest(int fd, Connection& conn);
+    void dispatchFrame(int fd, Connection& conn, const FrameHeader& header, std::string payload,
+                       uint64_t started);
+    void startBatch(int fd, Connection& conn, const FrameHeader& header, const std::string& payload,
+                    uint64_t started);
+    void dispatchBatch(int fd, Connection& conn);
+    void finishBatchItem(Connection& conn, uint64_t number, bool failed);
+    static bool batchPending(const Connection& conn);
+    void queueOutput(Connection& conn, Response response);
+    void drainCompletions();
+    void closeConnection(int fd);
+    void postCompletion(Completion completion);
+
+    int listen_fd_;
+    int epoll_fd_;
+    int event_fd_;
+    WorkerPool& pool_;
+    RequestHandler handler_;
+    FrameHandler frame_handler_;
+    ReactorLimits limits_;
+    uint64_t next_id_ = 1;
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> active_connections_{0};
+
+    std::unordered_map<int, Connection> connections_;
+
+    // Сроки частичных текстовых запросов в порядке возрастания (срок у всех
+    // одинаковой длины); устаревшие записи пропускаются при извлечении
+    std::deque<Deadline> deadlines_;
+
+    // Соединения, чья очередь отправки опустела ниже предела при
+    // приостановленном чтении; разбираются в конце итерации цикла
+    std::vector<std::pair<int, uint64_t>> resumed_;
+
+    // Соединения с задачей, которую не принял заполненный пул (BLOCK)
+    std::vector<std::pair<int, uint64_t>> blocked_;
+
+    std::mutex completions_mutex_;
+    std::vector<Completion> completions_;
+};
+
+#endif // REACTOR_H
@@ -0,0 +1,53 @@
+#include "request_parser.h"
+#include <charconv>
+#include <cmath>
+
+namespace {
+
+const std::string_view TEXT_PREFIX = "TEXT:";
+const std::string_view GEO_PREFIX = "GEO:";
+const std::string_view STATS_REQUEST = "STATS";
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// Число целиком, с пробелами по краям и необязательным '+'
+bool parseNumber(std::string_view text, double& value) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    while (begin < end && isSpace(*begin)) begin++;
+    while (end > begin && isSpace(end[-1])) end--;
+    if (begin < end && *begin == '+') {
+        begin++;
+        if (begin < end && *begin == '-') return false;
+    }
+
+    auto result = std::from_chars(begin, end, value, std::chars_format::general);
+    return result.ec == std::errc() && result.ptr == end && std::isfinite(value);
+}
+
+} // namespace
+
+TextRequest parseTextRequest(std::string_view line) {
+    TextRequest request;
+    if (line.compare(0, TEXT_PREFIX.size(), TEXT_PREFIX) == 0) {
+        request.kind = REQUEST_TEXT;
+        request.body = line.substr(TEXT_PREFIX.size());
+    } else if (line.compare(0, GEO_PREFIX.size(), GEO_PREFIX) == 0) {
+        request.kind = REQUEST_GEO;
+        request.body = line.substr(GEO_PREFIX.size());
+    } else if (line == STATS_REQUEST) {
+        request.kind = REQUEST_STATS;
+    }
+    return request;
+}
+
+bool parseCoordinates(std::string_view text, double& latitude, double& longitude) {
+    const size_t comma = text.find(',');
+    if (comma == std::string_view::npos) {
+        return false;
+    }
+    return parseNumber(text.substr(0, comma), latitude) &&
+           parseNumber(text.substr(comma + 1), longitude);
+}
@@ -0,0 +1,46 @@
+#ifndef REQUEST_PARSER_H
+#define REQUEST_PARSER_H
+
+#include <string_view>
+
+/**
+ * Разбор запросов текстового протокола без копий и выделений памяти.
+ *
+ * Строка запроса одна из:
+ *   TEXT:<текст>
+ *   GEO:<широта>,<долгота>
+ *   STATS
+ * Тело возвращается как string_view внутрь исходной строки — она должна
+ * жить, пока используется результат.
+ *
+ * Координаты разбираются std::from_chars: без локали (разделитель дробной
+ * части всегда точка) и без промежуточных строк, в отличие от std::stod.
+ * Вокруг чисел допускаются пробелы, перед числом — знак '+'. Хвост
+ * после числа, inf и nan считаются ошибкой (stod молча отбрасывал хвост
+ * и пропускал nan мимо проверки диапазона).
+ */
+
+enum RequestKind {
+    REQUEST_INVALID,
+    REQUEST_TEXT,
+    REQUEST_GEO,
+    REQUEST_STATS
+};
+
+struct TextRequest {
+    RequestKind kind = REQUEST_INVALID;
+    std::string_view body;   // TEXT — текст, GEO — "широта,долгота"
+};
+
+/**
+ * Определяет вид запроса и выделяет тело после префикса
+ */
+TextRequest parseTextRequest(std::string_view line);
+
+/**
+ * Разбирает "широта,долгота"; диапазоны не проверяет
+ * @return false, если строка не является парой конечных чисел
+ */
+bool parseCoordinates(std::string_view text, double& latitude, double& longitude);
+
+#endif // REQUEST_PARSER_H
@@ -0,0 +1,289 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "logging.h"
+#include "qr_generator.h"
+#include "request_parser.h"
+
+/**
+ * Сверка и бенчмарк разбора запросов текстового протокола: parseTextRequest,
+ * parseCoordinates и formatLocation в буфер против прежнего пути через
+ * substr, std::stod и ostringstream.
+ *
+ * Сверка (фаззинг с фиксированным зерном):
+ *   - канонические координаты с разной точностью и в экспоненциальной
+ *     записи: оба разбора принимают их и дают побитно равные числа;
+ *   - случайные искажения строк (вставка, удаление, замена символов):
+ *     новый разбор не падает, а всё, что он принимает, прежний принимает
+ *     с теми же значениями — новый строже, но не иначе;
+ *   - geo:-URI из случайных и пограничных координат совпадает с выводом
+ *     ostringstream посимвольно.
+ *
+ * Бенчмарк: наносекунд на запрос GEO и TEXT от строки до содержимого
+ * QR-кода.
+ */
+
+namespace {
+
+// Прежний разбор из process_request и parse_geo
+std::string legacyContent(const std::string& request) {
+    if (request.substr(0, 4) == "TEXT") {
+        return request.substr(5);
+    }
+    if (request.find("GEO:") == 0) {
+        std::string coordinates = request.substr(4);
+        size_t comma_pos = coordinates.find(',');
+        if (comma_pos == std::string::npos) {
+            throw std::runtime_error("Invalid GEO format");
+        }
+        double lat = std::stod(coordinates.substr(0, comma_pos));
+        double lon = std::stod(coordinates.substr(comma_pos + 1));
+        if (lat < -90 || lat > 90 || lon < -180 || lon > 180) {
+            throw std::runtime_error("Invalid coordinates");
+        }
+        std::ostringstream location_stream;
+        location_stream << std::fixed << std::setprecision(5);
+        location_stream << "geo:" << lat << "," << lon << "?z=" << 15;
+        return location_stream.str();
+    }
+    throw std::runtime_error("Invalid request format");
+}
+
+bool legacyCoordinates(const std::string& text, double& latitude, double& longitude) {
+    size_t comma = text.find(',');
+    if (comma == std::string::npos) return false;
+    try {
+        latitude = std::stod(text.substr(0, comma));
+        longitude = std::stod(text.substr(comma + 1));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+std::string legacyFormat(double latitude, double longitude) {
+    std::ostringstream location_stream;
+    location_stream << std::fixed << std::setprecision(5);
+    location_stream << "geo:" << latitude << "," << longitude << "?z=" << 15;
+    return location_stream.str();
+}
+
+// Новый путь: от строки запроса до содержимого QR-кода
+size_t newContent(std::string_view request, char* buffer) {
+    const TextRequest parsed = parseTextRequest(request);
+    if (parsed.kind == REQUEST_TEXT) {
+        memcpy(buffer, parsed.body.data(), std::min(parsed.body.size(), size_t(64)));
+        return parsed.body.size();
+    }
+    double lat = 0;
+    double lon = 0;
+    if (parsed.kind != REQUEST_GEO || !parseCoordinates(parsed.body, lat, lon)) {
+        throw std::runtime_error("Invalid request");
+    }
+    return QRGenerator::formatLocation(lat, lon, 15, buffer);
+}
+
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state_(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+    uint64_t next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545F4914F6CDD1Dull;
+    }
+
+    size_t below(size_t bound) { return static_cast<size_t>(next() % bound); }
+    double uniform(double low, double high) { return low + (high - low) * (next() >> 11) * 0x1.0p-53; }
+
+private:
+    uint64_t state_;
+};
+
+std::string canonicalNumber(Rng& rng, double value) {
+    char text[64];
+    if (rng.below(8) == 0) {
+        snprintf(text, sizeof(text), "%.*e", static_cast<int>(rng.below(12)), value);
+    } else {
+        snprintf(text, sizeof(text), "%.*f", static_cast<int>(rng.below(12)), value);
+    }
+    return text;
+}
+
+bool sameBits(double a, double b) {
+    return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+int failures = 0;
+
+void reportFailure(const char* what, const std::string& input) {
+    if (failures++ < 10) {
+        std::printf("MISMATCH %s: \"%s\"\n", what, input.c_str());
+    }
+}
+
+void checkCanonical(Rng& rng, int iterations) {
+    for (int i = 0; i < iterations; i++) {
+        const std::string text = canonicalNumber(rng, rng.uniform(-90, 90)) + "," +
+                                 canonicalNumber(rng, rng.uniform(-180, 180));
+        double lat = 0, lon = 0, old_lat = 0, old_lon = 0;
+        const bool accepted = parseCoordinates(text, lat, lon);
+        if (!accepted || !legacyCoordinates(text, old_lat, old_lon) ||
+            !sameBits(lat, old_lat) || !sameBits(lon, old_lon)) {
+            reportFailure("canonical", text);
+            continue;
+        }
+        // Округление в записи с малой точностью может вывести за диапазон:
+        // тогда оба пути должны отказать
+        std::string actual, expected;
+        try {
+            char buffer[QRGenerator::LOCATION_BUFFER_SIZE];
+            actual.assign(buffer, newContent("GEO:" + text, buffer));
+        } catch (const std::runtime_error&) {}
+        try {
+            expected = legacyContent("GEO:" + text);
+        } catch (const std::runtime_error&) {}
+        if (actual != expected) {
+            reportFailure("canonical content", text);
+        }
+    }
+}
+
+void checkMutations(Rng& rng, int iterations) {
+    static const char ALPHABET[] = "0123456789+-.,eE :\tainfxTEXGO";
+    int accepted = 0;
+    for (int i = 0; i < iterations; i++) {
+        std::string text = canonicalNumber(rng, rng.uniform(-90, 90)) + "," +
+                           canonicalNumber(rng, rng.uniform(-180, 180));
+        const int edits = 1 + static_cast<int>(rng.below(3));
+        for (int e = 0; e < edits; e++) {
+            const size_t pos = rng.below(text.size() + 1);
+            const char c = ALPHABET[rng.below(sizeof(ALPHABET) - 1)];
+            switch (rng.below(3)) {
+                case 0: text.insert(pos, 1, c); break;
+                case 1: if (pos < text.size()) text.erase(pos, 1); break;
+                default: if (pos < text.size()) text[pos] = c; break;
+            }
+        }
+
+        double lat = 0, lon = 0, old_lat = 0, old_lon = 0;
+        if (!parseCoordinates(text, lat, lon)) continue;
+        accepted++;
+        // Пробелы в конце числа stod не смущают, '+' тоже: сравнение честное
+        if (!legacyCoordinates(text, old_lat, old_lon) || !sameBits(lat, old_lat) ||
+            !sameBits(lon, old_lon) || !std::isfinite(lat) || !std::isfinite(lon)) {
+            reportFailure("mutation", text);
+        }
+    }
+    std::printf("mutations: %d inputs, %d accepted by both\n", iterations, accepted);
+
+    // Строки запроса: префиксы, обрывы и мусор; для GEO — принимаются ли координаты
+    static const struct {
+        const char* line;
+        RequestKind kind;
+        bool coordinates;
+    } LINES[] = {
+        {"", REQUEST_INVALID, false},          {"T", REQUEST_INVALID, false},
+        {"TEXT", REQUEST_INVALID, false},      {"TEXT:", REQUEST_TEXT, false},
+        {"TEXT:abc", REQUEST_TEXT, false},     {"TEXTabc", REQUEST_INVALID, false},
+        {"STATS", REQUEST_STATS, false},       {"STATSx", REQUEST_INVALID, false},
+        {"geo:1,2", REQUEST_INVALID, false},   {"GEO:", REQUEST_GEO, false},
+        {"GEO:1,2", REQUEST_GEO, true},        {"GEO: 1 , +2 ", REQUEST_GEO, true},
+        {"GEO:,", REQUEST_GEO, false},         {"GEO:1,", REQUEST_GEO, false},
+        {"GEO:,2", REQUEST_GEO, false},        {"GEO:1,2,3", REQUEST_GEO, false},
+        {"GEO:1 2,3", REQUEST_GEO, false},     {"GEO:nan,0", REQUEST_GEO, false},
+        {"GEO:inf,0", REQUEST_GEO, false},     {"GEO:0x10,0", REQUEST_GEO, false},
+        {"GEO:+-1,0", REQUEST_GEO, false},     {"GEO:1e400,0", REQUEST_GEO, false},
+        {"GEO:1e,0", REQUEST_GEO, false},      {"GEO:.5,5.", REQUEST_GEO, true},
+    };
+    for (const auto& c : LINES) {
+        const TextRequest parsed = parseTextRequest(c.line);
+        double lat = 0, lon = 0;
+        const bool coordinates = parsed.kind == REQUEST_GEO && parseCoordinates(parsed.body, lat, lon);
+        if (parsed.kind != c.kind || coordinates != c.coordinates) {
+            reportFailure("request line", c.line);
+        }
+    }
+}
+
+void checkFormat(Rng& rng, int iterations) {
+    std::vector<std::pair<double, double>> cases = {
+        {0.0, 0.0}, {-0.0, -0.0}, {-0.000004, 0.000004}, {-0.000005, 0.000005},
+        {90, 180}, {-90, -180}, {89.999995, 179.999995}, {55.7558, 37.6173},
+        {12.345675, -12.345675}, {1e-300, -1e-300}};
+    for (int i = 0; i < iterations; i++) {
+        cases.push_back({rng.uniform(-90, 90), rng.uniform(-180, 180)});
+        // Ровно посередине между соседними пятизначными значениями
+        cases.push_back({(static_cast<double>(rng.below(18000000)) - 9000000 + 0.5) / 1e5,
+                         (static_cast<double>(rng.below(36000000)) - 18000000 + 0.5) / 1e5});
+    }
+    for (const auto& c : cases) {
+        char buffer[QRGenerator::LOCATION_BUFFER_SIZE];
+        const size_t length = QRGenerator::formatLocation(c.first, c.second, 15, buffer);
+        const std::string expected = legacyFormat(c.first, c.second);
+        if (std::string(buffer, length) != expected || buffer[length] != '\0') {
+            reportFailure("format", expected);
+        }
+    }
+    std::printf("format: %zu coordinate pairs\n", cases.size());
+}
+
+template <typename Body>
+double nanosecondsPer(Body body) {
+    const auto start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    do {
+        for (int i = 0; i < 64; i++) body(count + i);
+        count += 64;
+    } while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(300));
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+           count;
+}
+
+void benchmark() {
+    Rng rng(7);
+    std::vector<std::string> geo;
+    std::vector<std::string> text;
+    for (int i = 0; i < 1024; i++) {
+        char line[96];
+        snprintf(line, sizeof(line), "GEO:%.6f,%.6f", rng.uniform(-90, 90), rng.uniform(-180, 180));
+        geo.push_back(line);
+        text.push_back("TEXT:https://example.com/item/" + std::to_string(rng.below(1000000)));
+    }
+
+    size_t sink = 0;
+    char buffer[QRGenerator::LOCATION_BUFFER_SIZE + 64];
+    const double geo_old = nanosecondsPer([&](size_t i) { sink += legacyContent(geo[i & 1023]).size(); });
+    const double geo_new = nanosecondsPer([&](size_t i) { sink += newContent(geo[i & 1023], buffer); });
+    const double text_old = nanosecondsPer([&](size_t i) { sink += legacyContent(text[i & 1023]).size(); });
+    const double text_new = nanosecondsPer([&](size_t i) { sink += newContent(text[i & 1023], buffer); });
+
+    std::printf("\n%-6s %12s %12s %9s\n", "", "legacy ns", "new ns", "speedup");
+    std::printf("%-6s %12.1f %12.1f %8.1fx\n", "GEO", geo_old, geo_new, geo_old / geo_new);
+    std::printf("%-6s %12.1f %12.1f %8.1fx\n", "TEXT", text_old, text_new, text_old / text_new);
+    if (sink == 0) std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    Logger::setLevel(Logger::ERROR);
+
+    Rng rng(1);
+    checkCanonical(rng, iterations);
+    checkMutations(rng, iterations);
+    checkFormat(rng, iterations / 10);
+    std::printf("cross-check: %d mismatches\n", failures);
+
+    benchmark();
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
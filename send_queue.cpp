@@ -0,0 +1,91 @@
+#include "send_queue.h"
+#include <cerrno>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace {
+
+const size_t MAX_IOV = 64;
+
+bool use_sendfile(const SharedBytes& body) {
+    return body.file_fd >= 0 && body.size >= SendQueue::SENDFILE_MIN_BYTES;
+}
+
+} // namespace
+
+void SendQueue::push(Response response) {
+    if (response.size() == 0) {
+        return;
+    }
+    pending_bytes_ += response.size();
+    responses_.push_back(std::move(response));
+}
+
+SendQueue::FlushResult SendQueue::flush(int fd) {
+    while (!responses_.empty()) {
+        iovec iov[MAX_IOV];
+        size_t count = 0;
+        size_t skip = offset_;
+        const SharedBytes* file_body = nullptr;   // тело для sendfile, если оно первое в очереди
+
+        for (auto it = responses_.begin(); it != responses_.end() && count + 2 <= MAX_IOV; ++it) {
+            const char* parts[2] = {it->head.data(), it->body.data};
+            size_t sizes[2] = {it->head.size(), it->body.size};
+            bool stop = false;
+            for (int i = 0; i < 2; i++) {
+                if (skip >= sizes[i]) {
+                    skip -= sizes[i];
+                    continue;
+                }
+                if (i == 1 && use_sendfile(it->body)) {
+                    // Тело из файла обрывает сборку iovec: сначала уходит то,
+                    // что перед ним, затем оно само отдельным sendfile
+                    if (count == 0) file_body = &it->body;
+                    stop = true;
+                    break;
+                }
+                iov[count].iov_base = const_cast<char*>(parts[i] + skip);
+                iov[count].iov_len = sizes[i] - skip;
+                skip = 0;
+                count++;
+            }
+            if (stop) break;
+        }
+
+        ssize_t n;
+        if (file_body) {
+            off_t file_offset = static_cast<off_t>(file_body->file_offset + skip);
+            n = sendfile(fd, file_body->file_fd, &file_offset, file_body->size - skip);
+        } else {
+            msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = count;
+            n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return FLUSH_AGAIN;
+            return FLUSH_ERROR;
+        }
+        if (n == 0 && file_body) {
+            return FLUSH_ERROR;   // файл короче, чем обещано
+        }
+        consume(static_cast<size_t>(n));
+    }
+    return FLUSH_DONE;
+}
+
+void SendQueue::consume(size_t bytes) {
+    pending_bytes_ -= bytes;
+    while (bytes > 0 && !responses_.empty()) {
+        size_t left = responses_.front().size() - offset_;
+        if (bytes < left) {
+            offset_ += bytes;
+            return;
+        }
+        bytes -= left;
+        offset_ = 0;
+        responses_.pop_front();
+    }
+}
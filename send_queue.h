@@ -0,0 +1,87 @@
+#ifndef SEND_QUEUE_H
+#define SEND_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+/**
+ * Неизменяемый участок памяти с общим владением: строка из кэша,
+ * отображённый в память файл и т. п. Копирование — только счётчик ссылок.
+ */
+struct SharedBytes {
+    std::shared_ptr<const void> owner;
+    const char* data = nullptr;
+    size_t size = 0;
+    // Если те же байты лежат в файле (архив изображений): дескриптор и
+    // смещение. Большие тела тогда отправляются через sendfile.
+    int file_fd = -1;
+    uint64_t file_offset = 0;
+
+    static SharedBytes fromString(std::shared_ptr<const std::string> str) {
+        SharedBytes bytes;
+        if (str) {
+            bytes.data = str->data();
+            bytes.size = str->size();
+            bytes.owner = std::move(str);
+        }
+        return bytes;
+    }
+};
+
+/**
+ * Ответ клиенту: небольшой собственный заголовок ("QRCODE:", заголовок
+ * кадра, текст ошибки) и необязательное тело с общим владением.
+ * Тело не копируется ни при сборке ответа, ни при отправке.
+ */
+struct Response {
+    std::string head;
+    SharedBytes body;
+
+    Response() = default;
+    explicit Response(std::string head_) : head(std::move(head_)) {}
+    Response(std::string head_, SharedBytes body_)
+        : head(std::move(head_)), body(std::move(body_)) {}
+
+    size_t size() const { return head.size() + body.size; }
+};
+
+/**
+ * Очередь ответов соединения. Отправка идёт через sendmsg со списком
+ * iovec (как writev, но с MSG_NOSIGNAL): заголовки и тела нескольких
+ * ответов уходят одним системным вызовом без склейки в общий буфер.
+ * Частичная запись и EAGAIN продолжаются со смещения при следующем flush.
+ *
+ * Тело из файла не короче SENDFILE_MIN_BYTES отправляется отдельным
+ * sendfile: ядро берёт страницы прямо из page cache. Мелкие тела выгоднее
+ * отправлять пачкой через sendmsg из отображённой памяти — вызов на
+ * каждый ответ обошёлся бы дороже копирования.
+ */
+class SendQueue {
+public:
+    enum FlushResult {
+        FLUSH_DONE,     // всё отправлено
+        FLUSH_AGAIN,    // буфер сокета заполнен, ждём EPOLLOUT
+        FLUSH_ERROR     // соединение разорвано
+    };
+
+    static const size_t SENDFILE_MIN_BYTES = 16 * 1024;
+
+    void push(Response response);
+
+    FlushResult flush(int fd);
+
+    bool empty() const { return responses_.empty(); }
+    size_t pendingBytes() const { return pending_bytes_; }
+
+private:
+    void consume(size_t bytes);
+
+    std::deque<Response> responses_;
+    size_t offset_ = 0;         // уже отправлено из первого ответа
+    size_t pending_bytes_ = 0;
+};
+
+#endif // SEND_QUEUE_H
@@ -1,97 +1,344 @@
 #include <iostream>
 #include <string>
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
 #include <thread>
-#include <mutex>
 #include <vector>
+#include <string_view>
+#include <csignal>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include "qr_generator.h"
+#include "worker_pool.h"
+#include "reactor.h"
+#include "protocol.h"
+#include "qr_cache.h"
+#include "qr_archive.h"
+#include "metrics.h"
+#include "request_parser.h"
+#include "command_line.h"
 
-std::mutex qr_mutex;
-const int PORT = 8080;
+struct ServerConfig {
+    int port = 8080;
+    int backlog = 128;                 // очередь ожидающих соединений в listen()
+    size_t workers = 0;                // 0 — по числу ядер
+    size_t queue_capacity = 1024;      // принятые, но ещё не обработанные запросы
+    WorkerPool::OverflowPolicy overflow = WorkerPool::REJECT;
+    size_t reactors = 1;               // потоки epoll, у каждого свой сокет (SO_REUSEPORT)
+    ReactorLimits limits;
+    size_t cache_bytes = 64 * 1024 * 1024;   // бюджет кэша изображений (0 — выключен)
+    size_t log_queue = 8192;                 // 0 — синхронная запись журнала
+    Logger::OverflowPolicy log_overflow = Logger::DROP;
+    Logger::LogLevel log_level = Logger::INFO;
+    QRGenerator::Backend backend = QRGenerator::BACKEND_LIBQRENCODE;
+    RasterOptions raster = {4, 4, 1};        // масштаб, светлое поле, бит на пиксель
+    PNGWriter::Compression png_compression = PNGWriter::COMPRESSION_FAST;
+    std::string archive;                     // архив заранее сгенерированных изображений (qr_batch)
+    bool metrics = true;                     // гистограммы стадий и счётчики для STATS
+};
 
-void handle_client(int client_socket) {
-    char buffer[1024] = {0};
-    int bytes_read = read(client_socket, buffer, sizeof(buffer)-1);
-    
-    if (bytes_read <= 0) {
-        close(client_socket);
-        return;
+static std::unique_ptr<QRCache> image_cache;
+static RasterOptions raster_options;
+static std::shared_ptr<const ArchiveReader> image_archive;
+
+// Источники показателей для отчёта STATS; заполняются в main до запуска реакторов
+static WorkerPool* worker_pool = nullptr;
+static std::vector<Reactor*> reactor_list;
+static std::chrono::steady_clock::time_point started_at;
+
+static void print_usage(const char* prog) {
+    std::cout << "Usage: " << prog << " [--port N] [--backlog N] [--workers N]"
+              << " [--queue N] [--overflow reject|block] [--reactors N]"
+              << " [--max-frame BYTES] [--pipeline N] [--max-output BYTES]"
+              << " [--max-batch N] [--request-timeout MS]"
+              << " [--cache-bytes BYTES]"
+              << " [--log-queue N] [--log-overflow drop|block]"
+              << " [--log-level debug|info|warning|error]"
+              << " [--backend libqrencode|native]"
+              << " [--scale N] [--margin N] [--bit-depth 1|8]"
+              << " [--png-compression store|fast|best] [--archive FILE]"
+              << " [--metrics 0|1]" << std::endl;
+}
+
+static ServerConfig parse_args(int argc, char* argv[]) {
+    ServerConfig config;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                print_usage(argv[0]);
+                exit(EXIT_SUCCESS);
+            }
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg);
+            }
+            std::string value = argv[++i];
+            if (arg == "--port") {
+                config.port = parseNumber(arg, value, 1, 65535);
+            } else if (arg == "--backlog") {
+                config.backlog = parseNumber(arg, value, 1, INT_MAX);
+            } else if (arg == "--workers") {
+                config.workers = parseNumber(arg, value, 0);
+            } else if (arg == "--queue") {
+                config.queue_capacity = parseNumber(arg, value, 1);
+            } else if (arg == "--overflow") {
+                config.overflow = parseChoice(arg, value, "reject", "block")
+                    ? WorkerPool::BLOCK : WorkerPool::REJECT;
+            } else if (arg == "--reactors") {
+                config.reactors = parseNumber(arg, value, 1);
+            } else if (arg == "--max-frame") {
+                config.limits.max_frame_size = parseNumber(arg, value, 1);
+            } else if (arg == "--pipeline") {
+                config.limits.max_pipeline = parseNumber(arg, value, 1);
+            } else if (arg == "--max-output") {
+                config.limits.max_output_bytes = parseNumber(arg, value, 1);
+            } else if (arg == "--max-batch") {
+                config.limits.max_batch_items = parseNumber(arg, value, 1, UINT32_MAX);
+            } else if (arg == "--request-timeout") {
+                config.limits.request_timeout_ms = parseNumber(arg, value, 0, INT_MAX);
+            } else if (arg == "--cache-bytes") {
+                config.cache_bytes = parseNumber(arg, value, 0);
+            } else if (arg == "--log-queue") {
+                config.log_queue = parseNumber(arg, value, 0);
+            } else if (arg == "--log-overflow") {
+                config.log_overflow = parseChoice(arg, value, "drop", "block")
+                    ? Logger::BLOCK : Logger::DROP;
+            } else if (arg == "--log-level") {
+                config.log_level = Logger::parseLevel(value);
+            } else if (arg == "--backend") {
+                config.backend = QRGenerator::parseBackend(value);
+            } else if (arg == "--scale") {
+                config.raster.scale = parseNumber(arg, value, 1, INT_MAX);
+            } else if (arg == "--margin") {
+                config.raster.margin = parseNumber(arg, value, 0, INT_MAX);
+            } else if (arg == "--bit-depth") {
+                config.raster.bit_depth = parseNumber(arg, value, 1, INT_MAX);
+            } else if (arg == "--png-compression") {
+                config.png_compression = PNGWriter::parseCompression(value);
+            } else if (arg == "--archive") {
+                config.archive = value;
+            } else if (arg == "--metrics") {
+                config.metrics = parseNumber(arg, value, 0, 1) != 0;
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+
+        QRRaster::validate(config.raster);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
     }
-    
-    std::string request(buffer, bytes_read);
+    return config;
+}
+
+// Разбирает "широта,долгота" и возвращает содержимое QR-кода (geo:-URI)
+static std::string parse_geo(std::string_view coordinates) {
+    double lat = 0;
+    double lon = 0;
+    if (!parseCoordinates(coordinates, lat, lon)) {
+        LOG_ERROR("Invalid GEO format in request: " + std::string(coordinates));
+        throw std::runtime_error("Invalid GEO format");
+    }
+
+    LOG_DEBUG("Parsed coordinates: lat=" + std::to_string(lat) + 
+             " lon=" + std::to_string(lon));
+
+    char location[QRGenerator::LOCATION_BUFFER_SIZE];
+    return std::string(location, QRGenerator::formatLocation(lat, lon, 15, location));
+}
+
+// Параметры кодирования из flags кадра; проверяет их кодировщик
+static EncodeOptions encode_options(const ImageFlags& flags) {
+    EncodeOptions options;
+    options.level = static_cast<QREncoder::ECLevel>(flags.ec_level);
+    options.mask = flags.mask == 0 ? QREncoder::AUTO_MASK : flags.mask - 1;
+    options.optimize_segments = !flags.byte_mode;
+    if (flags.min_version != 0) options.min_version = flags.min_version;
+    if (flags.max_version != 0) options.max_version = flags.max_version;
+    return options;
+}
+
+// Возвращает изображение для запроса TEXT/GEO: из архива, из кэша либо
+// генерирует и кэширует
+static SharedBytes render_image(uint8_t type, std::string_view payload,
+                                    QROutput::Format format = QROutput::FORMAT_PNG,
+                                    const EncodeOptions& encoding = EncodeOptions()) {
+    std::string content;
+    if (type == FRAME_TEXT) {
+        content.assign(payload.data(), payload.size());
+    } else if (type == FRAME_GEO) {
+        content = parse_geo(payload);
+    } else {
+        throw std::runtime_error("Unknown request type " + std::to_string(type));
+    }
+
+    std::string options = QRGenerator::renderKey(raster_options, format, encoding);
+
+    // Архив собран с одним набором параметров; остальные запросы — мимо него
+    if (image_archive && options == image_archive->options()) {
+        if (const ArchiveEntry* entry = image_archive->find(content)) {
+            SharedBytes bytes;
+            bytes.owner = image_archive;
+            bytes.data = image_archive->data(*entry);
+            bytes.size = entry->data_length;
+            bytes.file_fd = image_archive->fd();
+            bytes.file_offset = entry->data_offset;
+            Metrics::add(Metrics::COUNTER_ARCHIVE_HITS);
+            return bytes;
+        }
+        LOG_DEBUG("Archive miss for: " + content);
+    }
+
+    // Одновременные одинаковые запросы ждут одну генерацию и делят её буфер
+    bool coalesced = false;
+    QRCache::Buffer image = image_cache->getOrCreate(
+        QRCache::makeKey(content, options),
+        [&]() {
+            return std::make_shared<const std::string>(
+                QRGenerator::generateQRImage(content, raster_options, format, encoding));
+        },
+        &coalesced);
+    if (coalesced) {
+        LOG_DEBUG("Coalesced with in-flight generation for: " + content);
+    }
+    return SharedBytes::fromString(std::move(image));
+}
+
+// Текстовый отчёт для запроса STATS: состояние сервера и метрики стадий
+static std::string stats_report() {
+    size_t connections = 0;
+    for (const Reactor* reactor : reactor_list) {
+        connections += reactor->activeConnections();
+    }
+    const QRCache::Stats cache = image_cache->stats();
+    const uint64_t lookups = cache.hits + cache.misses;
+    const double uptime = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - started_at).count();
+
+    char line[512];
+    snprintf(line, sizeof(line),
+             "uptime_seconds %.1f\n"
+             "active_connections %zu\n"
+             "queue_depth %zu\n"
+             "workers %zu\n"
+             "rejected %llu\n"
+             "cache_hits %llu\n"
+             "cache_misses %llu\n"
+             "cache_hit_rate %.4f\n"
+             "cache_evictions %llu\n"
+             "cache_entries %llu\n"
+             "cache_bytes %llu\n"
+             "coalesced %llu\n"
+             "in_flight %llu\n"
+             "metrics_enabled %d\n",
+             uptime, connections, worker_pool->queueDepth(), worker_pool->workerCount(),
+             static_cast<unsigned long long>(worker_pool->rejectedCount()),
+             static_cast<unsigned long long>(cache.hits),
+             static_cast<unsigned long long>(cache.misses),
+             lookups ? static_cast<double>(cache.hits) / lookups : 0.0,
+             static_cast<unsigned long long>(cache.evictions),
+             static_cast<unsigned long long>(cache.entries),
+             static_cast<unsigned long long>(cache.bytes),
+             static_cast<unsigned long long>(cache.coalesced),
+             static_cast<unsigned long long>(cache.in_flight), Metrics::enabled() ? 1 : 0);
+    return line + Metrics::format(Metrics::snapshot());
+}
+
+Response process_request(const std::string& request) {
     LOG_INFO("Received request: " + request);
     
-    QRGenerator qr_gen;
-    std::string response;
+    Response response;
     
     try {
-        std::lock_guard<std::mutex> lock(qr_mutex);
-        
-        if (request.substr(0, 4) == "TEXT") {
-            std::string text = request.substr(5);
-            qr_gen.generateQR(text);
-            response = "QRCODE:" + qr_gen.getQRImage();
+        const TextRequest parsed = parseTextRequest(request);
+        if (parsed.kind == REQUEST_STATS) {
+            response = Response("STATS:" + stats_report());
+        }
+        else if (parsed.kind == REQUEST_TEXT) {
+            response = Response("QRCODE:", render_image(FRAME_TEXT, parsed.body));
         } 
-        else if (request.find("GEO:") == 0) {
-            size_t comma_pos = request.find(',', 4);
-            if (comma_pos == std::string::npos) {
-                LOG_ERROR("Invalid GEO format in request: " + request);
-                throw std::runtime_error("Invalid GEO format");
-            }
-            
-            std::string lat_str = request.substr(4, comma_pos - 4);
-            std::string lon_str = request.substr(comma_pos + 1);
-            
-            LOG_DEBUG("Parsing coordinates: lat_str=" + lat_str + " lon_str=" + lon_str);
-            
-            double lat = std::stod(lat_str);
-            double lon = std::stod(lon_str);
-            
-            LOG_DEBUG("Parsed coordinates: lat=" + std::to_string(lat) + 
-                     " lon=" + std::to_string(lon));
-            
-            qr_gen.generateLocationQR(lat, lon);
-            response = "QRCODE:" + qr_gen.getQRImage();
+        else if (parsed.kind == REQUEST_GEO) {
+            response = Response("QRCODE:", render_image(FRAME_GEO, parsed.body));
         } 
         else {
             LOG_WARNING("Invalid request format: " + request);
-            response = "ERROR:Invalid request format";
+            response = Response("ERROR:Invalid request format");
         }
     } catch (const std::exception& e) {
         LOG_ERROR("Request processing error: " + std::string(e.what()));
-        response = "ERROR:" + std::string(e.what());
+        response = Response("ERROR:" + std::string(e.what()));
     }
     
-    send(client_socket, response.c_str(), response.size(), 0);
-    close(client_socket);
+    return response;
 }
 
-int main() {
-    Logger::getInstance().init("server.log");
-    LOG_INFO("Starting QR code server on port " + std::to_string(PORT));
+Response process_frame(const FrameHeader& header, const std::string& payload) {
+    LOG_INFO("Received frame #" + std::to_string(header.request_id) +
+             " type=" + std::to_string(header.type));
+
+    FrameHeader reply;
+    reply.request_id = header.request_id;
+    if (header.type == FRAME_STATS) {
+        reply.type = FRAME_STATS_REPLY;
+        return Response(encodeFrame(reply, stats_report()));
+    }
+
+    reply.type = FRAME_IMAGE;
+    const ImageFlags flags = decodeImageFlags(header.flags);
+    reply.flags = flags.format;
 
-    int server_fd, new_socket;
+    try {
+        SharedBytes image = render_image(header.type, payload,
+                                         static_cast<QROutput::Format>(flags.format),
+                                         encode_options(flags));
+        reply.length = static_cast<uint32_t>(image.size);
+        std::string head(FRAME_HEADER_SIZE, '\0');
+        encodeFrameHeader(reply, &head[0]);
+        return Response(std::move(head), std::move(image));
+    } catch (const std::exception& e) {
+        LOG_ERROR("Request processing error: " + std::string(e.what()));
+        reply.status = STATUS_ERROR;
+        return Response(encodeFrame(reply, e.what()));
+    }
+}
+
+static int create_listen_socket(const ServerConfig& config) {
+    int server_fd;
     struct sockaddr_in address;
     int opt = 1;
-    int addrlen = sizeof(address);
     
-    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
+    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
         LOG_ERROR("Socket creation failed");
         perror("socket failed");
         exit(EXIT_FAILURE);
     }
     
-    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt))) {
-        LOG_ERROR("Setsockopt failed");
-        perror("setsockopt");
+    // Это имена опций, а не флаги: каждую включаем своим вызовом
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        LOG_ERROR("Setsockopt(SO_REUSEADDR) failed");
+        perror("setsockopt(SO_REUSEADDR)");
+        exit(EXIT_FAILURE);
+    }
+    // SO_REUSEPORT даёт каждому реактору свой сокет на том же порту. С одним
+    // реактором он не нужен: второй сервер, запущенный по ошибке на том же
+    // порту, должен получить EADDRINUSE, а не половину соединений
+    if (config.reactors > 1 &&
+        setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        LOG_ERROR("Setsockopt(SO_REUSEPORT) failed");
+        perror("setsockopt(SO_REUSEPORT)");
         exit(EXIT_FAILURE);
     }
     
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(PORT);
+    address.sin_port = htons(config.port);
     
     if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
         LOG_ERROR("Bind failed");
@@ -99,28 +346,74 @@ int main() {
         exit(EXIT_FAILURE);
     }
     
-    if (listen(server_fd, 3) < 0) {
+    if (listen(server_fd, config.backlog) < 0) {
         LOG_ERROR("Listen failed");
         perror("listen");
         exit(EXIT_FAILURE);
     }
-    
-    std::cout << "Server started on port " << PORT << std::endl;
-    std::vector<std::thread> threads;
-    
-    while (true) {
-        if ((new_socket = accept(server_fd, (struct sockaddr *)&address, (socklen_t*)&addrlen)) < 0) {
-            LOG_ERROR("Accept failed");
-            perror("accept");
-            continue;
+    return server_fd;
+}
+
+int main(int argc, char* argv[]) {
+    ServerConfig config = parse_args(argc, argv);
+
+    Logger::getInstance().init("server.log");
+    Logger::setLevel(config.log_level);
+    if (config.log_queue > 0) {
+        Logger::getInstance().startAsync(config.log_queue, config.log_overflow);
+    }
+    LOG_INFO("Starting QR code server on port " + std::to_string(config.port));
+
+    QRGenerator::setBackend(config.backend);
+    QRGenerator::setPngCompression(config.png_compression);
+    raster_options = config.raster;
+    image_cache.reset(new QRCache(config.cache_bytes));
+    Metrics::setEnabled(config.metrics);
+    started_at = std::chrono::steady_clock::now();
+    if (!config.archive.empty()) {
+        try {
+            image_archive = std::make_shared<const ArchiveReader>(config.archive);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            exit(EXIT_FAILURE);
         }
-        
-        threads.emplace_back(handle_client, new_socket);
+        std::string defaults = QRGenerator::renderKey(raster_options, QROutput::FORMAT_PNG,
+                                                      EncodeOptions());
+        if (image_archive->options() != defaults) {
+            LOG_WARNING("Archive " + config.archive + " built with " + image_archive->options() +
+                        ", server defaults are " + defaults +
+                        ": only requests with matching parameters are served from it");
+        }
+    }
+    // Ответы из архива уходят через sendfile, у которого нет MSG_NOSIGNAL
+    signal(SIGPIPE, SIG_IGN);
+    WorkerPool pool(config.workers, config.queue_capacity, config.overflow);
+    worker_pool = &pool;
+
+    // Каждый реактор слушает собственный сокет на том же порту,
+    // ядро распределяет входящие соединения между ними (SO_REUSEPORT)
+    std::vector<std::unique_ptr<Reactor>> reactors;
+    for (size_t i = 0; i < config.reactors; i++) {
+        reactors.emplace_back(new Reactor(create_listen_socket(config), pool,
+                                          process_request, process_frame, config.limits));
+        reactor_list.push_back(reactors.back().get());
     }
     
-    for (auto& t : threads) {
+    std::cout << "Server started on port " << config.port << std::endl;
+
+    std::vector<std::thread> reactor_threads;
+    for (size_t i = 1; i < reactors.size(); i++) {
+        reactor_threads.emplace_back(&Reactor::run, reactors[i].get());
+    }
+    reactors[0]->run();
+
+    for (auto& reactor : reactors) {
+        reactor->stop();
+    }
+    for (auto& t : reactor_threads) {
         if (t.joinable()) t.join();
     }
-    
+    // Пул останавливаем до реакторов: задачи отправляют ответы в реактор
+    pool.shutdown();
     return 0;
 }
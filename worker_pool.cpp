@@ -0,0 +1,56 @@
+#include "worker_pool.h"
+#include "logging.h"
+
+WorkerPool::WorkerPool(size_t workers, size_t queue_capacity,
+                       OverflowPolicy policy,
+                       std::chrono::milliseconds block_timeout)
+    : queue_(queue_capacity), policy_(policy), block_timeout_(block_timeout) {
+    if (workers == 0) {
+        workers = std::thread::hardware_concurrency();
+        if (workers == 0) workers = 1;
+    }
+
+    workers_.reserve(workers);
+    for (size_t i = 0; i < workers; i++) {
+        workers_.emplace_back(&WorkerPool::workerLoop, this);
+    }
+    LOG_INFO("Worker pool started: " + std::to_string(workers) + " workers, queue capacity " +
+             std::to_string(queue_.capacity()));
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+bool WorkerPool::submit(Task task) {
+    bool accepted = (policy_ == BLOCK)
+        ? queue_.push(std::move(task), block_timeout_)
+        : queue_.tryPush(std::move(task));
+    if (!accepted) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return accepted;
+}
+
+bool WorkerPool::trySubmit(Task& task) {
+    return queue_.tryPush(std::move(task));
+}
+
+void WorkerPool::shutdown() {
+    queue_.close();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void WorkerPool::workerLoop() {
+    Task task;
+    while (queue_.pop(task)) {
+        try {
+            task();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Worker task failed: " + std::string(e.what()));
+        }
+        task = nullptr;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+
+/**
+ * Фиксированный пул рабочих потоков, который питается из ограниченной очереди
+ */
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    enum OverflowPolicy {
+        REJECT,   // сразу отказывать, если очередь заполнена
+        BLOCK     // ждать освобождения места (submit — не дольше block_timeout)
+    };
+
+    /**
+     * @param workers Число рабочих потоков (0 — по числу ядер)
+     * @param queue_capacity Максимальное число ожидающих задач
+     * @param policy Поведение при переполнении очереди
+     * @param block_timeout Сколько ждать места в режиме BLOCK
+     */
+    WorkerPool(size_t workers, size_t queue_capacity,
+               OverflowPolicy policy = REJECT,
+               std::chrono::milliseconds block_timeout = std::chrono::milliseconds(100));
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Ставит задачу в очередь
+     * @return false, если очередь переполнена и задача не принята
+     */
+    bool submit(Task task);
+
+    /**
+     * Ставит задачу в очередь, не ожидая места независимо от политики —
+     * для потоков, которым блокироваться нельзя (реактор, задачи самого пула).
+     * Отказ не учитывается в rejectedCount: решение принимает вызывающий
+     * @param task Перемещается в очередь только при успехе
+     * @return false, если очередь заполнена
+     */
+    bool trySubmit(Task& task);
+
+    /**
+     * Останавливает приём задач и дожидается завершения уже принятых
+     */
+    void shutdown();
+
+    size_t queueDepth() const { return queue_.size(); }
+    size_t workerCount() const { return workers_.size(); }
+    OverflowPolicy policy() const { return policy_; }
+    uint64_t rejectedCount() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    void workerLoop();
+
+    BoundedQueue<Task> queue_;
+    OverflowPolicy policy_;
+    std::chrono::milliseconds block_timeout_;
+    std::vector<std::thread> workers_;
+    std::atomic<uint64_t> rejected_{0};
+};
+
+#endif // WORKER_POOL_H